@@ -25,6 +25,37 @@ void MysqlClientConf::Display() const {
   TRPC_LOG_DEBUG("thread_num: " << thread_num);
   TRPC_LOG_DEBUG("thread_bind_core: " << thread_bind_core);
   TRPC_LOG_DEBUG("num_shard_group: " << num_shard_group);
+  TRPC_LOG_DEBUG("numa_aware: " << numa_aware);
+  TRPC_LOG_DEBUG("multi_statements: " << multi_statements);
+  TRPC_LOG_DEBUG("deferred_begin: " << deferred_begin);
+  TRPC_LOG_DEBUG("execute_mode: " << execute_mode);
+  TRPC_LOG_DEBUG("fiber_scheduling_group: " << fiber_scheduling_group);
+  TRPC_LOG_DEBUG("tx_idle_timeout: " << tx_idle_timeout);
+  TRPC_LOG_DEBUG("tx_max_duration: " << tx_max_duration);
+  TRPC_LOG_DEBUG("primary: " << primary);
+  for (const auto& replica : replicas) TRPC_LOG_DEBUG("replica: " << replica);
+  TRPC_LOG_DEBUG("read_your_writes: " << read_your_writes);
+  TRPC_LOG_DEBUG("gtid_wait_timeout: " << gtid_wait_timeout);
+  TRPC_LOG_DEBUG("hedge_delay: " << hedge_delay);
+  TRPC_LOG_DEBUG("hedge_percentile: " << hedge_percentile);
+  TRPC_LOG_DEBUG("hedge_budget: " << hedge_budget);
+  TRPC_LOG_DEBUG("deadline_propagation: " << deadline_propagation);
+  TRPC_LOG_DEBUG("adaptive_concurrency: " << adaptive_concurrency);
+  TRPC_LOG_DEBUG("min_concurrency: " << min_concurrency);
+  TRPC_LOG_DEBUG("max_concurrency: " << max_concurrency);
+  TRPC_LOG_DEBUG("sql_stats: " << sql_stats);
+  TRPC_LOG_DEBUG("max_sql_fingerprints: " << max_sql_fingerprints);
+  TRPC_LOG_DEBUG("slow_query_threshold: " << slow_query_threshold);
+  TRPC_LOG_DEBUG("slow_query_log_per_second: " << slow_query_log_per_second);
+  TRPC_LOG_DEBUG("call_timeline: " << call_timeline);
+  TRPC_LOG_DEBUG("result_cache_bytes: " << result_cache_bytes);
+  TRPC_LOG_DEBUG("result_cache_shards: " << result_cache_shards);
+  for (const auto& query_class : query_classes) {
+    TRPC_LOG_DEBUG("query_class: " << query_class.name << ", thread_num: " << query_class.thread_num
+                                   << ", fiber_scheduling_group: " << query_class.fiber_scheduling_group
+                                   << ", max_queue_size: " << query_class.max_queue_size
+                                   << ", max_conn: " << query_class.max_conn);
+  }
 }
 
 }  // namespace trpc::mysql
@@ -13,10 +13,34 @@
 
 #pragma once
 
+#include <string>
+#include <vector>
+
 #include "yaml-cpp/yaml.h"
 
 namespace trpc::mysql {
 
+/// @brief A class of queries with its own workers, queue limit and connection quota (see `query_classes`).
+/// Calls are tagged with a class by `SetMysqlQueryClass` on their ClientContext.
+struct MysqlQueryClassConf {
+  std::string name;
+
+  /// @brief Threads of the class in "thread_pool" mode, isolated from the other classes. 0 shares the default
+  /// thread pool, e.g. for a class with a queue limit or a connection quota only.
+  size_t thread_num{1};
+
+  /// @brief Fiber scheduling group of the class in "fiber" mode, -1 uses `fiber_scheduling_group`.
+  int fiber_scheduling_group{-1};
+
+  /// @brief Calls of the class queued or running at most. Further calls fail at once with TRPC_CLIENT_OVERLOAD_ERR.
+  /// 0 means no limit.
+  uint32_t max_queue_size{0};
+
+  /// @brief Connections of each node used by the class at most. Further calls fail at once with
+  /// TRPC_CLIENT_LIMITED_ERR. 0 means no quota. Statements in a transaction use the connection of the transaction.
+  uint32_t max_conn{0};
+};
+
 /// @brief Client config for accessing mysql
 /// Mainly contains authentication information
 struct MysqlClientConf {
@@ -41,6 +65,112 @@ struct MysqlClientConf {
   /// Only For MysqlExecutorPoolImpl
   uint32_t num_shard_group{4};
 
+  /// @brief NUMA-aware connection pools: the `num_shard_group` shards of each pool are split between the NUMA nodes,
+  /// and a worker takes its connections from the shards of its own node. Its connections, and the buffers of their
+  /// statements, are then allocated on that node. Use it with `thread_bind_core` (or pinned fiber workers) and a
+  /// multiple of the node count as `num_shard_group`.
+  bool numa_aware{false};
+
+  /// @brief Connect with CLIENT_MULTI_STATEMENTS. Needed for sending a deferred BEGIN and a transaction script in
+  /// one packet. Note that it allows several statements in one text protocol query (e.g. MysqlResults<NativeString>).
+  bool multi_statements{false};
+
+  /// @brief Begin does not send "begin". "START TRANSACTION" is sent with the first statement of the transaction
+  /// instead, in the same packet for text protocol statements if `multi_statements` is set. Connection errors are
+  /// reported by the first statement rather than Begin.
+  bool deferred_begin{false};
+
+  /// @brief Where the blocking libmysqlclient calls run.
+  /// "thread_pool": a dedicated thread pool sized by `thread_num` (default).
+  /// "fiber": fiber workers of the fiber runtime, without the thread pool hop. See `fiber_scheduling_group`.
+  std::string execute_mode{"thread_pool"};
+
+  /// @brief Only for "fiber" execute mode. Index of the fiber scheduling group reserved for MySQL calls, the calls
+  /// of the other scheduling groups are posted to it. Required by "fiber": with a negative value the calls would block
+  /// the fiber workers of the callers, so the thread pool is used instead.
+  int fiber_scheduling_group{-1};
+
+  /// @brief Milliseconds a transaction may stay without executing a statement before it is rolled back and its
+  /// connection reclaimed. The handle becomes invalid then. 0 disables it.
+  uint64_t tx_idle_timeout{0};
+
+  /// @brief Milliseconds a transaction may last since Begin before it is rolled back like `tx_idle_timeout`.
+  /// 0 disables it.
+  uint64_t tx_max_duration{0};
+
+  /// @brief Read/write splitting. "ip:port" of the primary, which receives Execute, transactions and transaction
+  /// scripts. If empty, the target selected for the call (context address or selector) is used as the primary.
+  std::string primary;
+
+  /// @brief "ip:port" of the replicas. Query without a transaction goes to the replica with the least outstanding
+  /// requests. If empty, reads go to the primary as well.
+  std::vector<std::string> replicas;
+
+  /// @brief Read-your-writes for replica reads. The GTID of each write is tracked (session_track_gtids) and kept in
+  /// the ClientContext (see mysql_context.h). A replica read with a GTID in its context first waits until the replica
+  /// has applied it, or is sent to the primary if it does not within `gtid_wait_timeout`. Needs gtid_mode=ON.
+  bool read_your_writes{false};
+
+  /// @brief Milliseconds a replica read waits for the GTID of `read_your_writes`.
+  uint32_t gtid_wait_timeout{100};
+
+  /// @brief Hedged reads. Milliseconds a Query without a transaction may run before the same query is also sent to
+  /// another node (another replica, or another target of the selector). The first result is returned, the other
+  /// query is cancelled with KILL QUERY. 0 disables fixed delay hedging. Only for idempotent reads.
+  uint32_t hedge_delay{0};
+
+  /// @brief Hedges reads after the tracked latency percentile (e.g. 95) of the reads instead, never earlier than
+  /// `hedge_delay`. 0 uses the fixed `hedge_delay` only.
+  uint32_t hedge_percentile{0};
+
+  /// @brief Extra queries sent by hedging, in percent of the reads. Caps the load added by hedging.
+  uint32_t hedge_budget{10};
+
+  /// @brief Bounds each statement by the timeout of its ClientContext: SELECTs get a MAX_EXECUTION_TIME hint, the
+  /// network timeouts of the connection follow the remaining time, and a statement still running at the deadline is
+  /// cancelled with KILL QUERY, which frees the worker and the connection at once.
+  bool deadline_propagation{true};
+
+  /// @brief Limits the in-flight statements of each node adaptively from their latency (see
+  /// MysqlConcurrencyLimiter). Calls over the limit fail at once with TRPC_CLIENT_LIMITED_ERR instead of queueing.
+  bool adaptive_concurrency{false};
+
+  /// @brief Lower bound of the adaptive limit.
+  uint32_t min_concurrency{4};
+
+  /// @brief Upper bound of the adaptive limit, 0 means `max_conn_num`.
+  uint32_t max_concurrency{0};
+
+  /// @brief Query classes, e.g. latency critical lookups and slow reports, so that a burst of one class cannot take
+  /// the workers and the connections of the others. Calls without a class, or with an unknown one, use the default
+  /// workers and connections.
+  std::vector<MysqlQueryClassConf> query_classes;
+
+  /// @brief Keeps latency histograms of the prepare, execute, fetch and decode phases and the row counts of each SQL
+  /// fingerprint, i.e. the statement with its literals stripped (see MysqlSqlStats).
+  bool sql_stats{false};
+
+  /// @brief Distinct fingerprints tracked at most, the statements of further ones are counted together.
+  uint32_t max_sql_fingerprints{500};
+
+  /// @brief Milliseconds from which a statement is logged as a slow query, with its fingerprint and without its
+  /// arguments. 0 disables the slow query log.
+  uint64_t slow_query_threshold{0};
+
+  /// @brief Slow queries logged per second at most, the others are only counted.
+  uint32_t slow_query_log_per_second{10};
+
+  /// @brief Records the queueing, connection acquisition, statement phases and resumption of each call into its
+  /// ClientContext (see GetMysqlCallTimeline in mysql_context.h).
+  bool call_timeline{false};
+
+  /// @brief Bytes of the cache of the Query results, 0 disables the cache. Only the calls whose context has
+  /// SetMysqlResultCache (see mysql_context.h) are cached.
+  uint64_t result_cache_bytes{0};
+
+  /// @brief Shards of the result cache, each with its own lock and its share of `result_cache_bytes`.
+  uint32_t result_cache_shards{16};
+
   void Display() const;
 };
 
@@ -19,6 +19,37 @@
 
 namespace YAML {
 
+template <>
+struct convert<trpc::mysql::MysqlQueryClassConf> {
+  static YAML::Node encode(const trpc::mysql::MysqlQueryClassConf& class_conf) {
+    YAML::Node node;
+    node["name"] = class_conf.name;
+    node["thread_num"] = class_conf.thread_num;
+    node["fiber_scheduling_group"] = class_conf.fiber_scheduling_group;
+    node["max_queue_size"] = class_conf.max_queue_size;
+    node["max_conn"] = class_conf.max_conn;
+    return node;
+  }
+
+  static bool decode(const YAML::Node& node, trpc::mysql::MysqlQueryClassConf& class_conf) {
+    if (!node["name"]) return false;
+    class_conf.name = node["name"].as<std::string>();
+    if (node["thread_num"]) {
+      class_conf.thread_num = node["thread_num"].as<size_t>();
+    }
+    if (node["fiber_scheduling_group"]) {
+      class_conf.fiber_scheduling_group = node["fiber_scheduling_group"].as<int>();
+    }
+    if (node["max_queue_size"]) {
+      class_conf.max_queue_size = node["max_queue_size"].as<uint32_t>();
+    }
+    if (node["max_conn"]) {
+      class_conf.max_conn = node["max_conn"].as<uint32_t>();
+    }
+    return true;
+  }
+};
+
 template <>
 struct convert<trpc::mysql::MysqlClientConf> {
   static YAML::Node encode(const trpc::mysql::MysqlClientConf& mysql_conf) {
@@ -30,6 +61,32 @@ struct convert<trpc::mysql::MysqlClientConf> {
     node["thread_num"] = mysql_conf.thread_num;
     node["thread_bind_core"] = mysql_conf.thread_bind_core;
     node["num_shard_group"] = mysql_conf.num_shard_group;
+    node["numa_aware"] = mysql_conf.numa_aware;
+    node["multi_statements"] = mysql_conf.multi_statements;
+    node["deferred_begin"] = mysql_conf.deferred_begin;
+    node["execute_mode"] = mysql_conf.execute_mode;
+    node["fiber_scheduling_group"] = mysql_conf.fiber_scheduling_group;
+    node["tx_idle_timeout"] = mysql_conf.tx_idle_timeout;
+    node["tx_max_duration"] = mysql_conf.tx_max_duration;
+    node["primary"] = mysql_conf.primary;
+    node["replicas"] = mysql_conf.replicas;
+    node["read_your_writes"] = mysql_conf.read_your_writes;
+    node["gtid_wait_timeout"] = mysql_conf.gtid_wait_timeout;
+    node["hedge_delay"] = mysql_conf.hedge_delay;
+    node["hedge_percentile"] = mysql_conf.hedge_percentile;
+    node["hedge_budget"] = mysql_conf.hedge_budget;
+    node["deadline_propagation"] = mysql_conf.deadline_propagation;
+    node["adaptive_concurrency"] = mysql_conf.adaptive_concurrency;
+    node["min_concurrency"] = mysql_conf.min_concurrency;
+    node["max_concurrency"] = mysql_conf.max_concurrency;
+    node["query_classes"] = mysql_conf.query_classes;
+    node["sql_stats"] = mysql_conf.sql_stats;
+    node["max_sql_fingerprints"] = mysql_conf.max_sql_fingerprints;
+    node["slow_query_threshold"] = mysql_conf.slow_query_threshold;
+    node["slow_query_log_per_second"] = mysql_conf.slow_query_log_per_second;
+    node["call_timeline"] = mysql_conf.call_timeline;
+    node["result_cache_bytes"] = mysql_conf.result_cache_bytes;
+    node["result_cache_shards"] = mysql_conf.result_cache_shards;
     return node;
   }
 
@@ -55,6 +112,84 @@ struct convert<trpc::mysql::MysqlClientConf> {
     if (node["num_shard_group"]) {
       mysql_conf.num_shard_group = node["num_shard_group"].as<uint32_t>();
     }
+    if (node["numa_aware"]) {
+      mysql_conf.numa_aware = node["numa_aware"].as<bool>();
+    }
+    if (node["multi_statements"]) {
+      mysql_conf.multi_statements = node["multi_statements"].as<bool>();
+    }
+    if (node["deferred_begin"]) {
+      mysql_conf.deferred_begin = node["deferred_begin"].as<bool>();
+    }
+    if (node["execute_mode"]) {
+      mysql_conf.execute_mode = node["execute_mode"].as<std::string>();
+    }
+    if (node["fiber_scheduling_group"]) {
+      mysql_conf.fiber_scheduling_group = node["fiber_scheduling_group"].as<int>();
+    }
+    if (node["tx_idle_timeout"]) {
+      mysql_conf.tx_idle_timeout = node["tx_idle_timeout"].as<uint64_t>();
+    }
+    if (node["tx_max_duration"]) {
+      mysql_conf.tx_max_duration = node["tx_max_duration"].as<uint64_t>();
+    }
+    if (node["primary"]) {
+      mysql_conf.primary = node["primary"].as<std::string>();
+    }
+    if (node["replicas"]) {
+      mysql_conf.replicas = node["replicas"].as<std::vector<std::string>>();
+    }
+    if (node["read_your_writes"]) {
+      mysql_conf.read_your_writes = node["read_your_writes"].as<bool>();
+    }
+    if (node["gtid_wait_timeout"]) {
+      mysql_conf.gtid_wait_timeout = node["gtid_wait_timeout"].as<uint32_t>();
+    }
+    if (node["hedge_delay"]) {
+      mysql_conf.hedge_delay = node["hedge_delay"].as<uint32_t>();
+    }
+    if (node["hedge_percentile"]) {
+      mysql_conf.hedge_percentile = node["hedge_percentile"].as<uint32_t>();
+    }
+    if (node["hedge_budget"]) {
+      mysql_conf.hedge_budget = node["hedge_budget"].as<uint32_t>();
+    }
+    if (node["deadline_propagation"]) {
+      mysql_conf.deadline_propagation = node["deadline_propagation"].as<bool>();
+    }
+    if (node["adaptive_concurrency"]) {
+      mysql_conf.adaptive_concurrency = node["adaptive_concurrency"].as<bool>();
+    }
+    if (node["min_concurrency"]) {
+      mysql_conf.min_concurrency = node["min_concurrency"].as<uint32_t>();
+    }
+    if (node["max_concurrency"]) {
+      mysql_conf.max_concurrency = node["max_concurrency"].as<uint32_t>();
+    }
+    if (node["query_classes"]) {
+      mysql_conf.query_classes = node["query_classes"].as<std::vector<trpc::mysql::MysqlQueryClassConf>>();
+    }
+    if (node["sql_stats"]) {
+      mysql_conf.sql_stats = node["sql_stats"].as<bool>();
+    }
+    if (node["max_sql_fingerprints"]) {
+      mysql_conf.max_sql_fingerprints = node["max_sql_fingerprints"].as<uint32_t>();
+    }
+    if (node["slow_query_threshold"]) {
+      mysql_conf.slow_query_threshold = node["slow_query_threshold"].as<uint64_t>();
+    }
+    if (node["slow_query_log_per_second"]) {
+      mysql_conf.slow_query_log_per_second = node["slow_query_log_per_second"].as<uint32_t>();
+    }
+    if (node["call_timeline"]) {
+      mysql_conf.call_timeline = node["call_timeline"].as<bool>();
+    }
+    if (node["result_cache_bytes"]) {
+      mysql_conf.result_cache_bytes = node["result_cache_bytes"].as<uint64_t>();
+    }
+    if (node["result_cache_shards"]) {
+      mysql_conf.result_cache_shards = node["result_cache_shards"].as<uint32_t>();
+    }
 
     return true;
   }
@@ -13,6 +13,8 @@
 
 #include "trpc/client/mysql/executor/mysql_binder.h"
 
+#include <cctype>
+
 namespace trpc::mysql {
 
 /// Key: MysqlResult<Args..> args type
@@ -38,4 +40,87 @@ MYSQL_OUTPUT_TYPE_MAP(std::string, MYSQL_TYPE_YEAR, MYSQL_TYPE_TIME, MYSQL_TYPE_
 MYSQL_OUTPUT_TYPE_MAP(MysqlBlob, MYSQL_TYPE_TINY_BLOB, MYSQL_TYPE_BLOB, MYSQL_TYPE_MEDIUM_BLOB, MYSQL_TYPE_LONG_BLOB,
                       MYSQL_TYPE_BIT)
 
+size_t RoundUpListArity(size_t size) {
+  // The most markers of a prepared statement, see ER_PS_MANY_PARAM.
+  constexpr size_t kMaxMarkers = 65535;
+  if (size > kMaxMarkers / 2 + 1) return size;
+
+  size_t arity = 1;
+  while (arity < size) arity *= 2;
+  return arity;
+}
+
+size_t SkipQuotedOrComment(const std::string& query, size_t i) {
+  size_t len = query.size();
+  char c = query[i];
+  if (c == '\'' || c == '"' || c == '`') {
+    // Literal or quoted identifier, up to its closing quote.
+    size_t end = i + 1;
+    while (end < len && query[end] != c) end += (query[end] == '\\' && c != '`') ? 2 : 1;
+    return std::min(end, len - 1);
+  }
+  if (c == '#' || (c == '-' && i + 2 < len && query[i + 1] == '-' && query[i + 2] == ' ')) {
+    size_t end = query.find('\n', i);
+    return end == std::string::npos ? len - 1 : end;
+  }
+  if (c == '/' && i + 1 < len && query[i + 1] == '*') {
+    size_t end = query.find("*/", i + 2);
+    return end == std::string::npos ? len - 1 : end + 1;
+  }
+  return std::string::npos;
+}
+
+std::string ExpandListMarkers(const std::string& query, const std::vector<size_t>& counts) {
+  std::string expanded;
+  expanded.reserve(query.size() + counts.size() * 8);
+  size_t marker = 0;
+  size_t len = query.size();
+
+  for (size_t i = 0; i < len; ++i) {
+    char c = query[i];
+    size_t end = SkipQuotedOrComment(query, i);
+    if (end != std::string::npos) {
+      expanded.append(query, i, end - i + 1);
+      i = end;
+    } else if (c == '?' && marker < counts.size()) {
+      for (size_t k = 0; k < counts[marker]; ++k) expanded.append(k == 0 ? "?" : ",?");
+      ++marker;
+    } else {
+      expanded.push_back(c);
+    }
+  }
+  return expanded;
+}
+
+bool WritesSessionState(const std::string& query) {
+  size_t len = query.size();
+  bool statement_start = true;
+
+  for (size_t i = 0; i < len; ++i) {
+    char c = query[i];
+    size_t end = SkipQuotedOrComment(query, i);
+    if (end != std::string::npos) {
+      i = end;
+    } else if (c == ';') {
+      statement_start = true;
+    } else if (std::isspace(static_cast<unsigned char>(c))) {
+      continue;
+    } else if (c == '@' && i + 1 < len && query[i + 1] == '@') {
+      // Reads a system variable, a SET statement is needed to change one.
+      statement_start = false;
+      ++i;
+    } else if (c == '@') {
+      return true;
+    } else if (statement_start && i + 3 <= len && std::tolower(c) == 's' &&
+               std::tolower(static_cast<unsigned char>(query[i + 1])) == 'e' &&
+               std::tolower(static_cast<unsigned char>(query[i + 2])) == 't' &&
+               (i + 3 == len || !(std::isalnum(static_cast<unsigned char>(query[i + 3])) || query[i + 3] == '_'))) {
+      return true;
+    } else {
+      statement_start = false;
+    }
+  }
+  return false;
+}
+
 }  // namespace trpc::mysql
\ No newline at end of file
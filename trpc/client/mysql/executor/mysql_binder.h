@@ -13,8 +13,15 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstring>
+#include <string>
 #include <type_traits>
 #include <unordered_set>
+#include <vector>
+#if __cplusplus >= 202002L
+#include <span>
+#endif
 
 #include "mysqlclient/mysql.h"
 #include "trpc/util/string_util.h"
@@ -128,11 +135,75 @@ inline void StepInputBind(MYSQL_BIND& bind, std::string_view value) {
   bind.is_unsigned = false;
 }
 
+/// @brief Input args bound to a list of markers, e.g. the values of `IN (?)`. The "?" of the arg is expanded to one
+/// marker per value, rounded up to a power of two (see RoundUpListArity).
+template <typename T>
+struct IsInputList : std::false_type {};
+
+template <typename T, typename Alloc>
+struct IsInputList<std::vector<T, Alloc>> : std::true_type {
+  static_assert(!std::is_same_v<T, bool>, "std::vector<bool> can not be bound, its values are not addressable");
+};
+
+#if __cplusplus >= 202002L
+template <typename T, size_t Extent>
+struct IsInputList<std::span<T, Extent>> : std::true_type {};
+#endif
+
+template <typename... InputArgs>
+constexpr bool kHasInputList = (IsInputList<InputArgs>::value || ...);
+
+/// @brief The markers of a list of `size` values: the next power of two, so that a few prepared statements serve
+/// all the list sizes. The list is padded with its last value, which does not change the rows matched by IN.
+/// An empty list has one marker bound to NULL, which matches no row. A list whose padding would exceed the 65535
+/// markers MySQL allows in a statement is not padded.
+size_t RoundUpListArity(size_t size);
+
+/// @brief Replaces the i-th "?" of `query` with `counts[i]` markers ("?,?,..."). Question marks in literals,
+/// quoted identifiers and comments are not markers.
+std::string ExpandListMarkers(const std::string& query, const std::vector<size_t>& counts);
+
+/// @brief If a literal, a quoted identifier or a comment starts at `query[i]`, the index of its last character.
+/// Otherwise std::string::npos.
+size_t SkipQuotedOrComment(const std::string& query, size_t i);
+
+/// @brief Whether `query` may change the session state which outlives it: a user variable ("@var", outside
+/// literals and comments) or a SET statement. Reading "@@var" is not a change.
+bool WritesSessionState(const std::string& query);
+
+template <typename T>
+size_t InputBindCount(const T& arg) {
+  if constexpr (IsInputList<T>::value) {
+    return RoundUpListArity(arg.size());
+  } else {
+    return 1;
+  }
+}
+
+template <typename T>
+void StepInputBinds(MYSQL_BIND* binds, size_t& i, const T& arg) {
+  if constexpr (IsInputList<T>::value) {
+    if (arg.size() == 0) {
+      std::memset(&binds[i], 0, sizeof(MYSQL_BIND));
+      binds[i++].buffer_type = MYSQL_TYPE_NULL;
+      return;
+    }
+    size_t arity = RoundUpListArity(arg.size());
+    for (size_t k = 0; k < arity; ++k) StepInputBind(binds[i++], arg[std::min(k, arg.size() - 1)]);
+  } else {
+    StepInputBind(binds[i++], arg);
+  }
+}
+
 template <typename... InputArgs>
 void BindInputImpl(std::vector<MYSQL_BIND>& binds, const InputArgs&... args) {
-  binds.resize(sizeof...(InputArgs));
-  int i = 0;
-  (StepInputBind(binds[i++], args), ...);
+  if constexpr (kHasInputList<InputArgs...>) {
+    binds.resize((InputBindCount(args) + ... + 0));
+  } else {
+    binds.resize(sizeof...(InputArgs));
+  }
+  size_t i = 0;
+  (StepInputBinds(binds.data(), i, args), ...);
 }
 
 // ***********
@@ -220,12 +291,21 @@ void StepTupleSet(T& value, const MYSQL_BIND& bind) {
 
 inline void StepTupleSet(MysqlTime& value, const MYSQL_BIND& bind) { value = {*static_cast<MysqlTime*>(bind.buffer)}; }
 
+// NULL clears the value, as the tuple may hold a previous row (see MysqlExecutor::FetchCursor).
 inline void StepTupleSet(std::string& value, const MYSQL_BIND& bind) {
-  if ((*bind.is_null) == 0) value.assign(static_cast<const char*>(bind.buffer), *(bind.length));
+  if ((*bind.is_null) == 0) {
+    value.assign(static_cast<const char*>(bind.buffer), *(bind.length));
+  } else {
+    value.clear();
+  }
 }
 
 inline void StepTupleSet(MysqlBlob& value, const MYSQL_BIND& bind) {
-  if ((*bind.is_null) == 0) value = MysqlBlob(static_cast<const char*>(bind.buffer), *(bind.length));
+  if ((*bind.is_null) == 0) {
+    value = MysqlBlob(static_cast<const char*>(bind.buffer), *(bind.length));
+  } else {
+    value = MysqlBlob();
+  }
 }
 
 template <typename... OutputArgs>
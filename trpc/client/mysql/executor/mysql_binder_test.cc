@@ -0,0 +1,83 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#include "trpc/client/mysql/executor/mysql_binder.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace trpc::testing {
+
+using trpc::mysql::BindInputImpl;
+using trpc::mysql::ExpandListMarkers;
+using trpc::mysql::RoundUpListArity;
+using trpc::mysql::WritesSessionState;
+
+TEST(MysqlBinderTest, RoundUpListArity) {
+  EXPECT_EQ(RoundUpListArity(0), 1);
+  EXPECT_EQ(RoundUpListArity(1), 1);
+  EXPECT_EQ(RoundUpListArity(3), 4);
+  EXPECT_EQ(RoundUpListArity(4), 4);
+  EXPECT_EQ(RoundUpListArity(33), 64);
+  EXPECT_EQ(RoundUpListArity(32768), 32768);
+  // Padded beyond the 65535 markers of a statement, the exact size is kept.
+  EXPECT_EQ(RoundUpListArity(32769), 32769);
+  EXPECT_EQ(RoundUpListArity(65535), 65535);
+  EXPECT_EQ(RoundUpListArity(100000), 100000);
+}
+
+TEST(MysqlBinderTest, ExpandListMarkers) {
+  EXPECT_EQ(ExpandListMarkers("select * from t where a = ? and id in (?)", {1, 4}),
+            "select * from t where a = ? and id in (?,?,?,?)");
+  // Question marks which are not markers are kept.
+  EXPECT_EQ(ExpandListMarkers("select '?', `a?`, \"\\\"?\" /* ? */ from t where id in (?) -- ?", {2}),
+            "select '?', `a?`, \"\\\"?\" /* ? */ from t where id in (?,?) -- ?");
+  EXPECT_EQ(ExpandListMarkers("select ? # ?\nfrom t where id in (?)", {1, 2}),
+            "select ? # ?\nfrom t where id in (?,?)");
+}
+
+TEST(MysqlBinderTest, WritesSessionState) {
+  EXPECT_TRUE(WritesSessionState("set @uid = ?"));
+  EXPECT_TRUE(WritesSessionState("select id into @uid from users where name = ?"));
+  EXPECT_TRUE(WritesSessionState("SET NAMES utf8mb4"));
+  EXPECT_TRUE(WritesSessionState("/* hint */ Set session sql_mode = ''"));
+  EXPECT_TRUE(WritesSessionState("select 1; set autocommit = 0"));
+
+  // '@' in literals, quoted identifiers and comments, or a system variable read.
+  EXPECT_FALSE(WritesSessionState("select * from users where email like '%@x.com'"));
+  EXPECT_FALSE(WritesSessionState("select `a@b`, \"c@d\" from t -- @uid"));
+  EXPECT_FALSE(WritesSessionState("select @@version"));
+  EXPECT_FALSE(WritesSessionState("update t set a = 1 where id = ?"));
+  EXPECT_FALSE(WritesSessionState("select settings from t"));
+}
+
+TEST(MysqlBinderTest, BindList) {
+  int64_t status = 1;
+  std::vector<int64_t> ids{7, 8, 9};
+  std::vector<std::string> names;
+  std::vector<MYSQL_BIND> binds;
+  BindInputImpl(binds, status, ids, names);
+
+  // 1 + 3 ids padded to 4 + 1 NULL for the empty list.
+  ASSERT_EQ(binds.size(), 6);
+  EXPECT_EQ(binds[0].buffer, &status);
+  EXPECT_EQ(binds[1].buffer, &ids[0]);
+  EXPECT_EQ(binds[3].buffer, &ids[2]);
+  EXPECT_EQ(binds[4].buffer, &ids[2]);
+  EXPECT_EQ(binds[4].buffer_type, MYSQL_TYPE_LONGLONG);
+  EXPECT_EQ(binds[5].buffer_type, MYSQL_TYPE_NULL);
+}
+
+}  // namespace trpc::testing
@@ -13,6 +13,10 @@
 
 #include "trpc/client/mysql/executor/mysql_executor.h"
 
+#include <algorithm>
+#include <cctype>
+#include <string_view>
+
 #include "trpc/util/log/logging.h"
 
 namespace trpc::mysql {
@@ -22,7 +26,16 @@ constexpr unsigned int TRPC_MYSQL_API_TIMEOUT = 5;
 constexpr int RECONNECT_INIT_RETRY_INTERVAL = 100;
 constexpr int RECONNECT_MAX_RETRY = 5;
 
-MysqlExecutor::MysqlExecutor(const MysqlConnOption& option) : is_connected(false), option_(option) {
+namespace {
+
+bool SimpleQuery(MYSQL* mysql, std::string_view query) {
+  return mysql_real_query(mysql, query.data(), query.length()) == 0;
+}
+
+}  // namespace
+
+MysqlExecutor::MysqlExecutor(const MysqlConnOption& option)
+    : is_connected(false), net_timeout_(TRPC_MYSQL_API_TIMEOUT), option_(option) {
   {
     std::lock_guard<std::mutex> lock(mysql_mutex);
     mysql_ = mysql_init(nullptr);
@@ -43,8 +56,9 @@ bool MysqlExecutor::Connect() {
     mysql_ = mysql_init(nullptr);
   }
 
+  unsigned long client_flag = option_.multi_statements ? CLIENT_MULTI_STATEMENTS : 0;
   MYSQL* ret = mysql_real_connect(mysql_, option_.hostname.c_str(), option_.username.c_str(), option_.password.c_str(),
-                                  option_.database.c_str(), option_.port, nullptr, 0);
+                                  option_.database.c_str(), option_.port, nullptr, client_flag);
 
   if (nullptr == ret) {
     mysql_close(mysql_);
@@ -53,6 +67,10 @@ bool MysqlExecutor::Connect() {
   }
 
   is_connected = true;
+  // A new connection starts with the timeouts of the options.
+  net_timeout_ = TRPC_MYSQL_API_TIMEOUT;
+  deadline_ms_ = 0;
+  EnableGtidTracking();
   return true;
 }
 
@@ -63,6 +81,7 @@ MysqlExecutor::~MysqlExecutor() {
 }
 
 void MysqlExecutor::Close() {
+  CloseCursorStatements();
   if (mysql_ != nullptr && is_connected) {
     mysql_close(mysql_);
     mysql_ = nullptr;
@@ -151,13 +170,17 @@ bool MysqlExecutor::CheckAlive() {
 }
 
 size_t MysqlExecutor::ExecuteInternal(const std::string& query, MysqlResults<OnlyExec>& mysql_results) {
-  if (mysql_real_query(mysql_, query.c_str(), query.length()) != 0) {
+  bool executed = RealQuery(query);
+  EndPhase(&MysqlStatementPhases::execute_us);
+  if (!executed) {
     mysql_results.SetErrorMessage(GetErrorMessage());
     mysql_results.SetErrorNumber(GetErrorNumber());
     return 0;
   }
 
-  return mysql_affected_rows(mysql_);
+  size_t affected_rows = mysql_affected_rows(mysql_);
+  CaptureSessionGtid();
+  return affected_rows;
 }
 
 void MysqlExecutor::SetExecutorId(uint64_t eid) { executor_id_ = eid; }
@@ -168,6 +191,8 @@ std::string MysqlExecutor::GetIp() const { return option_.hostname; }
 
 uint16_t MysqlExecutor::GetPort() const { return option_.port; }
 
+unsigned long MysqlExecutor::GetThreadId() const { return mysql_ != nullptr ? mysql_thread_id(mysql_) : 0; }
+
 int MysqlExecutor::GetErrorNumber() { return mysql_errno(mysql_); }
 
 std::string MysqlExecutor::GetErrorMessage() { return mysql_error(mysql_); }
@@ -182,6 +207,196 @@ bool MysqlExecutor::AutoCommit(bool mode) {
   return true;
 }
 
+bool MysqlExecutor::ResetConnection() {
+  if (!is_connected || mysql_ == nullptr) return false;
+
+  CloseCursorStatements();
+  if (mysql_reset_connection(mysql_) != 0) return false;
+
+  // COM_RESET_CONNECTION also reinitializes the variables set implicitly by SET NAMES.
+  if (mysql_set_character_set(mysql_, option_.char_set.c_str()) != 0) return false;
+
+  auto_commit_ = true;
+  session_dirty_ = false;
+  begin_pending_ = false;
+  EnableGtidTracking();
+  return true;
+}
+
+void MysqlExecutor::SetDeadline(uint64_t deadline_ms) {
+  deadline_ms_ = deadline_ms;
+
+  unsigned int timeout = GetNetTimeout(deadline_ms, deadline_ms != 0 ? trpc::GetSteadyMilliSeconds() : 0);
+  if (timeout != net_timeout_) SetNetTimeout(timeout);
+}
+
+unsigned int MysqlExecutor::GetNetTimeout(uint64_t deadline_ms, uint64_t now_ms) {
+  if (deadline_ms == 0) return TRPC_MYSQL_API_TIMEOUT;
+
+  uint64_t left_seconds = deadline_ms > now_ms ? (deadline_ms - now_ms + 999) / 1000 : 1;
+  return static_cast<unsigned int>(std::clamp<uint64_t>(left_seconds, 1, TRPC_MYSQL_API_TIMEOUT));
+}
+
+void MysqlExecutor::SetNetTimeout(unsigned int timeout) {
+  if (!is_connected || mysql_ == nullptr) return;
+  my_net_set_read_timeout(&mysql_->net, timeout);
+  my_net_set_write_timeout(&mysql_->net, timeout);
+  net_timeout_ = timeout;
+}
+
+std::string MysqlExecutor::AddExecutionTimeHint(const std::string& query, uint64_t left_ms) {
+  size_t begin = query.find_first_not_of(" \t\r\n");
+  if (begin == std::string::npos || query.size() - begin <= 6) return {};
+
+  constexpr std::string_view kSelect = "select";
+  for (size_t i = 0; i < kSelect.size(); ++i) {
+    if (std::tolower(static_cast<unsigned char>(query[begin + i])) != kSelect[i]) return {};
+  }
+  size_t keyword_end = begin + kSelect.size();
+  if (!std::isspace(static_cast<unsigned char>(query[keyword_end]))) return {};
+  if (query.find("MAX_EXECUTION_TIME") != std::string::npos || query.find("max_execution_time") != std::string::npos)
+    return {};
+
+  std::string hinted;
+  hinted.reserve(query.size() + 40);
+  hinted.append(query, 0, keyword_end);
+  hinted.append(" /*+ MAX_EXECUTION_TIME(").append(std::to_string(left_ms)).append(") */");
+  hinted.append(query, keyword_end, std::string::npos);
+  return hinted;
+}
+
+bool MysqlExecutor::NeedReset() const {
+  if (session_dirty_ || !cursor_statements_.empty() || !auto_commit_) return true;
+  return mysql_ != nullptr && (mysql_->server_status & SERVER_STATUS_IN_TRANS);
+}
+
+void MysqlExecutor::MarkSessionDirty() { session_dirty_ = true; }
+
+uint64_t MysqlExecutor::AddCursorStatement(std::unique_ptr<MysqlStatement>&& statement) {
+  uint64_t cursor_id = ++next_cursor_id_;
+  cursor_statements_.emplace(cursor_id, std::move(statement));
+  return cursor_id;
+}
+
+MysqlStatement* MysqlExecutor::FindCursorStatement(uint64_t cursor_id) {
+  auto it = cursor_statements_.find(cursor_id);
+  return it != cursor_statements_.end() ? it->second.get() : nullptr;
+}
+
+void MysqlExecutor::CloseCursorStatement(uint64_t cursor_id) {
+  auto it = cursor_statements_.find(cursor_id);
+  if (it == cursor_statements_.end()) return;
+
+  it->second->CloseStatement();
+  cursor_statements_.erase(it);
+}
+
+void MysqlExecutor::CloseCursorStatements() {
+  for (auto& [cursor_id, statement] : cursor_statements_) statement->CloseStatement();
+  cursor_statements_.clear();
+}
+
+void MysqlExecutor::SetBeginPending(bool pending) { begin_pending_ = pending; }
+
+bool MysqlExecutor::IsBeginPending() const { return begin_pending_; }
+
+bool MysqlExecutor::RealQuery(const std::string& query) {
+  if (begin_pending_ && option_.multi_statements) {
+    std::string batch = "START TRANSACTION;" + query;
+    if (!SimpleQuery(mysql_, batch)) return false;
+    begin_pending_ = false;
+    // Skip the OK packet of "START TRANSACTION". The result of `query` becomes the current one.
+    return mysql_next_result(mysql_) == 0;
+  }
+
+  if (!FlushPendingBegin()) return false;
+  return SimpleQuery(mysql_, query);
+}
+
+void MysqlExecutor::EnableGtidTracking() {
+  session_gtid_.clear();
+  if (!option_.track_gtids) return;
+
+  // Fails if the server is too old. Reads from replicas fall back to the primary then.
+  if (!SimpleQuery(mysql_, "SET SESSION session_track_gtids = OWN_GTID"))
+    TRPC_FMT_WARN("Enable session_track_gtids on {}:{} failed: {}.", option_.hostname, option_.port,
+                  GetErrorMessage());
+}
+
+void MysqlExecutor::CaptureSessionGtid() {
+  if (!option_.track_gtids) return;
+
+  const char* data = nullptr;
+  size_t length = 0;
+  if (mysql_session_track_get_first(mysql_, SESSION_TRACK_GTIDS, &data, &length) == 0)
+    session_gtid_.assign(data, length);
+  else
+    session_gtid_.clear();
+}
+
+bool MysqlExecutor::FlushPendingBegin() {
+  if (!begin_pending_) return true;
+
+  if (!SimpleQuery(mysql_, "START TRANSACTION")) return false;
+  begin_pending_ = false;
+  return true;
+}
+
+bool MysqlExecutor::ExecuteTransaction(MysqlResults<OnlyExec>& mysql_results,
+                                       const std::vector<std::string>& statements) {
+  mysql_results.Clear();
+  size_t affected_rows = 0;
+
+  auto set_error_and_rollback = [this, &mysql_results]() {
+    mysql_results.SetErrorMessage(GetErrorMessage());
+    mysql_results.SetErrorNumber(GetErrorNumber());
+    // The server stops at the failed statement, so the transaction is still open.
+    if (!SimpleQuery(mysql_, "ROLLBACK")) MarkSessionDirty();
+    return false;
+  };
+
+  if (!option_.multi_statements) {
+    if (!SimpleQuery(mysql_, "START TRANSACTION")) return set_error_and_rollback();
+    for (const auto& statement : statements) {
+      if (!SimpleQuery(mysql_, statement)) return set_error_and_rollback();
+      if (MYSQL_RES* res = mysql_store_result(mysql_))
+        mysql_free_result(res);
+      else
+        affected_rows += mysql_affected_rows(mysql_);
+    }
+    if (!SimpleQuery(mysql_, "COMMIT")) return set_error_and_rollback();
+    CaptureSessionGtid();
+
+    mysql_results.SetAffectedRows(affected_rows);
+    return true;
+  }
+
+  std::string script = "START TRANSACTION;";
+  for (const auto& statement : statements) {
+    script += statement;
+    script += ';';
+  }
+  script += "COMMIT";
+
+  if (!SimpleQuery(mysql_, script)) return set_error_and_rollback();
+
+  int status = 0;
+  do {
+    // Every result must be consumed before the connection can be used again.
+    if (MYSQL_RES* res = mysql_store_result(mysql_))
+      mysql_free_result(res);
+    else if (mysql_field_count(mysql_) == 0)
+      affected_rows += mysql_affected_rows(mysql_);
+    // The last result is the one of "COMMIT".
+    CaptureSessionGtid();
+  } while ((status = mysql_next_result(mysql_)) == 0);
+
+  if (status > 0) return set_error_and_rollback();
+
+  mysql_results.SetAffectedRows(affected_rows);
+  return true;
+}
+
 bool MysqlExecutor::IsConnected() { return is_connected; }
 
 }  // namespace trpc::mysql
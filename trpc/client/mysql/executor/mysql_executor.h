@@ -13,8 +13,12 @@
 
 #pragma once
 
+#include <algorithm>
+#include <memory>
 #include <mutex>
+#include <string>
 #include <type_traits>
+#include <unordered_map>
 
 #include "mysqlclient/mysql.h"
 #include "trpc/common/status.h"
@@ -26,6 +30,7 @@
 #include "trpc/client/mysql/executor/mysql_binder.h"
 #include "trpc/client/mysql/executor/mysql_results.h"
 #include "trpc/client/mysql/executor/mysql_statement.h"
+#include "trpc/client/mysql/executor/mysql_statement_observer.h"
 #include "trpc/client/mysql/mysql_error_number.h"
 
 namespace trpc::mysql {
@@ -65,6 +70,26 @@ class Formatter {
 
   static std::string SpecialConvert(const MysqlTime& arg) { return "'" + arg.ToString() + "'"; }
 
+  template <typename T, typename Alloc>
+  static std::string SpecialConvert(const std::vector<T, Alloc>& arg) { return ConvertList(arg); }
+
+#if __cplusplus >= 202002L
+  template <typename T, size_t Extent>
+  static std::string SpecialConvert(const std::span<T, Extent>& arg) { return ConvertList(arg); }
+#endif
+
+  /// @brief The values of a list arg separated by commas, NULL for an empty list.
+  template <typename List>
+  static std::string ConvertList(const List& arg) {
+    if (arg.empty()) return "NULL";
+    std::string list;
+    for (const auto& value : arg) {
+      if (!list.empty()) list.push_back(',');
+      list.append(util::FormatString("{}", SpecialConvert(value)));
+    }
+    return list;
+  }
+
   template <typename... Args>
   static std::string FormatQuery(const std::string& query, const Args&... args) {
     return util::FormatString(ConvertPlaceHolder(query), SpecialConvert(args)...);
@@ -83,11 +108,23 @@ struct MysqlConnOption {
   uint16_t port{0};
 
   std::string char_set{"utf8mb4"};
+
+  /// Connect with CLIENT_MULTI_STATEMENTS, which allows several statements in one text protocol query.
+  bool multi_statements{false};
+
+  /// Set "session_track_gtids = OWN_GTID", so the GTID of each write is returned with its OK packet.
+  bool track_gtids{false};
 };
 
+template <typename... OutputArgs>
+class MysqlCursor;
+
 /// @brief A MySQL connection class that wraps the MySQL C API.
 /// @note This class is not thread-safe. Ensure exclusive ownership during queries.
 class MysqlExecutor : public RefCounted<MysqlExecutor> {
+  template <typename... OutputArgs>
+  friend class MysqlCursor;
+
  private:
   template <typename... OutputArgs>
   class QueryHandle {
@@ -151,6 +188,59 @@ class MysqlExecutor : public RefCounted<MysqlExecutor> {
   ///@return true if no error
   bool AutoCommit(bool mode);
 
+  ///@brief Reset the session state with COM_RESET_CONNECTION instead of reconnecting.
+  /// Open transactions are rolled back, autocommit, user variables, temporary tables and
+  /// session variables are restored to their defaults. The character set is applied again afterwards.
+  ///@return true if the connection is clean and can be reused.
+  bool ResetConnection();
+
+  ///@brief Whether the session state may be dirty, i.e. an open transaction, autocommit off, a cursor left open,
+  /// or user variables may have been set by a previous statement.
+  bool NeedReset() const;
+
+  ///@brief Force a reset before the executor is reused, e.g. when a transaction is abandoned.
+  void MarkSessionDirty();
+
+  ///@brief Defer "START TRANSACTION" to the next statement. With `multi_statements`, it is sent in the same packet
+  /// as a text protocol statement. Otherwise (or before a prepared statement) it is sent right before the statement.
+  ///@param pending false drops a deferred begin which has not been sent, e.g. when the transaction ends without
+  /// any statement.
+  void SetBeginPending(bool pending);
+
+  ///@brief Whether "START TRANSACTION" has been deferred and not sent yet.
+  bool IsBeginPending() const;
+
+  ///@brief Runs `statements` (without placeholders) as one transaction. With `multi_statements`, the statements are
+  /// sent as a single "START TRANSACTION; ...; COMMIT" packet. Otherwise each statement is a round trip.
+  /// The transaction is rolled back if any statement fails.
+  ///@param mysql_results The affected rows are summed over all statements.
+  ///@return true if the transaction is committed.
+  bool ExecuteTransaction(MysqlResults<OnlyExec>& mysql_results, const std::vector<std::string>& statements);
+
+  ///@brief Takes the GTID committed by the last write statement (an autocommit statement, "COMMIT" or a transaction
+  /// script), e.g. "3E11FA47-71CA-11E1-9E33-C80AA9429562:23". Empty if it committed nothing, if it has been taken,
+  /// or if `track_gtids` of MysqlConnOption is not set.
+  std::string TakeSessionGtid() {
+    std::string gtid;
+    gtid.swap(session_gtid_);
+    return gtid;
+  }
+
+  ///@brief Bounds the following statements by a deadline, in steady milliseconds. SELECT statements get a
+  /// MAX_EXECUTION_TIME hint of the time left, and the network read/write timeouts are cut to the time left (whole
+  /// seconds, never above the default). 0 removes the deadline and restores the default timeouts.
+  void SetDeadline(uint64_t deadline_ms);
+
+  uint64_t GetDeadline() const { return deadline_ms_; }
+
+  ///@brief The network read/write timeout in seconds set by SetDeadline: the time left before `deadline_ms`
+  /// rounded up to whole seconds, at least 1 and at most the default one. The default one if `deadline_ms` is 0.
+  static unsigned int GetNetTimeout(uint64_t deadline_ms, uint64_t now_ms);
+
+  ///@brief `query` with a MAX_EXECUTION_TIME hint of `left_ms`, if it is a SELECT without such a hint. Empty if no
+  /// hint applies.
+  static std::string AddExecutionTimeHint(const std::string& query, uint64_t left_ms);
+
   ///@brief Executes an SQL query and retrieves all resulting rows, storing each row as a tuple.
   ///
   /// This function executes the provided SQL query with the specified input arguments.
@@ -169,6 +259,18 @@ class MysqlExecutor : public RefCounted<MysqlExecutor> {
   template <typename... InputArgs>
   bool Execute(MysqlResults<OnlyExec>& mysql_results, const std::string& query, const InputArgs&... args);
 
+  ///@brief Opens a read-only server-side cursor (CURSOR_TYPE_READ_ONLY) on the query. The rows are left on the
+  /// server and fetched with FetchCursor, so the client holds at most one batch of rows at a time.
+  ///@param mysql_results Only gets the error, if any.
+  template <typename... InputArgs, typename... OutputArgs>
+  bool OpenCursor(MysqlCursor<OutputArgs...>& cursor, MysqlResults<OutputArgs...>& mysql_results,
+                  const std::string& query, const InputArgs&... args);
+
+  ///@brief Fetches the next `fetch_rows` rows of the cursor (fewer at the end) into `mysql_results`. The rows of
+  /// the previous batch in `mysql_results` are overwritten in place, which reuses their buffers (e.g. of strings).
+  template <typename... OutputArgs>
+  bool FetchCursor(MysqlCursor<OutputArgs...>& cursor, MysqlResults<OutputArgs...>& mysql_results);
+
   /// @brief Get the error from MYSQL* mysql_.
   /// @note If use prepared statement (e.g. template <typename... InputArgs, typename... OutputArgs>
   ///  bool QueryAllInternal), the error should be get from mysql_stmt.
@@ -197,10 +299,27 @@ class MysqlExecutor : public RefCounted<MysqlExecutor> {
 
   uint64_t GetExecutorId() const;
 
+  /// @brief Generation of the connection settings the executor was created with, see
+  /// MysqlExecutorPool::Reconfigure.
+  void SetGeneration(uint32_t generation) { generation_ = generation; }
+
+  uint32_t GetGeneration() const { return generation_; }
+
   std::string GetIp() const;
 
   uint16_t GetPort() const;
 
+  /// @brief Id of the connection on the server, as used by "KILL QUERY <id>". 0 if not connected.
+  unsigned long GetThreadId() const;
+
+  /// @brief Reports the phases of each statement of QueryAll and Execute to `observer`. The phases are not timed
+  /// without an observer.
+  void SetObserver(std::shared_ptr<MysqlStatementObserver> observer) { observer_ = std::move(observer); }
+
+  /// @brief Adds the phases of each following statement to `*phases`, until it is reset with nullptr. Used to time
+  /// the statements of one call, e.g. for MysqlCallTimeline.
+  void SetCallPhases(MysqlStatementPhases* phases) { call_phases_ = phases; }
+
  private:
   ///@note: Only this overload will use mysql prepared statement api.
   template <typename... InputArgs, typename... OutputArgs>
@@ -220,9 +339,36 @@ class MysqlExecutor : public RefCounted<MysqlExecutor> {
   ///@brief This overload exists because some SQLs are not supported in mysql prepared statement api.
   size_t ExecuteInternal(const std::string& query, MysqlResults<OnlyExec>& mysql_results);
 
+  ///@brief Enables GTID tracking for the session if `track_gtids` is set. Needed after connecting or resetting.
+  void EnableGtidTracking();
+
+  ///@brief AddExecutionTimeHint with the time left before the deadline, at least 1 millisecond.
+  std::string AddExecutionTimeHint(const std::string& query) const {
+    uint64_t now = trpc::GetSteadyMilliSeconds();
+    return AddExecutionTimeHint(query, deadline_ms_ > now ? deadline_ms_ - now : 1);
+  }
+
+  ///@brief Sets the network read/write timeouts of the connection in seconds.
+  void SetNetTimeout(unsigned int timeout);
+
+  ///@brief Saves the GTID tracked by the OK packet of the last statement to `session_gtid_`.
+  void CaptureSessionGtid();
+
+  ///@brief mysql_real_query which carries the deferred "START TRANSACTION" if any.
+  ///@return false on error, which can be got by GetErrorNumber/GetErrorMessage.
+  bool RealQuery(const std::string& query);
+
+  ///@brief Sends the deferred "START TRANSACTION" on its own, e.g. before a prepared statement.
+  bool FlushPendingBegin();
+
   template <typename... InputArgs>
   void BindInputArgs(std::vector<MYSQL_BIND>& params, const InputArgs&... args);
 
+  /// @brief Expands the marker of each list arg to the markers of its values (see IsInputList).
+  /// @return Empty if there is no list arg, the query is used as is.
+  template <typename... InputArgs>
+  static std::string ExpandInputLists(const std::string& query, const InputArgs&... args);
+
   template <typename... OutputArgs>
   void BindOutputs(MysqlExecutor::QueryHandle<OutputArgs...>& handle);
 
@@ -236,6 +382,44 @@ class MysqlExecutor : public RefCounted<MysqlExecutor> {
   template <typename... OutputArgs>
   bool FetchTruncatedResults(MysqlExecutor::QueryHandle<OutputArgs...>& handle);
 
+  template <typename... InputArgs, typename... OutputArgs>
+  bool OpenCursorInternal(MysqlCursor<OutputArgs...>& cursor, MysqlResults<OutputArgs...>& mysql_results,
+                          const std::string& query, const InputArgs&... args);
+
+  ///@brief Keeps the statement of a cursor until the cursor closes it, or the session is reset or closed.
+  ///@return The id of the cursor.
+  uint64_t AddCursorStatement(std::unique_ptr<MysqlStatement>&& statement);
+
+  ///@return nullptr if the cursor has been closed, or freed with the session.
+  MysqlStatement* FindCursorStatement(uint64_t cursor_id);
+
+  void CloseCursorStatement(uint64_t cursor_id);
+
+  ///@brief Closes the client side of the statements of the cursors, the server frees them with the session.
+  void CloseCursorStatements();
+
+  bool TimingPhases() const { return observer_ != nullptr || call_phases_ != nullptr; }
+
+  ///@brief Starts timing the phases of a statement if there is an observer or call phases.
+  void BeginPhases() {
+    if (!TimingPhases()) return;
+    phases_ = MysqlStatementPhases();
+    phase_begin_us_ = trpc::GetSteadyMicroSeconds();
+  }
+
+  ///@brief Adds the time since the end of the previous phase to `phase`.
+  void EndPhase(uint64_t MysqlStatementPhases::*phase) {
+    if (!TimingPhases()) return;
+    uint64_t now = trpc::GetSteadyMicroSeconds();
+    phases_.*phase += now - phase_begin_us_;
+    phase_begin_us_ = now;
+  }
+
+  void NotifyObserver(const std::string& query, size_t arg_count, int error_number) {
+    if (call_phases_ != nullptr) call_phases_->Add(phases_);
+    if (observer_ != nullptr) observer_->OnStatement(query, arg_count, phases_, error_number);
+  }
+
  private:
   /// Just protects the `mysql_init` api
   /// Official documentation: “In a nonmultithreaded environment, the call to mysql_library_init() may be omitted,
@@ -253,15 +437,104 @@ class MysqlExecutor : public RefCounted<MysqlExecutor> {
   // by-default: https://dev.mysql.com/doc/refman/8.4/en/innodb-autocommit-commit-rollback.html
   bool auto_commit_{true};
 
+  // Set when a statement may leave state in the session (e.g. user variables).
+  bool session_dirty_{false};
+
+  // "START TRANSACTION" is deferred to the next statement.
+  bool begin_pending_{false};
+
+  // Statements of the cursors open on the connection by id, see MysqlCursor. Those left open are freed when the
+  // session is reset or closed.
+  std::unordered_map<uint64_t, std::unique_ptr<MysqlStatement>> cursor_statements_;
+
+  uint64_t next_cursor_id_{0};
+
+  // Tracked GTID of the last write statement.
+  std::string session_gtid_;
+
+  // See SetDeadline.
+  uint64_t deadline_ms_{0};
+
+  // Current network read/write timeout in seconds.
+  unsigned int net_timeout_;
+
+  std::shared_ptr<MysqlStatementObserver> observer_{nullptr};
+
+  // See SetCallPhases.
+  MysqlStatementPhases* call_phases_{nullptr};
+
+  // Phases of the current statement, only timed with an observer or call phases.
+  MysqlStatementPhases phases_;
+
+  uint64_t phase_begin_us_{0};
+
   MYSQL* mysql_{nullptr};
 
   uint64_t m_alivetime{0};
 
   uint64_t executor_id_{0};
 
+  uint32_t generation_{0};
+
   MysqlConnOption option_;
 };
 
+/// @brief A read-only server-side cursor, see MysqlExecutor::OpenCursor.
+/// @note The cursor is a statement of the connection which opened it, which keeps the statement. It must be closed
+/// before the connection is used by someone else, e.g. before the end of the transaction it runs in.
+template <typename... OutputArgs>
+class MysqlCursor {
+  friend class MysqlExecutor;
+
+ public:
+  /// @param fetch_rows Rows of each batch, also sent as STMT_ATTR_PREFETCH_ROWS so that a batch is one round trip.
+  explicit MysqlCursor(unsigned long fetch_rows = 1000) : fetch_rows_(std::max(fetch_rows, 1UL)) {}
+
+  /// @brief Does not close the cursor: its statement lives on the connection of the transaction, which may be used
+  /// by another thread by now. Close it with CloseCursor (see MysqlServiceProxy). A cursor left open is logged, its
+  /// statement is freed by the connection when the session is reset (see MysqlExecutor::ResetConnection) or closed.
+  ~MysqlCursor() {
+    if (executor_ == nullptr) return;
+    TRPC_FMT_ERROR("mysql cursor destroyed while open, close it with CloseCursor before the transaction ends.");
+  }
+
+  MysqlCursor(const MysqlCursor&) = delete;
+
+  MysqlCursor& operator=(const MysqlCursor&) = delete;
+
+  bool IsOpen() const { return executor_ != nullptr; }
+
+  /// @brief Whether all the rows have been fetched.
+  bool Done() const { return done_; }
+
+  unsigned long GetFetchRows() const { return fetch_rows_; }
+
+  /// @brief Closes the statement, and so the cursor, on the server. Runs on the connection, like FetchCursor.
+  void Close() {
+    if (executor_ == nullptr) return;
+    // Freed by the connection already if its session has been reset meanwhile.
+    executor_->CloseCursorStatement(cursor_id_);
+    handle_.reset();
+    executor_ = nullptr;
+  }
+
+ private:
+  unsigned long fetch_rows_;
+
+  bool done_{false};
+
+  /// Id of the statement in the connection, see MysqlExecutor::FindCursorStatement.
+  uint64_t cursor_id_{0};
+
+  /// The connection of the statement, while open.
+  RefPtr<MysqlExecutor> executor_;
+
+  /// Output buffers, bound once and reused by every fetch.
+  std::unique_ptr<MysqlExecutor::QueryHandle<OutputArgs...>> handle_;
+
+  std::vector<std::string> fields_name_;
+};
+
 template <typename... OutputArgs>
 MysqlExecutor::QueryHandle<OutputArgs...>::QueryHandle(MysqlResults<OutputArgs...>* mysql_results,
                                                        MysqlStatement* statement, size_t field_count)
@@ -295,7 +568,14 @@ bool MysqlExecutor::QueryAll(MysqlResults<OutputArgs...>& mysql_results, const s
                              const InputArgs&... args) {
   TRPC_ASSERT(MysqlResults<OutputArgs...>::mode != MysqlResultsMode::OnlyExec);
 
-  if (!QueryAllInternal(mysql_results, query, args...)) return false;
+  // User variables ("@var") and SET live in the session, the connection is reset before it is pooled again.
+  if (WritesSessionState(query)) session_dirty_ = true;
+
+  std::string hinted_query = deadline_ms_ != 0 ? AddExecutionTimeHint(query) : std::string();
+  BeginPhases();
+  bool ok = QueryAllInternal(mysql_results, hinted_query.empty() ? query : hinted_query, args...);
+  NotifyObserver(query, sizeof...(InputArgs), ok ? 0 : mysql_results.GetErrorNumber());
+  if (!ok) return false;
 
   mysql_results.has_value_ = true;
   return true;
@@ -303,16 +583,99 @@ bool MysqlExecutor::QueryAll(MysqlResults<OutputArgs...>& mysql_results, const s
 
 template <typename... InputArgs>
 bool MysqlExecutor::Execute(MysqlResults<OnlyExec>& mysql_results, const std::string& query, const InputArgs&... args) {
+  if (WritesSessionState(query)) session_dirty_ = true;
+
+  BeginPhases();
   size_t affected_rows = ExecuteInternal(query, mysql_results, args...);
   mysql_results.SetAffectedRows(affected_rows);
+  phases_.rows = affected_rows;
+  NotifyObserver(query, sizeof...(InputArgs), mysql_results.GetErrorNumber());
   return true;
 }
 
+template <typename... InputArgs, typename... OutputArgs>
+bool MysqlExecutor::OpenCursor(MysqlCursor<OutputArgs...>& cursor, MysqlResults<OutputArgs...>& mysql_results,
+                               const std::string& query, const InputArgs&... args) {
+  static_assert(MysqlResults<OutputArgs...>::mode == MysqlResultsMode::BindType, "Only BindType results for cursors");
+
+  if (WritesSessionState(query)) session_dirty_ = true;
+
+  BeginPhases();
+  bool ok = OpenCursorInternal(cursor, mysql_results, query, args...);
+  NotifyObserver(query, sizeof...(InputArgs), ok ? 0 : mysql_results.GetErrorNumber());
+  return ok;
+}
+
+template <typename... OutputArgs>
+bool MysqlExecutor::FetchCursor(MysqlCursor<OutputArgs...>& cursor, MysqlResults<OutputArgs...>& mysql_results) {
+  auto& results = mysql_results.MutableResultSet();
+  auto& res_null_flags = mysql_results.null_flags_;
+  mysql_results.SetErrorNumber(0);
+  mysql_results.SetErrorMessage(std::string());
+  if (!cursor.IsOpen()) {
+    mysql_results.SetErrorNumber(TrpcMysqlRetCode::TRPC_MYSQL_STMT_PARAMS_ERROR);
+    mysql_results.SetErrorMessage("The cursor is not open.");
+    return false;
+  }
+  if (cursor.executor_.Get() != this || FindCursorStatement(cursor.cursor_id_) == nullptr) {
+    mysql_results.SetErrorNumber(TrpcMysqlRetCode::TRPC_MYSQL_STMT_PARAMS_ERROR);
+    mysql_results.SetErrorMessage("The cursor was not opened on this session.");
+    return false;
+  }
+
+  auto& handle = *cursor.handle_;
+  size_t rows = 0;
+  bool ok = true;
+  while (!cursor.done_ && rows < cursor.fetch_rows_) {
+    int status = mysql_stmt_fetch(handle.statement->STMTPointer());
+    if (status == MYSQL_NO_DATA) {
+      cursor.done_ = true;
+      break;
+    }
+    if (status == 1) {
+      mysql_results.SetErrorMessage(handle.statement->GetErrorMessage());
+      mysql_results.SetErrorNumber(handle.statement->GetErrorNumber());
+      ok = false;
+      break;
+    }
+    if (status == MYSQL_DATA_TRUNCATED && !FetchTruncatedResults(handle)) {
+      mysql_results.SetErrorMessage(handle.statement->GetErrorMessage());
+      mysql_results.SetErrorNumber(handle.statement->GetErrorNumber());
+      ok = false;
+      break;
+    }
+
+    if (rows == results.size()) results.emplace_back();
+    SetResultTuple(results[rows], *handle.output_binds);
+    if (rows == res_null_flags.size()) {
+      res_null_flags.emplace_back(*handle.null_flag_buffer);
+    } else {
+      res_null_flags[rows].assign(handle.null_flag_buffer->begin(), handle.null_flag_buffer->end());
+    }
+    ++rows;
+  }
+
+  results.erase(results.begin() + rows, results.end());
+  res_null_flags.erase(res_null_flags.begin() + rows, res_null_flags.end());
+  if (mysql_results.fields_name_.empty()) mysql_results.fields_name_ = cursor.fields_name_;
+  mysql_results.has_value_ = ok;
+  return ok;
+}
+
 template <typename... InputArgs>
 void MysqlExecutor::BindInputArgs(std::vector<MYSQL_BIND>& params, const InputArgs&... args) {
   BindInputImpl(params, args...);
 }
 
+template <typename... InputArgs>
+std::string MysqlExecutor::ExpandInputLists(const std::string& query, const InputArgs&... args) {
+  if constexpr (kHasInputList<InputArgs...>) {
+    return ExpandListMarkers(query, {InputBindCount(args)...});
+  } else {
+    return std::string();
+  }
+}
+
 template <typename... OutputArgs>
 void MysqlExecutor::BindOutputs(MysqlExecutor::QueryHandle<OutputArgs...>& handle) {
   // 1. Set the buffer type
@@ -338,9 +701,18 @@ bool MysqlExecutor::QueryAllInternal(MysqlResults<OutputArgs...>& mysql_results,
   mysql_results.Clear();
   std::vector<MYSQL_BIND> input_binds;
 
+  if (!FlushPendingBegin()) {
+    mysql_results.SetErrorMessage(GetErrorMessage());
+    mysql_results.SetErrorNumber(GetErrorNumber());
+    return false;
+  }
+
   MysqlStatement stmt(mysql_);
 
-  if (!stmt.Init(query)) {
+  std::string expanded_query = ExpandInputLists(query, args...);
+  bool prepared = stmt.Init(expanded_query.empty() ? query : expanded_query);
+  EndPhase(&MysqlStatementPhases::prepare_us);
+  if (!prepared) {
     mysql_results.SetErrorMessage(stmt.GetErrorMessage());
     mysql_results.SetErrorNumber(stmt.GetErrorNumber());
     stmt.CloseStatement();
@@ -369,6 +741,7 @@ bool MysqlExecutor::QueryAllInternal(MysqlResults<OutputArgs...>& mysql_results,
   BindOutputs<OutputArgs...>(handle);
 
   Status s = ExecuteStatement(*handle.output_binds, stmt);
+  EndPhase(&MysqlStatementPhases::execute_us);
   if (!s.OK()) {
     mysql_results.SetErrorMessage(s.ErrorMessage());
     mysql_results.SetErrorNumber(s.GetFrameworkRetCode());
@@ -388,6 +761,71 @@ bool MysqlExecutor::QueryAllInternal(MysqlResults<OutputArgs...>& mysql_results,
   return true;
 }
 
+template <typename... InputArgs, typename... OutputArgs>
+bool MysqlExecutor::OpenCursorInternal(MysqlCursor<OutputArgs...>& cursor, MysqlResults<OutputArgs...>& mysql_results,
+                                       const std::string& query, const InputArgs&... args) {
+  cursor.Close();
+  cursor.done_ = false;
+  mysql_results.Clear();
+
+  if (!FlushPendingBegin()) {
+    mysql_results.SetErrorMessage(GetErrorMessage());
+    mysql_results.SetErrorNumber(GetErrorNumber());
+    return false;
+  }
+
+  auto stmt = std::make_unique<MysqlStatement>(mysql_);
+  auto fail = [&mysql_results, &stmt, &cursor](std::string message, int error_number) {
+    mysql_results.SetErrorMessage(std::move(message));
+    mysql_results.SetErrorNumber(error_number);
+    cursor.handle_.reset();
+    stmt->CloseStatement();
+    return false;
+  };
+
+  std::string expanded_query = ExpandInputLists(query, args...);
+  bool prepared = stmt->Init(expanded_query.empty() ? query : expanded_query);
+  EndPhase(&MysqlStatementPhases::prepare_us);
+  if (!prepared) return fail(stmt->GetErrorMessage(), stmt->GetErrorNumber());
+
+  MYSQL_RES* meta = stmt->GetResultsMeta();
+  std::string field_type_check_message = CheckFieldsOutputArgs<OutputArgs...>(meta);
+  if (!field_type_check_message.empty()) {
+    mysql_free_result(meta);
+    return fail(std::move(field_type_check_message), TrpcMysqlRetCode::TRPC_MYSQL_STMT_PARAMS_ERROR);
+  }
+  mysql_results.SetFieldsName(meta);
+  mysql_free_result(meta);
+
+  unsigned long cursor_type = CURSOR_TYPE_READ_ONLY;
+  unsigned long prefetch_rows = cursor.fetch_rows_;
+  if (mysql_stmt_attr_set(stmt->STMTPointer(), STMT_ATTR_CURSOR_TYPE, &cursor_type) ||
+      mysql_stmt_attr_set(stmt->STMTPointer(), STMT_ATTR_PREFETCH_ROWS, &prefetch_rows)) {
+    return fail(stmt->GetErrorMessage(), stmt->GetErrorNumber());
+  }
+
+  std::vector<MYSQL_BIND> input_binds;
+  BindInputArgs(input_binds, args...);
+  if (!stmt->BindParam(input_binds)) return fail(stmt->GetErrorMessage(), stmt->GetErrorNumber());
+
+  cursor.handle_ =
+      std::make_unique<QueryHandle<OutputArgs...>>(&mysql_results, stmt.get(), stmt->GetFieldCount());
+  // `mysql_results` may not outlive this call, FetchCursor is given the results to fill.
+  cursor.handle_->mysql_results = nullptr;
+  BindOutputs<OutputArgs...>(*cursor.handle_);
+
+  // Without mysql_stmt_store_result, the rows stay on the server until fetched.
+  Status s = ExecuteStatement(*cursor.handle_->output_binds, *stmt);
+  EndPhase(&MysqlStatementPhases::execute_us);
+  if (!s.OK()) return fail(s.ErrorMessage(), s.GetFrameworkRetCode());
+
+  cursor.fields_name_ = mysql_results.GetFieldsName();
+  cursor.cursor_id_ = AddCursorStatement(std::move(stmt));
+  cursor.executor_ = RefPtr<MysqlExecutor>(ref_ptr, this);
+  mysql_results.has_value_ = true;
+  return true;
+}
+
 template <typename... InputArgs>
 bool MysqlExecutor::QueryAllInternal(MysqlResults<NativeString>& mysql_result, const std::string& query,
                                      const InputArgs&... args) {
@@ -396,13 +834,16 @@ bool MysqlExecutor::QueryAllInternal(MysqlResults<NativeString>& mysql_result, c
   MYSQL_ROW row;
   auto& results = mysql_result.MutableResultSet();
 
-  if (mysql_real_query(mysql_, query_str.c_str(), query_str.length())) {
+  bool executed = RealQuery(query_str);
+  EndPhase(&MysqlStatementPhases::execute_us);
+  if (!executed) {
     mysql_result.SetErrorMessage(GetErrorMessage());
     mysql_result.SetErrorNumber(GetErrorNumber());
     return false;
   }
 
   MYSQL_RES* res_ptr = mysql_store_result(mysql_);
+  EndPhase(&MysqlStatementPhases::fetch_us);
   if (res_ptr == nullptr) {
     mysql_result.SetErrorMessage(GetErrorMessage());
     mysql_result.SetErrorNumber(GetErrorNumber());
@@ -427,6 +868,9 @@ bool MysqlExecutor::QueryAllInternal(MysqlResults<NativeString>& mysql_result, c
     }
   }
 
+  phases_.rows = results.size();
+  EndPhase(&MysqlStatementPhases::decode_us);
+
   mysql_result.SetRawMysqlRes(res_ptr);
   mysql_result.SetFieldsName(res_ptr);
   return true;
@@ -435,6 +879,7 @@ bool MysqlExecutor::QueryAllInternal(MysqlResults<NativeString>& mysql_result, c
 template <typename... OutputArgs>
 bool MysqlExecutor::FetchResults(MysqlExecutor::QueryHandle<OutputArgs...>& handle) {
   if (mysql_stmt_store_result(handle.statement->STMTPointer()) != 0) return false;
+  EndPhase(&MysqlStatementPhases::fetch_us);
 
   int status = 0;
   auto& results = handle.mysql_results->MutableResultSet();
@@ -443,9 +888,10 @@ bool MysqlExecutor::FetchResults(MysqlExecutor::QueryHandle<OutputArgs...>& hand
     status = mysql_stmt_fetch(handle.statement->STMTPointer());
     if (status == 1 || status == MYSQL_NO_DATA) break;
 
-    if (status == MYSQL_DATA_TRUNCATED) {
-      // https://dev.mysql.com/doc/c-api/8.0/en/mysql-stmt-fetch.html
-      FetchTruncatedResults(handle);
+    // https://dev.mysql.com/doc/c-api/8.0/en/mysql-stmt-fetch.html
+    if (status == MYSQL_DATA_TRUNCATED && !FetchTruncatedResults(handle)) {
+      status = 1;
+      break;
     }
 
     std::tuple<OutputArgs...> row_res;
@@ -453,6 +899,8 @@ bool MysqlExecutor::FetchResults(MysqlExecutor::QueryHandle<OutputArgs...>& hand
     results.push_back(std::move(row_res));
     res_null_flags.emplace_back(*handle.null_flag_buffer);
   }
+  phases_.rows = results.size();
+  EndPhase(&MysqlStatementPhases::decode_us);
 
   if (status == 1) return false;
   return true;
@@ -460,6 +908,7 @@ bool MysqlExecutor::FetchResults(MysqlExecutor::QueryHandle<OutputArgs...>& hand
 
 template <typename... OutputArgs>
 bool MysqlExecutor::FetchTruncatedResults(MysqlExecutor::QueryHandle<OutputArgs...>& handle) {
+  bool resized = false;
   for (size_t i : handle.dynamic_buffer_index) {
     MYSQL_BIND& bind = handle.output_binds->at(i);
     size_t data_real_size = *(handle.output_binds->at(i).length);
@@ -468,6 +917,7 @@ bool MysqlExecutor::FetchTruncatedResults(MysqlExecutor::QueryHandle<OutputArgs.
     if (data_real_size <= buffer_old_size) continue;
 
     handle.output_buffer->at(i).resize(data_real_size);
+    resized = true;
     bind.buffer_length = data_real_size;
     bind.buffer = handle.output_buffer->at(i).data() + buffer_old_size;
 
@@ -475,17 +925,28 @@ bool MysqlExecutor::FetchTruncatedResults(MysqlExecutor::QueryHandle<OutputArgs.
 
     bind.buffer = handle.output_buffer->at(i).data();
   }
-  return true;
+  // The statement keeps a copy of the binds, which still points to the buffers freed by the resize.
+  return !resized || mysql_stmt_bind_result(handle.statement->STMTPointer(), handle.output_binds->data()) == 0;
 }
 
 template <typename... InputArgs>
 size_t MysqlExecutor::ExecuteInternal(const std::string& query, MysqlResults<OnlyExec>& mysql_results,
                                       const InputArgs&... args) {
   mysql_results.Clear();
+
+  if (!FlushPendingBegin()) {
+    mysql_results.SetErrorMessage(GetErrorMessage());
+    mysql_results.SetErrorNumber(GetErrorNumber());
+    return 0;
+  }
+
   MysqlStatement stmt(mysql_);
   std::vector<MYSQL_BIND> input_binds;
 
-  if (!stmt.Init(query)) {
+  std::string expanded_query = ExpandInputLists(query, args...);
+  bool prepared = stmt.Init(expanded_query.empty() ? query : expanded_query);
+  EndPhase(&MysqlStatementPhases::prepare_us);
+  if (!prepared) {
     mysql_results.SetErrorMessage(stmt.GetErrorMessage());
     mysql_results.SetErrorNumber(stmt.GetErrorNumber());
     stmt.CloseStatement();
@@ -501,6 +962,7 @@ size_t MysqlExecutor::ExecuteInternal(const std::string& query, MysqlResults<Onl
   }
 
   Status s = ExecuteStatement(stmt);
+  EndPhase(&MysqlStatementPhases::execute_us);
   if (!s.OK()) {
     mysql_results.SetErrorMessage(s.ErrorMessage());
     mysql_results.SetErrorNumber(s.GetFrameworkRetCode());
@@ -509,6 +971,7 @@ size_t MysqlExecutor::ExecuteInternal(const std::string& query, MysqlResults<Onl
   }
 
   size_t affected_row = mysql_affected_rows(mysql_);
+  CaptureSessionGtid();
 
   stmt.CloseStatement();
   return affected_row;
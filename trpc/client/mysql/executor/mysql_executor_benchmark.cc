@@ -0,0 +1,227 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+// Microbenchmarks of the client side hot path of a statement: binding the arguments and the outputs, checking the
+// field types, decoding the rows, formatting text protocol queries, and handing the results over.
+// No MySQL server is needed, the MYSQL_BIND and MYSQL_FIELD data are synthetic.
+// The argument of the row benchmarks is the number of rows.
+
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "trpc/client/mysql/executor/mysql_binder.h"
+#include "trpc/client/mysql/executor/mysql_executor.h"
+#include "trpc/client/mysql/executor/mysql_results.h"
+#include "trpc/client/mysql/executor/mysql_type.h"
+
+namespace trpc::testing {
+
+using mysql::MysqlResults;
+using mysql::MysqlTime;
+using mysql::NativeString;
+
+/// A typical row: id, name, created time and score.
+using Row = std::tuple<int64_t, std::string, MysqlTime, double>;
+
+MysqlTime MakeTime() {
+  MysqlTime time;
+  time.SetYear(2024).SetMonth(9).SetDay(8).SetHour(13).SetMinute(16).SetSecond(24);
+  return time;
+}
+
+Row MakeRow(int64_t id) { return Row{id, "user_" + std::to_string(id) + "@example.com", MakeTime(), id * 0.5}; }
+
+/// Output binds of Row as set up by MysqlExecutor::QueryHandle, holding the values of one fetched row.
+struct OutputBinds {
+  std::vector<MYSQL_BIND> binds;
+  std::vector<std::vector<std::byte>> buffers;
+  std::vector<uint8_t> null_flags;
+  std::vector<unsigned long> lengths;
+
+  OutputBinds() : binds(4), buffers(4), null_flags(4), lengths(4) {
+    std::memset(binds.data(), 0, sizeof(MYSQL_BIND) * binds.size());
+    for (size_t i = 0; i < binds.size(); ++i) binds[i].length = &lengths[i];
+    mysql::BindOutputImpl<int64_t, std::string, MysqlTime, double>(binds, buffers, null_flags);
+
+    // What mysql_stmt_fetch writes into the buffers.
+    Row row = MakeRow(42);
+    *static_cast<int64_t*>(binds[0].buffer) = std::get<0>(row);
+    std::memcpy(binds[1].buffer, std::get<1>(row).data(), std::get<1>(row).size());
+    lengths[1] = std::get<1>(row).size();
+    *static_cast<MysqlTime*>(binds[2].buffer) = std::get<2>(row);
+    *static_cast<double*>(binds[3].buffer) = std::get<3>(row);
+  }
+};
+
+void BM_BindInput(benchmark::State& state) {
+  int64_t id = 42;
+  std::string name = "alice";
+  MysqlTime time = MakeTime();
+  double score = 0.5;
+  std::vector<MYSQL_BIND> binds;
+  for (auto _ : state) {
+    mysql::BindInputImpl(binds, id, name, time, score);
+    benchmark::DoNotOptimize(binds.data());
+  }
+}
+
+void BM_BindInputList(benchmark::State& state) {
+  std::vector<int64_t> ids(state.range(0));
+  for (size_t i = 0; i < ids.size(); ++i) ids[i] = i;
+  std::vector<MYSQL_BIND> binds;
+  for (auto _ : state) {
+    mysql::BindInputImpl(binds, ids);
+    benchmark::DoNotOptimize(binds.data());
+  }
+  state.SetItemsProcessed(state.iterations() * ids.size());
+}
+
+void BM_BindOutput(benchmark::State& state) {
+  std::vector<MYSQL_BIND> binds(4);
+  std::vector<std::vector<std::byte>> buffers(4);
+  std::vector<uint8_t> null_flags(4);
+  for (auto _ : state) {
+    mysql::BindOutputImpl<int64_t, std::string, MysqlTime, double>(binds, buffers, null_flags);
+    benchmark::DoNotOptimize(binds.data());
+  }
+}
+
+void BM_CheckFieldsOutputArgs(benchmark::State& state) {
+  char names[4][8] = {"id", "name", "created", "score"};
+  enum_field_types types[4] = {MYSQL_TYPE_LONGLONG, MYSQL_TYPE_VAR_STRING, MYSQL_TYPE_DATETIME, MYSQL_TYPE_DOUBLE};
+  std::vector<MYSQL_FIELD> fields(4);
+  std::memset(fields.data(), 0, sizeof(MYSQL_FIELD) * fields.size());
+  for (size_t i = 0; i < fields.size(); ++i) {
+    fields[i].name = names[i];
+    fields[i].type = types[i];
+  }
+  MYSQL_RES res;
+  std::memset(&res, 0, sizeof(res));
+  res.fields = fields.data();
+  res.field_count = fields.size();
+
+  for (auto _ : state) {
+    std::string error = mysql::CheckFieldsOutputArgs<int64_t, std::string, MysqlTime, double>(&res);
+    benchmark::DoNotOptimize(error);
+  }
+}
+
+void BM_SetResultTuple(benchmark::State& state) {
+  OutputBinds output;
+  std::vector<Row> rows;
+  rows.reserve(state.range(0));
+  for (auto _ : state) {
+    // Decodes a result set the way MysqlExecutor::FetchResults does, row by row.
+    rows.clear();
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      Row row;
+      mysql::SetResultTuple(row, output.binds);
+      rows.push_back(std::move(row));
+    }
+    benchmark::DoNotOptimize(rows.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_FormatQuery(benchmark::State& state) {
+  std::string query = "select id, name from users where id = ? and name = ? and created_at > ? and score < ?";
+  std::string name = "alice";
+  MysqlTime time = MakeTime();
+  for (auto _ : state) {
+    std::string sql = mysql::Formatter::FormatQuery(query, 42, name, time, 0.5);
+    benchmark::DoNotOptimize(sql);
+  }
+}
+
+void BM_MysqlTimeToString(benchmark::State& state) {
+  MysqlTime time = MakeTime();
+  for (auto _ : state) {
+    std::string str = time.ToString();
+    benchmark::DoNotOptimize(str);
+  }
+}
+
+void BM_MysqlTimeFromString(benchmark::State& state) {
+  std::string str = MakeTime().ToString();
+  MysqlTime time;
+  for (auto _ : state) {
+    time.FromString(str);
+    benchmark::DoNotOptimize(time);
+  }
+}
+
+void BM_ResultsMove(benchmark::State& state) {
+  std::vector<Row> rows;
+  for (int64_t i = 0; i < state.range(0); ++i) rows.push_back(MakeRow(i));
+  MysqlResults<int64_t, std::string, MysqlTime, double> res;
+  res.SetResultSet(std::move(rows));
+  for (auto _ : state) {
+    // As when the results are returned through a future.
+    MysqlResults<int64_t, std::string, MysqlTime, double> moved(std::move(res));
+    res = std::move(moved);
+    benchmark::DoNotOptimize(res);
+  }
+}
+
+void BM_GetResultSet(benchmark::State& state) {
+  std::vector<Row> rows;
+  for (int64_t i = 0; i < state.range(0); ++i) rows.push_back(MakeRow(i));
+  MysqlResults<int64_t, std::string, MysqlTime, double> res;
+  for (auto _ : state) {
+    res.SetResultSet(std::move(rows));
+    res.GetResultSet(rows);
+    benchmark::DoNotOptimize(rows.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_GetResultSetNativeString(benchmark::State& state) {
+  std::vector<std::string> values;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    values.push_back(std::to_string(i));
+    values.push_back("user_" + std::to_string(i) + "@example.com");
+  }
+  std::vector<std::vector<std::string_view>> native_rows;
+  for (size_t i = 0; i < values.size(); i += 2) native_rows.push_back({values[i], values[i + 1]});
+
+  MysqlResults<NativeString> res;
+  res.SetResultSet(native_rows);
+  std::vector<std::vector<std::string>> rows;
+  for (auto _ : state) {
+    // Copies each value out of the MYSQL_RES.
+    res.GetResultSet(rows);
+    benchmark::DoNotOptimize(rows.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_BindInput);
+BENCHMARK(BM_BindInputList)->RangeMultiplier(8)->Range(1, 512);
+BENCHMARK(BM_BindOutput);
+BENCHMARK(BM_CheckFieldsOutputArgs);
+BENCHMARK(BM_SetResultTuple)->RangeMultiplier(8)->Range(1, 4096);
+BENCHMARK(BM_FormatQuery);
+BENCHMARK(BM_MysqlTimeToString);
+BENCHMARK(BM_MysqlTimeFromString);
+BENCHMARK(BM_ResultsMove)->Arg(1000);
+BENCHMARK(BM_GetResultSet)->RangeMultiplier(8)->Range(1, 4096);
+BENCHMARK(BM_GetResultSetNativeString)->RangeMultiplier(8)->Range(1, 4096);
+
+}  // namespace trpc::testing
+
+BENCHMARK_MAIN();
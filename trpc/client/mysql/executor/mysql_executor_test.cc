@@ -141,6 +141,75 @@ TEST(Executor, QueryArgs) {
   conn.Close();
 }
 
+TEST(Executor, QueryInList) {
+  trpc::mysql::MysqlExecutor conn(option);
+  trpc::mysql::MysqlResults<int, std::string> res;
+  conn.Connect();
+  std::vector<int> ids{3, 1, 4};
+  conn.QueryAll(res, "select id, username from users where id in (?) and username != ? order by id", ids, "rose");
+
+  auto& res_data = res.ResultSet();
+  ASSERT_TRUE(res.OK());
+  ASSERT_EQ(2, res_data.size());
+  EXPECT_EQ("alice", std::get<1>(res_data[0]));
+  EXPECT_EQ("carol", std::get<1>(res_data[1]));
+
+  conn.QueryAll(res, "select id, username from users where id in (?)", std::vector<int>{});
+  ASSERT_TRUE(res.OK());
+  EXPECT_TRUE(res.ResultSet().empty());
+  conn.Close();
+}
+
+TEST(Executor, Cursor) {
+  trpc::mysql::MysqlExecutor conn(option);
+  trpc::mysql::MysqlResults<int, std::string> all;
+  conn.Connect();
+  conn.QueryAll(all, "select id, username from users where id > ? order by id", 0);
+  ASSERT_TRUE(all.OK());
+
+  // Fetch two rows at a time, the batches reuse the rows of `res`.
+  trpc::mysql::MysqlCursor<int, std::string> cursor(2);
+  trpc::mysql::MysqlResults<int, std::string> res;
+  ASSERT_TRUE(conn.OpenCursor(cursor, res, "select id, username from users where id > ? order by id", 0));
+  // A cursor left open would be reset with the session.
+  EXPECT_TRUE(conn.NeedReset());
+  std::vector<std::tuple<int, std::string>> rows;
+  while (!cursor.Done()) {
+    ASSERT_TRUE(conn.FetchCursor(cursor, res));
+    EXPECT_LE(res.ResultSet().size(), 2);
+    rows.insert(rows.end(), res.ResultSet().begin(), res.ResultSet().end());
+  }
+  EXPECT_EQ(all.ResultSet(), rows);
+  cursor.Close();
+  EXPECT_FALSE(cursor.IsOpen());
+  EXPECT_FALSE(conn.NeedReset());
+
+  EXPECT_FALSE(conn.FetchCursor(cursor, res));
+
+  // One byte buffers, every string is truncated and its buffer grown between the fetches.
+  trpc::mysql::MysqlResultsOption small_buffers;
+  small_buffers.dynamic_buffer_init_size = 1;
+  trpc::mysql::MysqlResults<int, std::string> truncated(small_buffers);
+  ASSERT_TRUE(conn.OpenCursor(cursor, truncated, "select id, username from users where id > ? order by id", 0));
+  rows.clear();
+  while (!cursor.Done()) {
+    ASSERT_TRUE(conn.FetchCursor(cursor, truncated));
+    rows.insert(rows.end(), truncated.ResultSet().begin(), truncated.ResultSet().end());
+  }
+  EXPECT_EQ(all.ResultSet(), rows);
+  cursor.Close();
+
+  // A cursor left open is freed with the session, it can still be closed afterwards.
+  ASSERT_TRUE(conn.OpenCursor(cursor, res, "select id, username from users where id > ? order by id", 0));
+  ASSERT_TRUE(conn.ResetConnection());
+  EXPECT_FALSE(conn.NeedReset());
+  EXPECT_TRUE(cursor.IsOpen());
+  EXPECT_FALSE(conn.FetchCursor(cursor, res));
+  cursor.Close();
+  EXPECT_FALSE(cursor.IsOpen());
+  conn.Close();
+}
+
 TEST(Executor, Update) {
   trpc::mysql::MysqlExecutor conn(option);
   trpc::mysql::MysqlResults<trpc::mysql::OnlyExec> res;
@@ -283,6 +352,96 @@ TEST(Executor, Transaction) {
   conn.Close();
 }
 
+TEST(Executor, ResetConnection) {
+  mysql::MysqlExecutor conn(option);
+  mysql::MysqlResults<mysql::OnlyExec> exec_res;
+  mysql::MysqlResults<mysql::NativeString> query_res;
+
+  conn.Connect();
+  EXPECT_FALSE(conn.NeedReset());
+
+  conn.Execute(exec_res, "begin");
+  conn.Execute(exec_res, "update users set email = ? where username = ?", "rose@abc.com", "rose");
+  EXPECT_EQ(1, exec_res.GetAffectedRowNum());
+  EXPECT_TRUE(conn.NeedReset());
+
+  // The open transaction is rolled back by the reset.
+  EXPECT_TRUE(conn.ResetConnection());
+  EXPECT_FALSE(conn.NeedReset());
+  conn.QueryAll(query_res, "select email from users where username = ?", "rose");
+  EXPECT_EQ(true, query_res.IsValueNull(0, 0));
+
+  conn.QueryAll(query_res, "set @uid = ?", 1);
+  EXPECT_TRUE(conn.NeedReset());
+  EXPECT_TRUE(conn.ResetConnection());
+  conn.QueryAll(query_res, "select @uid");
+  EXPECT_EQ(true, query_res.IsValueNull(0, 0));
+
+  conn.AutoCommit(false);
+  EXPECT_TRUE(conn.NeedReset());
+  EXPECT_TRUE(conn.ResetConnection());
+  EXPECT_FALSE(conn.NeedReset());
+
+  conn.Close();
+}
+
+TEST(Executor, DeferredBegin) {
+  mysql::MysqlConnOption multi_option = option;
+  multi_option.multi_statements = true;
+
+  for (auto& conn_option : {option, multi_option}) {
+    mysql::MysqlExecutor conn(conn_option);
+    mysql::MysqlResults<mysql::OnlyExec> exec_res;
+    mysql::MysqlResults<mysql::NativeString> query_res;
+
+    conn.Connect();
+    conn.SetBeginPending(true);
+    conn.QueryAll(query_res, "select email from users where username = ?", "rose");
+    EXPECT_TRUE(query_res.OK());
+    EXPECT_FALSE(conn.IsBeginPending());
+    EXPECT_EQ(1, query_res.ResultSet().size());
+
+    conn.Execute(exec_res, "update users set email = ? where username = ?", "rose@abc.com", "rose");
+    EXPECT_EQ(1, exec_res.GetAffectedRowNum());
+    conn.Execute(exec_res, "rollback");
+    EXPECT_TRUE(exec_res.OK());
+
+    conn.QueryAll(query_res, "select email from users where username = ?", "rose");
+    EXPECT_EQ(true, query_res.IsValueNull(0, 0));
+
+    conn.Close();
+  }
+}
+
+TEST(Executor, TransactionScript) {
+  mysql::MysqlConnOption multi_option = option;
+  multi_option.multi_statements = true;
+
+  for (auto& conn_option : {option, multi_option}) {
+    mysql::MysqlExecutor conn(conn_option);
+    mysql::MysqlResults<mysql::OnlyExec> exec_res;
+    mysql::MysqlResults<mysql::NativeString> query_res;
+
+    conn.Connect();
+    std::vector<std::string> statements = {"insert into users (username, email) values ('jack', 'jack@abc.com')",
+                                           "update users set email = 'jack@def.com' where username = 'jack'"};
+    EXPECT_TRUE(conn.ExecuteTransaction(exec_res, statements));
+    EXPECT_EQ(2, exec_res.GetAffectedRowNum());
+    EXPECT_TRUE(conn.ExecuteTransaction(exec_res, {"delete from users where username = 'jack'"}));
+    EXPECT_EQ(1, exec_res.GetAffectedRowNum());
+
+    // The second statement fails, the first one is rolled back.
+    EXPECT_FALSE(conn.ExecuteTransaction(
+        exec_res, {"update users set email = 'x@abc.com' where username = 'rose'", "update userss set email = ''"}));
+    EXPECT_FALSE(exec_res.OK());
+    EXPECT_FALSE(conn.NeedReset());
+    conn.QueryAll(query_res, "select email from users where username = ?", "rose");
+    EXPECT_EQ(true, query_res.IsValueNull(0, 0));
+
+    conn.Close();
+  }
+}
+
 TEST(Executor, GetResultSet) {
   mysql::MysqlExecutor conn(option);
 
@@ -300,4 +459,34 @@ TEST(Executor, GetResultSet) {
   EXPECT_EQ(true, res2.GetResultSet(res2_vec));
 }
 
+// No server needed.
+TEST(Executor, ExecutionTimeHint) {
+  EXPECT_EQ("select /*+ MAX_EXECUTION_TIME(250) */ id from users",
+            mysql::MysqlExecutor::AddExecutionTimeHint("select id from users", 250));
+  EXPECT_EQ("  SELECT /*+ MAX_EXECUTION_TIME(1) */\n* from users",
+            mysql::MysqlExecutor::AddExecutionTimeHint("  SELECT\n* from users", 1));
+
+  // Not a SELECT, or already hinted.
+  EXPECT_EQ("", mysql::MysqlExecutor::AddExecutionTimeHint("update users set email = ''", 250));
+  EXPECT_EQ("", mysql::MysqlExecutor::AddExecutionTimeHint("selection", 250));
+  EXPECT_EQ("", mysql::MysqlExecutor::AddExecutionTimeHint("select", 250));
+  EXPECT_EQ("", mysql::MysqlExecutor::AddExecutionTimeHint("   ", 250));
+  EXPECT_EQ("", mysql::MysqlExecutor::AddExecutionTimeHint("select /*+ MAX_EXECUTION_TIME(10) */ 1", 250));
+}
+
+TEST(Executor, NetTimeout) {
+  unsigned int default_timeout = mysql::MysqlExecutor::GetNetTimeout(0, 1000);
+  EXPECT_EQ(5u, default_timeout);
+
+  // Rounded up to whole seconds.
+  EXPECT_EQ(1u, mysql::MysqlExecutor::GetNetTimeout(1001, 1000));
+  EXPECT_EQ(2u, mysql::MysqlExecutor::GetNetTimeout(2001, 1000));
+  EXPECT_EQ(2u, mysql::MysqlExecutor::GetNetTimeout(3000, 1000));
+  // Past deadline, at least one second.
+  EXPECT_EQ(1u, mysql::MysqlExecutor::GetNetTimeout(1000, 1000));
+  EXPECT_EQ(1u, mysql::MysqlExecutor::GetNetTimeout(500, 1000));
+  // Never above the default one.
+  EXPECT_EQ(default_timeout, mysql::MysqlExecutor::GetNetTimeout(1000 + 60 * 1000, 1000));
+}
+
 }  // namespace trpc::testing
\ No newline at end of file
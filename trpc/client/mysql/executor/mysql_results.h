@@ -83,6 +83,8 @@ template <typename... Args>
 class MysqlResults {
   friend class MysqlExecutor;
 
+  friend class MysqlResultsMerger;
+
  public:
   static constexpr MysqlResultsMode mode = ResultSetMapper<Args...>::mode;
 
@@ -103,6 +105,15 @@ class MysqlResults {
 
   ~MysqlResults();
 
+  /// @brief Copies the rows, null flags, field names and error of `other`, e.g. to share cached results.
+  /// @note Not available for NativeString results, whose rows point into the MYSQL_RES of `other`.
+  void CopyFrom(const MysqlResults& other);
+
+  /// @brief Replaces the results with rows built by the caller, none of their values NULL. E.g. for the results of
+  /// a mocked call in tests, or for benchmarks without a server.
+  /// @note The string views of NativeString rows must outlive the results.
+  void SetResultSet(ResultSetType rows);
+
   auto& MutableResultSet();
 
   const auto& ResultSet() const;
@@ -186,6 +197,7 @@ MysqlResults<Args...>& MysqlResults<Args...>::operator=(MysqlResults&& other) no
     result_set_ = std::move(other.result_set_);
     fields_name_ = std::move(other.fields_name_);
     null_flags_ = std::move(other.null_flags_);
+    error_number_ = other.error_number_;
     error_message_ = std::move(other.error_message_);
     affected_rows_ = other.affected_rows_;
     has_value_ = other.has_value_;
@@ -202,6 +214,7 @@ MysqlResults<Args...>::MysqlResults(MysqlResults&& other) noexcept
       result_set_(std::move(other.result_set_)),
       fields_name_(std::move(other.fields_name_)),
       null_flags_(std::move(other.null_flags_)),
+      error_number_(other.error_number_),
       error_message_(std::move(other.error_message_)),
       affected_rows_(other.affected_rows_),
       has_value_(other.has_value_),
@@ -209,6 +222,37 @@ MysqlResults<Args...>::MysqlResults(MysqlResults&& other) noexcept
   other.mysql_res_ = nullptr;
 }
 
+template <typename... Args>
+void MysqlResults<Args...>::CopyFrom(const MysqlResults& other) {
+  static_assert(mode != MysqlResultsMode::NativeString, "NativeString results can not be copied");
+
+  Clear();
+  option_ = other.option_;
+  result_set_ = other.result_set_;
+  fields_name_ = other.fields_name_;
+  null_flags_ = other.null_flags_;
+  error_number_ = other.error_number_;
+  error_message_ = other.error_message_;
+  affected_rows_ = other.affected_rows_;
+  has_value_ = other.has_value_;
+}
+
+template <typename... Args>
+void MysqlResults<Args...>::SetResultSet(ResultSetType rows) {
+  static_assert(mode != MysqlResultsMode::OnlyExec, "OnlyExec results have no rows");
+
+  Clear();
+  null_flags_.reserve(rows.size());
+  for (const auto& row : rows) {
+    if constexpr (mode == MysqlResultsMode::NativeString)
+      null_flags_.emplace_back(row.size(), 0);
+    else
+      null_flags_.emplace_back(sizeof...(Args), 0);
+  }
+  result_set_ = std::move(rows);
+  has_value_ = true;
+}
+
 template <typename... Args>
 void MysqlResults<Args...>::SetRawMysqlRes(MYSQL_RES* res) {
   TRPC_ASSERT(mysql_res_ == nullptr);
@@ -0,0 +1,64 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace trpc::mysql {
+
+/// @brief Durations of the phases of a statement in microseconds.
+struct MysqlStatementPhases {
+  /// mysql_stmt_prepare, 0 for a statement of the text protocol.
+  uint64_t prepare_us{0};
+
+  /// mysql_stmt_execute or mysql_real_query, which includes the execution on the server.
+  uint64_t execute_us{0};
+
+  /// Transfer of the result set to the client (mysql_stmt_store_result or mysql_store_result).
+  uint64_t fetch_us{0};
+
+  /// Decoding of the rows into MysqlResults.
+  uint64_t decode_us{0};
+
+  /// Rows returned by a query, or affected by a write.
+  uint64_t rows{0};
+
+  uint64_t TotalUs() const { return prepare_us + execute_us + fetch_us + decode_us; }
+
+  void Add(const MysqlStatementPhases& other) {
+    prepare_us += other.prepare_us;
+    execute_us += other.execute_us;
+    fetch_us += other.fetch_us;
+    decode_us += other.decode_us;
+    rows += other.rows;
+  }
+};
+
+/// @brief Receives the phases of each statement run by the MysqlExecutors it is set on (see
+/// MysqlExecutor::SetObserver). Called on the thread of the statement, so it must be cheap and thread safe.
+class MysqlStatementObserver {
+ public:
+  virtual ~MysqlStatementObserver() = default;
+
+  /// @param query The statement as given by the caller, with placeholders for the bound arguments.
+  /// @param arg_count Number of bound arguments. Their values are never passed to the observer.
+  /// @param error_number 0 on success.
+  virtual void OnStatement(const std::string& query, size_t arg_count, const MysqlStatementPhases& phases,
+                           int error_number) = 0;
+};
+
+}  // namespace trpc::mysql
@@ -0,0 +1,38 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#include "trpc/client/mysql/mysql_batch_loader.h"
+
+namespace trpc::mysql {
+
+MysqlBatchLoaderBase::MysqlBatchLoaderBase(std::shared_ptr<MysqlServiceProxy> proxy, std::string sql,
+                                           const BatchLoaderOption& option)
+    : proxy_(std::move(proxy)), sql_(std::move(sql)), option_(option) {
+  option_.max_keys = std::clamp<uint32_t>(option_.max_keys, 1, kMaxBatchKeys);
+  timer_.Start();
+}
+
+BatchLoaderStats MysqlBatchLoaderBase::GetStats() const {
+  BatchLoaderStats stats;
+  stats.loads = loads_.load(std::memory_order_relaxed);
+  stats.batches = batches_.load(std::memory_order_relaxed);
+  stats.keys = keys_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void MysqlBatchLoaderBase::CountBatch(size_t keys) {
+  batches_.fetch_add(1, std::memory_order_relaxed);
+  keys_.fetch_add(keys, std::memory_order_relaxed);
+}
+
+}  // namespace trpc::mysql
@@ -0,0 +1,265 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "trpc/client/make_client_context.h"
+#include "trpc/coroutine/fiber.h"
+#include "trpc/coroutine/future.h"
+
+#include "trpc/client/mysql/mysql_results_merger.h"
+#include "trpc/client/mysql/mysql_service_proxy.h"
+#include "trpc/client/mysql/mysql_timer.h"
+
+namespace trpc::mysql {
+
+/// @brief Most keys in one batched statement.
+constexpr uint32_t kMaxBatchKeys = 64;
+
+struct BatchLoaderOption {
+  /// How long the first key of a batch waits for other keys, in milliseconds.
+  uint32_t window_ms{1};
+
+  /// The batch is sent as soon as it has `max_keys` distinct keys, at most kMaxBatchKeys.
+  uint32_t max_keys{kMaxBatchKeys};
+};
+
+/// @brief Counters of a MysqlBatchLoader.
+struct BatchLoaderStats {
+  /// Calls of Load and AsyncLoad.
+  uint64_t loads{0};
+
+  /// Statements sent, each for a batch of loads.
+  uint64_t batches{0};
+
+  /// Distinct keys sent, `loads - keys` loads shared the key of another load of their batch.
+  uint64_t keys{0};
+};
+
+/// @brief The part of MysqlBatchLoader which does not depend on the row type.
+class MysqlBatchLoaderBase {
+ public:
+  BatchLoaderStats GetStats() const;
+
+ protected:
+  MysqlBatchLoaderBase(std::shared_ptr<MysqlServiceProxy> proxy, std::string sql, const BatchLoaderOption& option);
+
+  void CountBatch(size_t keys);
+
+ protected:
+  std::shared_ptr<MysqlServiceProxy> proxy_;
+
+  std::string sql_;
+
+  BatchLoaderOption option_;
+
+  /// Sends the batches at the end of their window.
+  MysqlTimer timer_;
+
+  std::atomic<uint64_t> loads_{0};
+
+  std::atomic<uint64_t> batches_{0};
+
+  std::atomic<uint64_t> keys_{0};
+};
+
+/// @brief Batches the point lookups of a statement made concurrently (e.g. by the fibers of different requests)
+/// into one IN-list query, in the manner of a DataLoader. N round trips become one under load.
+///
+/// The statement has one marker, the IN list, and selects the key as its first column, e.g.
+/// "select id, name from user where id in (?)" with MysqlBatchLoader<int64_t, std::string>. The first load of a
+/// batch starts a window of `window_ms`, the loads made meanwhile join the batch. The batch is sent at the end of
+/// the window, or as soon as it has `max_keys` distinct keys, with the keys bound as a list (see IsInputList). The
+/// rows are then split between the loads by key.
+/// @note The batched statement runs with a context of its own, with the shortest timeout of the loads of the batch.
+/// The filters of the proxy see one call per batch, and a failed batch fails all its loads.
+template <typename... OutputArgs>
+class MysqlBatchLoader : public MysqlBatchLoaderBase {
+ public:
+  using Results = MysqlResults<OutputArgs...>;
+
+  using Key = std::tuple_element_t<0, std::tuple<OutputArgs...>>;
+
+  static_assert(Results::mode == MysqlResultsMode::BindType, "Only BindType results can be batched");
+
+  MysqlBatchLoader(std::shared_ptr<MysqlServiceProxy> proxy, std::string sql,
+                   const BatchLoaderOption& option = BatchLoaderOption{})
+      : MysqlBatchLoaderBase(std::move(proxy), std::move(sql), option) {}
+
+  /// @brief Sends the pending batch without waiting for the end of its window.
+  virtual ~MysqlBatchLoader();
+
+  /// @brief The rows of `key`, none if there is no such row.
+  Status Load(const ClientContextPtr& context, const Key& key, Results& res);
+
+  Future<Results> AsyncLoad(const ClientContextPtr& context, const Key& key);
+
+ protected:
+  /// @brief Runs the statement with the sorted distinct `keys` of a batch bound as its IN list.
+  /// @param timeout The shortest timeout of the loads of the batch.
+  virtual Future<Results> QueryBatch(uint32_t timeout, const std::vector<Key>& keys);
+
+ private:
+  struct Batch {
+    /// Shortest timeout of the loads.
+    uint32_t timeout{0};
+
+    std::map<Key, std::vector<Promise<Results>>> waiters;
+  };
+
+  /// @brief Sends `batch` if it is still the pending one, called at the end of its window.
+  void Flush(const std::shared_ptr<Batch>& batch);
+
+  void Send(std::shared_ptr<Batch> batch);
+
+  static void Resolve(Batch& batch, const std::vector<Key>& keys, Future<Results>&& fut);
+
+ private:
+  std::mutex mutex_;
+
+  std::shared_ptr<Batch> pending_;
+};
+
+template <typename... OutputArgs>
+MysqlBatchLoader<OutputArgs...>::~MysqlBatchLoader() {
+  timer_.Stop();
+  std::shared_ptr<Batch> batch;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    batch = std::move(pending_);
+  }
+  if (batch != nullptr) Send(std::move(batch));
+}
+
+template <typename... OutputArgs>
+Status MysqlBatchLoader<OutputArgs...>::Load(const ClientContextPtr& context, const Key& key, Results& res) {
+  auto fut = AsyncLoad(context, key);
+  auto done = IsRunningInFiberWorker() ? fiber::BlockingGet(std::move(fut)) : future::BlockingGet(std::move(fut));
+  if (done.IsFailed()) {
+    context->SetStatus(Status(TrpcRetCode::TRPC_INVOKE_UNKNOWN_ERR, done.GetException().what()));
+  } else {
+    res = done.GetValue0();
+    context->SetStatus(Status());
+  }
+  return context->GetStatus();
+}
+
+template <typename... OutputArgs>
+Future<MysqlResults<OutputArgs...>> MysqlBatchLoader<OutputArgs...>::AsyncLoad(const ClientContextPtr& context,
+                                                                              const Key& key) {
+  loads_.fetch_add(1, std::memory_order_relaxed);
+  Promise<Results> promise;
+  auto fut = promise.GetFuture();
+
+  std::shared_ptr<Batch> full;
+  std::shared_ptr<Batch> started;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_ == nullptr) {
+      pending_ = std::make_shared<Batch>();
+      pending_->timeout = context->GetTimeout();
+      started = pending_;
+    } else {
+      pending_->timeout = std::min(pending_->timeout, context->GetTimeout());
+    }
+    pending_->waiters[key].emplace_back(std::move(promise));
+    if (pending_->waiters.size() >= option_.max_keys) {
+      full = std::move(pending_);
+      started = nullptr;
+    }
+  }
+
+  if (full != nullptr) {
+    Send(std::move(full));
+  } else if (started != nullptr) {
+    // A stopped timer drops the task, the batch is sent right away then.
+    if (timer_.Add(option_.window_ms, [this, started]() { Flush(started); }) == 0) Flush(started);
+  }
+  return fut;
+}
+
+template <typename... OutputArgs>
+void MysqlBatchLoader<OutputArgs...>::Flush(const std::shared_ptr<Batch>& batch) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Already sent because it was full.
+    if (pending_ != batch) return;
+    pending_ = nullptr;
+  }
+  Send(batch);
+}
+
+template <typename... OutputArgs>
+void MysqlBatchLoader<OutputArgs...>::Send(std::shared_ptr<Batch> batch) {
+  // The map is sorted, so is `keys`.
+  std::vector<Key> keys;
+  keys.reserve(batch->waiters.size());
+  for (const auto& entry : batch->waiters) keys.push_back(entry.first);
+  CountBatch(keys.size());
+
+  auto fut = QueryBatch(batch->timeout, keys);
+  fut.Then([batch = std::move(batch), keys = std::move(keys)](Future<Results>&& f) {
+    Resolve(*batch, keys, std::move(f));
+    return MakeReadyFuture<>();
+  });
+}
+
+template <typename... OutputArgs>
+Future<MysqlResults<OutputArgs...>> MysqlBatchLoader<OutputArgs...>::QueryBatch(uint32_t timeout,
+                                                                               const std::vector<Key>& keys) {
+  ClientContextPtr context = MakeClientContext(proxy_);
+  context->SetTimeout(timeout);
+  return proxy_->template AsyncQuery<OutputArgs...>(context, sql_, keys);
+}
+
+template <typename... OutputArgs>
+void MysqlBatchLoader<OutputArgs...>::Resolve(Batch& batch, const std::vector<Key>& keys, Future<Results>&& fut) {
+  if (fut.IsFailed()) {
+    for (auto& entry : batch.waiters) {
+      for (auto& promise : entry.second) promise.SetException(fut.GetException());
+    }
+    return;
+  }
+
+  Results res = fut.GetValue0();
+  auto parts = MysqlResultsMerger::Split(res, keys.size(), [&keys](const auto& row) {
+    auto it = std::lower_bound(keys.begin(), keys.end(), std::get<0>(row));
+    return it != keys.end() && *it == std::get<0>(row) ? static_cast<size_t>(it - keys.begin()) : keys.size();
+  });
+
+  size_t index = 0;
+  for (auto& entry : batch.waiters) {
+    auto& promises = entry.second;
+    for (size_t i = 0; i + 1 < promises.size(); ++i) {
+      Results copy;
+      copy.CopyFrom(parts[index]);
+      promises[i].SetValue(std::move(copy));
+    }
+    promises.back().SetValue(std::move(parts[index]));
+    ++index;
+  }
+}
+
+}  // namespace trpc::mysql
@@ -0,0 +1,133 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#include "trpc/client/mysql/mysql_batch_loader.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace trpc::testing {
+
+using trpc::mysql::BatchLoaderOption;
+using trpc::mysql::MysqlBatchLoader;
+using trpc::mysql::MysqlResults;
+
+using UserResults = MysqlResults<int64_t, std::string>;
+
+/// Answers the batches with `rows` instead of querying the proxy.
+class FakeBatchLoader : public MysqlBatchLoader<int64_t, std::string> {
+ public:
+  explicit FakeBatchLoader(const BatchLoaderOption& option)
+      : MysqlBatchLoader(nullptr, "select id, name from user where id in (?)", option) {}
+
+  std::vector<std::vector<int64_t>> sent_keys;
+
+  std::vector<uint32_t> sent_timeouts;
+
+  UserResults rows;
+
+  bool fail{false};
+
+ protected:
+  Future<UserResults> QueryBatch(uint32_t timeout, const std::vector<int64_t>& keys) override {
+    sent_keys.push_back(keys);
+    sent_timeouts.push_back(timeout);
+    if (fail) return MakeExceptionFuture<UserResults>(CommonException("lost connection"));
+    UserResults res;
+    res.CopyFrom(rows);
+    return MakeReadyFuture<UserResults>(std::move(res));
+  }
+};
+
+static ClientContextPtr MakeContext(uint32_t timeout) {
+  auto context = MakeRefCounted<ClientContext>();
+  context->SetTimeout(timeout);
+  return context;
+}
+
+TEST(MysqlBatchLoaderTest, SendBindsKeysAsList) {
+  BatchLoaderOption option;
+  option.window_ms = 60 * 1000;
+  option.max_keys = 3;
+  FakeBatchLoader loader(option);
+  loader.rows.MutableResultSet().emplace_back(1, "alice");
+  loader.rows.MutableResultSet().emplace_back(3, "carol");
+  // Not asked for, dropped.
+  loader.rows.MutableResultSet().emplace_back(9, "mallory");
+
+  auto fut3 = loader.AsyncLoad(MakeContext(1000), 3);
+  auto fut1 = loader.AsyncLoad(MakeContext(200), 1);
+  auto fut3_again = loader.AsyncLoad(MakeContext(1000), 3);
+  EXPECT_TRUE(loader.sent_keys.empty());
+
+  // The third distinct key fills the batch, it is sent without waiting for the window.
+  auto fut2 = loader.AsyncLoad(MakeContext(500), 2);
+  ASSERT_EQ(loader.sent_keys.size(), 1);
+  EXPECT_EQ(loader.sent_keys[0], (std::vector<int64_t>{1, 2, 3}));
+  EXPECT_EQ(loader.sent_timeouts[0], 200);
+
+  auto res1 = future::BlockingGet(std::move(fut1));
+  ASSERT_TRUE(res1.IsReady());
+  ASSERT_EQ(res1.GetValue0().ResultSet().size(), 1);
+  EXPECT_EQ(std::get<1>(res1.GetValue0().ResultSet()[0]), "alice");
+
+  auto res2 = future::BlockingGet(std::move(fut2));
+  ASSERT_TRUE(res2.IsReady());
+  EXPECT_TRUE(res2.GetValue0().ResultSet().empty());
+
+  for (auto* fut : {&fut3, &fut3_again}) {
+    auto res3 = future::BlockingGet(std::move(*fut));
+    ASSERT_TRUE(res3.IsReady());
+    ASSERT_EQ(res3.GetValue0().ResultSet().size(), 1);
+    EXPECT_EQ(std::get<0>(res3.GetValue0().ResultSet()[0]), 3);
+    EXPECT_EQ(std::get<1>(res3.GetValue0().ResultSet()[0]), "carol");
+  }
+
+  auto stats = loader.GetStats();
+  EXPECT_EQ(stats.loads, 4);
+  EXPECT_EQ(stats.batches, 1);
+  EXPECT_EQ(stats.keys, 3);
+}
+
+TEST(MysqlBatchLoaderTest, SendAtEndOfWindow) {
+  BatchLoaderOption option;
+  option.window_ms = 1;
+  FakeBatchLoader loader(option);
+  loader.rows.MutableResultSet().emplace_back(7, "grace");
+
+  Future<UserResults> fut = future::BlockingGet(loader.AsyncLoad(MakeContext(1000), 7));
+  ASSERT_TRUE(fut.IsReady());
+  ASSERT_EQ(fut.GetValue0().ResultSet().size(), 1);
+  EXPECT_EQ(std::get<1>(fut.GetValue0().ResultSet()[0]), "grace");
+  ASSERT_EQ(loader.sent_keys.size(), 1);
+  EXPECT_EQ(loader.sent_keys[0], std::vector<int64_t>{7});
+}
+
+TEST(MysqlBatchLoaderTest, FailedBatchFailsAllLoads) {
+  BatchLoaderOption option;
+  option.window_ms = 60 * 1000;
+  option.max_keys = 2;
+  FakeBatchLoader loader(option);
+  loader.fail = true;
+
+  auto fut1 = loader.AsyncLoad(MakeContext(1000), 1);
+  auto fut2 = loader.AsyncLoad(MakeContext(1000), 2);
+  EXPECT_TRUE(future::BlockingGet(std::move(fut1)).IsFailed());
+  EXPECT_TRUE(future::BlockingGet(std::move(fut2)).IsFailed());
+}
+
+}  // namespace trpc::testing
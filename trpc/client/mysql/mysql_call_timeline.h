@@ -0,0 +1,69 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#pragma once
+
+#include <cstdint>
+
+#include "trpc/client/mysql/executor/mysql_statement_observer.h"
+
+namespace trpc::mysql {
+
+/// @brief Timeline of one call of MysqlServiceProxy (`call_timeline` in MysqlClientConf). The marks are monotonic
+/// timestamps of trpc::GetSteadyMicroSeconds, 0 if the call did not reach them.
+struct MysqlCallTimeline {
+  /// The call is admitted and posted to a worker.
+  uint64_t posted_us{0};
+
+  /// A worker starts the call.
+  uint64_t started_us{0};
+
+  /// The call got a connection from the pool.
+  uint64_t acquired_us{0};
+
+  /// The statements are done, and the connection is given back.
+  uint64_t finished_us{0};
+
+  /// The caller resumes, i.e. the blocked fiber or thread wakes up, or the continuation of the future runs.
+  uint64_t resumed_us{0};
+
+  /// Durations of the phases summed over the statements of the call.
+  MysqlStatementPhases statements;
+
+  /// @brief Calls `fn(const char* name, uint64_t begin_us, uint64_t end_us)` for each phase reached by the call, in
+  /// order: "queue", "acquire", "prepare", "execute", "fetch", "decode", "resume". The statement phases are laid
+  /// out one after the other from `acquired_us`, as their durations are summed. Suited to report the phases as
+  /// child spans or as attributes of the span of the call.
+  template <typename Fn>
+  void ForEachPhase(Fn&& fn) const {
+    if (started_us == 0) return;
+    fn("queue", posted_us, started_us);
+    if (acquired_us == 0) return;
+    fn("acquire", started_us, acquired_us);
+
+    uint64_t begin_us = acquired_us;
+    auto statement_phase = [&](const char* name, uint64_t duration_us) {
+      if (duration_us == 0) return;
+      fn(name, begin_us, begin_us + duration_us);
+      begin_us += duration_us;
+    };
+    statement_phase("prepare", statements.prepare_us);
+    statement_phase("execute", statements.execute_us);
+    statement_phase("fetch", statements.fetch_us);
+    statement_phase("decode", statements.decode_us);
+
+    if (finished_us != 0 && resumed_us != 0) fn("resume", finished_us, resumed_us);
+  }
+};
+
+}  // namespace trpc::mysql
@@ -0,0 +1,77 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#include "trpc/client/mysql/mysql_call_timeline.h"
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace trpc::testing {
+
+using trpc::mysql::MysqlCallTimeline;
+
+namespace {
+
+using Phase = std::tuple<std::string, uint64_t, uint64_t>;
+
+std::vector<Phase> GetPhases(const MysqlCallTimeline& timeline) {
+  std::vector<Phase> phases;
+  timeline.ForEachPhase(
+      [&](const char* name, uint64_t begin_us, uint64_t end_us) { phases.emplace_back(name, begin_us, end_us); });
+  return phases;
+}
+
+}  // namespace
+
+TEST(MysqlCallTimelineTest, ForEachPhase) {
+  MysqlCallTimeline timeline;
+  timeline.posted_us = 100;
+  timeline.started_us = 150;
+  timeline.acquired_us = 160;
+  timeline.statements.prepare_us = 10;
+  timeline.statements.execute_us = 200;
+  timeline.statements.fetch_us = 30;
+  timeline.statements.decode_us = 5;
+  timeline.finished_us = 410;
+  timeline.resumed_us = 420;
+
+  std::vector<Phase> expected{{"queue", 100, 150},   {"acquire", 150, 160}, {"prepare", 160, 170},
+                              {"execute", 170, 370}, {"fetch", 370, 400},   {"decode", 400, 405},
+                              {"resume", 410, 420}};
+  EXPECT_EQ(GetPhases(timeline), expected);
+}
+
+TEST(MysqlCallTimelineTest, PartialTimeline) {
+  MysqlCallTimeline timeline;
+  EXPECT_TRUE(GetPhases(timeline).empty());
+
+  // Failed to connect: no statement ran.
+  timeline.posted_us = 100;
+  timeline.started_us = 120;
+  timeline.acquired_us = 300;
+  timeline.resumed_us = 310;
+  std::vector<Phase> expected{{"queue", 100, 120}, {"acquire", 120, 300}};
+  EXPECT_EQ(GetPhases(timeline), expected);
+
+  // Text protocol statement without prepare.
+  timeline.statements.execute_us = 50;
+  timeline.finished_us = 350;
+  timeline.resumed_us = 360;
+  expected = {{"queue", 100, 120}, {"acquire", 120, 300}, {"execute", 300, 350}, {"resume", 350, 360}};
+  EXPECT_EQ(GetPhases(timeline), expected);
+}
+
+}  // namespace trpc::testing
@@ -0,0 +1,108 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+
+#include "trpc/client/mysql/mysql_concurrency_limiter.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace trpc::mysql {
+
+namespace {
+
+/// Starting limit, as the latency baseline is unknown yet.
+constexpr uint32_t kInitialLimit = 20;
+
+/// The limit is multiplied by this factor when a statement exceeds its deadline.
+constexpr double kBackoffRatio = 0.9;
+
+}  // namespace
+
+MysqlConcurrencyLimiter::MysqlConcurrencyLimiter(uint32_t min_limit, uint32_t max_limit)
+    : min_limit_(std::max<uint32_t>(min_limit, 1)), max_limit_(std::max(max_limit, min_limit_)) {
+  uint32_t initial = std::clamp(kInitialLimit, min_limit_, max_limit_);
+  limit_.store(initial, std::memory_order_relaxed);
+  estimated_limit_ = initial;
+  next_probe_ = static_cast<uint64_t>(kProbeMultiplier) * initial;
+}
+
+bool MysqlConcurrencyLimiter::TryAcquire() {
+  uint32_t inflight = inflight_.load(std::memory_order_relaxed);
+  do {
+    if (inflight >= limit_.load(std::memory_order_relaxed)) {
+      rejected_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+  } while (!inflight_.compare_exchange_weak(inflight, inflight + 1, std::memory_order_relaxed));
+  return true;
+}
+
+void MysqlConcurrencyLimiter::Release(uint64_t latency_us, bool dropped) {
+  uint32_t inflight = inflight_.fetch_sub(1, std::memory_order_relaxed);
+  if (latency_us != 0 || dropped) Update(latency_us, inflight, dropped);
+}
+
+void MysqlConcurrencyLimiter::Update(uint64_t latency_us, uint32_t inflight, bool dropped) {
+  std::scoped_lock _(mutex_);
+
+  double limit = estimated_limit_;
+  if (dropped) {
+    limit *= kBackoffRatio;
+  } else {
+    uint64_t min_latency = min_latency_us_.load(std::memory_order_relaxed);
+    if (++samples_ >= next_probe_) {
+      // Forget the baseline, this sample starts a new one.
+      min_latency = 0;
+      samples_ = 0;
+      next_probe_ = static_cast<uint64_t>(kProbeMultiplier) * static_cast<uint64_t>(limit);
+    }
+    if (min_latency == 0 || latency_us < min_latency) {
+      min_latency = latency_us;
+      min_latency_us_.store(min_latency, std::memory_order_relaxed);
+    }
+
+    // Estimated number of queued statements: the share of the latency above the baseline.
+    double queued = std::ceil(limit * (1.0 - static_cast<double>(min_latency) / static_cast<double>(latency_us)));
+    double step = std::max(1.0, std::log10(limit));
+    if (queued <= 3 * step) {
+      // Only grow a limit which is actually used, or it would grow without bound when idle.
+      if (2.0 * inflight >= limit) limit += step;
+    } else if (queued >= 6 * step) {
+      limit -= step;
+    }
+  }
+
+  estimated_limit_ = std::clamp(limit, static_cast<double>(min_limit_), static_cast<double>(max_limit_));
+  limit_.store(static_cast<uint32_t>(estimated_limit_), std::memory_order_relaxed);
+}
+
+void MysqlConcurrencyLimiter::SetBounds(uint32_t min_limit, uint32_t max_limit) {
+  std::scoped_lock _(mutex_);
+
+  min_limit_ = std::max<uint32_t>(min_limit, 1);
+  max_limit_ = std::max(max_limit, min_limit_);
+  estimated_limit_ = std::clamp(estimated_limit_, static_cast<double>(min_limit_), static_cast<double>(max_limit_));
+  limit_.store(static_cast<uint32_t>(estimated_limit_), std::memory_order_relaxed);
+}
+
+ConcurrencyLimitStats MysqlConcurrencyLimiter::GetStats() const {
+  ConcurrencyLimitStats stats;
+  stats.limit = limit_.load(std::memory_order_relaxed);
+  stats.inflight = inflight_.load(std::memory_order_relaxed);
+  stats.rejected = rejected_.load(std::memory_order_relaxed);
+  stats.min_latency_us = min_latency_us_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace trpc::mysql
@@ -0,0 +1,95 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+namespace trpc::mysql {
+
+/// @brief State of the adaptive concurrency limit of a node (`adaptive_concurrency` in MysqlClientConf).
+struct ConcurrencyLimitStats {
+  /// Current limit of in-flight statements.
+  uint32_t limit{0};
+
+  /// Statements running or queued for the node.
+  uint32_t inflight{0};
+
+  /// Calls rejected because `inflight` reached `limit`.
+  uint64_t rejected{0};
+
+  /// Estimated latency without queueing in microseconds, the baseline of the limit.
+  uint64_t min_latency_us{0};
+};
+
+/// @brief Adaptive limit of the in-flight statements of a node, in the manner of TCP Vegas: the limit grows while
+/// the latency stays close to the lowest latency seen (no queueing) and shrinks once it rises, i.e. requests queue up
+/// in MySQL or in the execution threads. Statements exceeding the deadline of their call shrink it multiplicatively.
+/// @note The baseline latency is probed again every `kProbeMultiplier * limit` samples so that it follows a slower
+/// node (e.g. a larger data set) instead of throttling it forever.
+class MysqlConcurrencyLimiter {
+ public:
+  static constexpr uint32_t kProbeMultiplier = 30;
+
+  /// @param min_limit Lower bound of the limit, at least 1.
+  /// @param max_limit Upper bound of the limit, e.g. the connection pool size.
+  MysqlConcurrencyLimiter(uint32_t min_limit, uint32_t max_limit);
+
+  /// @brief Counts an in-flight statement unless the limit is reached.
+  /// @return false if the call must be rejected. `Release` must not be called then.
+  bool TryAcquire();
+
+  /// @brief Ends an in-flight statement counted by `TryAcquire`.
+  /// @param latency_us Latency of the statement including its queueing, 0 if it did not run (no sample).
+  /// @param dropped The statement exceeded its deadline.
+  void Release(uint64_t latency_us, bool dropped);
+
+  uint32_t GetLimit() const { return limit_.load(std::memory_order_relaxed); }
+
+  /// @brief Changes the bounds of the limit, e.g. on a config reload. The current limit is clamped to them, the
+  /// latency baseline is kept.
+  void SetBounds(uint32_t min_limit, uint32_t max_limit);
+
+  ConcurrencyLimitStats GetStats() const;
+
+ private:
+  void Update(uint64_t latency_us, uint32_t inflight, bool dropped);
+
+ private:
+  /// Guarded by `mutex_`.
+  uint32_t min_limit_;
+
+  uint32_t max_limit_;
+
+  std::atomic<uint32_t> limit_;
+
+  std::atomic<uint32_t> inflight_{0};
+
+  std::atomic<uint64_t> rejected_{0};
+
+  std::mutex mutex_;
+
+  /// The fractional limit, guarded by `mutex_`. `limit_` is its integer part for the lock free `TryAcquire`.
+  double estimated_limit_;
+
+  std::atomic<uint64_t> min_latency_us_{0};
+
+  uint64_t samples_{0};
+
+  uint64_t next_probe_{0};
+};
+
+}  // namespace trpc::mysql
@@ -0,0 +1,117 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+
+#include "trpc/client/mysql/mysql_concurrency_limiter.h"
+
+#include "gtest/gtest.h"
+
+namespace trpc::testing {
+
+using trpc::mysql::MysqlConcurrencyLimiter;
+
+TEST(MysqlConcurrencyLimiterTest, RejectAtLimit) {
+  MysqlConcurrencyLimiter limiter(4, 4);
+  EXPECT_EQ(limiter.GetLimit(), 4);
+
+  for (int i = 0; i < 4; ++i) EXPECT_TRUE(limiter.TryAcquire());
+  EXPECT_FALSE(limiter.TryAcquire());
+  EXPECT_EQ(limiter.GetStats().inflight, 4);
+  EXPECT_EQ(limiter.GetStats().rejected, 1);
+
+  limiter.Release(0, false);
+  EXPECT_TRUE(limiter.TryAcquire());
+  for (int i = 0; i < 4; ++i) limiter.Release(0, false);
+  EXPECT_EQ(limiter.GetStats().inflight, 0);
+}
+
+TEST(MysqlConcurrencyLimiterTest, GrowWithoutQueueing) {
+  MysqlConcurrencyLimiter limiter(1, 100);
+  uint32_t initial = limiter.GetLimit();
+
+  // Fully used, and the latency stays at the baseline.
+  for (int i = 0; i < 50; ++i) {
+    uint32_t limit = limiter.GetLimit();
+    for (uint32_t j = 0; j < limit; ++j) ASSERT_TRUE(limiter.TryAcquire());
+    for (uint32_t j = 0; j < limit; ++j) limiter.Release(1000, false);
+  }
+  EXPECT_GT(limiter.GetLimit(), initial);
+  EXPECT_LE(limiter.GetLimit(), 100);
+  EXPECT_EQ(limiter.GetStats().min_latency_us, 1000);
+}
+
+TEST(MysqlConcurrencyLimiterTest, IdleLimitDoesNotGrow) {
+  MysqlConcurrencyLimiter limiter(1, 100);
+  uint32_t initial = limiter.GetLimit();
+
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_TRUE(limiter.TryAcquire());
+    limiter.Release(1000, false);
+  }
+  EXPECT_EQ(limiter.GetLimit(), initial);
+}
+
+TEST(MysqlConcurrencyLimiterTest, ShrinkWhenLatencyRises) {
+  MysqlConcurrencyLimiter limiter(2, 100);
+  uint32_t initial = limiter.GetLimit();
+
+  ASSERT_TRUE(limiter.TryAcquire());
+  limiter.Release(1000, false);
+
+  // Requests queue up: the latency is ten times the baseline.
+  for (int i = 0; i < 20; ++i) {
+    ASSERT_TRUE(limiter.TryAcquire());
+    limiter.Release(10000, false);
+  }
+  EXPECT_LT(limiter.GetLimit(), initial);
+  EXPECT_GE(limiter.GetLimit(), 2);
+}
+
+TEST(MysqlConcurrencyLimiterTest, BackoffOnDeadline) {
+  MysqlConcurrencyLimiter limiter(1, 100);
+  uint32_t initial = limiter.GetLimit();
+
+  ASSERT_TRUE(limiter.TryAcquire());
+  limiter.Release(0, true);
+  EXPECT_EQ(limiter.GetLimit(), static_cast<uint32_t>(initial * 0.9));
+
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_TRUE(limiter.TryAcquire());
+    limiter.Release(0, true);
+  }
+  EXPECT_EQ(limiter.GetLimit(), 1);
+}
+
+TEST(MysqlConcurrencyLimiterTest, SetBounds) {
+  MysqlConcurrencyLimiter limiter(1, 100);
+  uint32_t initial = limiter.GetLimit();
+
+  // The current limit is clamped into the new bounds, in-flight statements are kept.
+  ASSERT_TRUE(limiter.TryAcquire());
+  limiter.SetBounds(1, initial / 2);
+  EXPECT_EQ(limiter.GetLimit(), initial / 2);
+  EXPECT_EQ(limiter.GetStats().inflight, 1);
+
+  limiter.SetBounds(initial, 200);
+  EXPECT_EQ(limiter.GetLimit(), initial);
+
+  // Backoff stops at the new lower bound.
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_TRUE(limiter.TryAcquire());
+    limiter.Release(0, true);
+  }
+  EXPECT_EQ(limiter.GetLimit(), initial);
+  limiter.Release(0, false);
+}
+
+}  // namespace trpc::testing
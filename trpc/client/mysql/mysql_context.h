@@ -0,0 +1,124 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "trpc/client/client_context.h"
+
+#include "trpc/client/mysql/mysql_call_timeline.h"
+
+namespace trpc::mysql {
+
+/// @brief Filter data id of MysqlContextData in ClientContext. It is far above the ids assigned to filters.
+constexpr uint16_t kMysqlContextDataId = 60000;
+
+/// @brief Caching of the results of a Query call (`result_cache_bytes` in MysqlClientConf).
+struct MysqlCacheOption {
+  /// How long the results stay cached. 0 means the call is not cached.
+  uint64_t ttl_ms{0};
+
+  /// The tables read by the query. The results are invalidated when a statement of the same service proxy writes
+  /// one of them.
+  std::vector<std::string> tables;
+};
+
+/// @brief MySQL specific data carried by a ClientContext.
+struct MysqlContextData {
+  /// The GTID committed by the last write made with the context (`read_your_writes` in MysqlClientConf).
+  /// A replica read with the context waits until the replica has applied it.
+  std::string gtid;
+
+  /// The query class of the calls made with the context (`query_classes` in MysqlClientConf).
+  std::string query_class;
+
+  MysqlCacheOption cache;
+
+  /// Whether the Query calls made with the context share the results of identical calls in flight.
+  bool singleflight{false};
+
+  /// The timeline of the last call made with the context (`call_timeline` in MysqlClientConf).
+  MysqlCallTimeline timeline;
+};
+
+/// @return nullptr if the context carries no MysqlContextData.
+inline MysqlContextData* GetMysqlContextData(const ClientContextPtr& context) {
+  return context->GetFilterData<MysqlContextData>(kMysqlContextDataId);
+}
+
+inline MysqlContextData* MutableMysqlContextData(const ClientContextPtr& context) {
+  MysqlContextData* data = GetMysqlContextData(context);
+  if (data == nullptr) {
+    context->SetFilterData(kMysqlContextDataId, MysqlContextData{});
+    data = GetMysqlContextData(context);
+  }
+  return data;
+}
+
+/// @brief The GTID of the last write made with `context`. Pass it to the context of a later read with
+/// `SetMysqlGtid` to read your own writes from a replica.
+inline std::string GetMysqlGtid(const ClientContextPtr& context) {
+  MysqlContextData* data = GetMysqlContextData(context);
+  return data != nullptr ? data->gtid : std::string();
+}
+
+inline void SetMysqlGtid(const ClientContextPtr& context, std::string gtid) {
+  MutableMysqlContextData(context)->gtid = std::move(gtid);
+}
+
+/// @brief Runs the calls made with `context` on the workers and connections of the query class `name`.
+inline void SetMysqlQueryClass(const ClientContextPtr& context, std::string name) {
+  MutableMysqlContextData(context)->query_class = std::move(name);
+}
+
+/// @return Empty if the context has no query class.
+inline std::string GetMysqlQueryClass(const ClientContextPtr& context) {
+  MysqlContextData* data = GetMysqlContextData(context);
+  return data != nullptr ? data->query_class : std::string();
+}
+
+/// @brief Caches the results of the Query calls made with `context` for `ttl_ms`, tagged with `tables`, the tables
+/// read by the query (without schema). A write to one of them through the same service proxy invalidates the
+/// results. Writes made elsewhere are only seen after the TTL.
+inline void SetMysqlResultCache(const ClientContextPtr& context, uint64_t ttl_ms, std::vector<std::string> tables) {
+  MysqlCacheOption& cache = MutableMysqlContextData(context)->cache;
+  cache.ttl_ms = ttl_ms;
+  cache.tables = std::move(tables);
+}
+
+/// @return nullptr if the calls made with `context` are not cached.
+inline const MysqlCacheOption* GetMysqlCacheOption(const ClientContextPtr& context) {
+  MysqlContextData* data = GetMysqlContextData(context);
+  return data != nullptr && data->cache.ttl_ms != 0 ? &data->cache : nullptr;
+}
+
+/// @brief Lets the Query calls made with `context` share the results of an identical call (same statement, result
+/// type and arguments) in flight, instead of each running the query. For reads which can tolerate results read
+/// by a concurrent call, e.g. during cache miss storms.
+inline void SetMysqlSingleflight(const ClientContextPtr& context, bool enable = true) {
+  MutableMysqlContextData(context)->singleflight = enable;
+}
+
+/// @brief The timeline of the last call made with `context`, set before the CLIENT_POST_RECV_MSG filters run, so
+/// that a tracing filter can report its phases (see MysqlCallTimeline::ForEachPhase).
+/// @return nullptr if `call_timeline` is disabled or the call has not been posted to a worker.
+inline const MysqlCallTimeline* GetMysqlCallTimeline(const ClientContextPtr& context) {
+  MysqlContextData* data = GetMysqlContextData(context);
+  return data != nullptr && data->timeline.posted_us != 0 ? &data->timeline : nullptr;
+}
+
+}  // namespace trpc::mysql
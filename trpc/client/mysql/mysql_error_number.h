@@ -18,5 +18,9 @@ namespace trpc::mysql {
 /// The error numbers are the same with MySQL
 /// https://dev.mysql.com/doc/mysql-errors/8.0/en/error-reference-introduction.html except below
 
-enum TrpcMysqlRetCode : int { TRPC_MYSQL_INVALID_HANDLE = 3502, TRPC_MYSQL_STMT_PARAMS_ERROR = 3503 };
+enum TrpcMysqlRetCode : int {
+  TRPC_MYSQL_INVALID_HANDLE = 3502,
+  TRPC_MYSQL_STMT_PARAMS_ERROR = 3503,
+  TRPC_MYSQL_INVALID_SAVEPOINT = 3504
+};
 }  // namespace trpc::mysql
@@ -13,21 +13,37 @@
 
 #include "trpc/client/mysql/mysql_executor_pool.h"
 
+#include <algorithm>
+
+#include "trpc/client/mysql/mysql_numa.h"
+
 namespace trpc::mysql {
 
 constexpr int EXECUTOR_POOL_CONN_RETRY_NUM = 3;
 
 MysqlExecutorPool::MysqlExecutorPool(const MysqlExecutorPoolOption& option, const NodeAddr& node_addr)
-    : pool_option_(option), target_((node_addr)) {
+    : pool_option_(option), statement_observer_(option.statement_observer), target_((node_addr)) {
   executor_shards_ = std::make_unique<Shard[]>(option.num_shard_group);
-  max_num_per_shard_ = std::ceil(pool_option_.max_size / option.num_shard_group);
+  SetLimits(option);
+  if (option.numa_aware) {
+    uint32_t node_count = MysqlNumaTopology::GetInstance().GetNodeCount();
+    shards_per_node_ = std::max<uint32_t>(option.num_shard_group / node_count, 1);
+    if (option.num_shard_group % node_count != 0) {
+      TRPC_FMT_WARN("num_shard_group {} is not a multiple of the {} numa nodes, some shards are shared.",
+                    option.num_shard_group, node_count);
+    }
+  }
+  if (option.adaptive_concurrency)
+    limiter_ = std::make_unique<MysqlConcurrencyLimiter>(option.min_concurrency, option.max_concurrency);
+  if (!option.lane_max_conn.empty())
+    lane_conns_ = std::make_unique<std::atomic<uint32_t>[]>(option.lane_max_conn.size());
 }
 
 RefPtr<MysqlExecutor> MysqlExecutorPool::GetOrCreate() {
   RefPtr<MysqlExecutor> executor{nullptr};
   RefPtr<MysqlExecutor> idle_executor{nullptr};
 
-  uint32_t shard_id = shard_id_gen_.fetch_add(1);
+  uint32_t shard_id = NextShardId();
   int retry_num = EXECUTOR_POOL_CONN_RETRY_NUM;
 
   while (retry_num > 0) {
@@ -41,7 +57,7 @@ RefPtr<MysqlExecutor> MysqlExecutorPool::GetOrCreate() {
 
         shard.mysql_executors.pop_back();
 
-        if (executor->CheckAlive()) {
+        if (executor->GetGeneration() == generation_.load(std::memory_order_relaxed) && executor->CheckAlive()) {
           if (!IsIdleTimeout(executor))
             return executor;
           else
@@ -55,7 +71,9 @@ RefPtr<MysqlExecutor> MysqlExecutorPool::GetOrCreate() {
     }
 
     if (idle_executor != nullptr) {
+      executor_num_.fetch_sub(1, std::memory_order_relaxed);
       idle_executor->Close();
+      idle_executor = nullptr;
     }
 
     --retry_num;
@@ -72,6 +90,16 @@ RefPtr<MysqlExecutor> MysqlExecutorPool::GetOrCreate() {
   return executor;
 }
 
+uint32_t MysqlExecutorPool::NextShardId() {
+  uint32_t id = shard_id_gen_.fetch_add(1, std::memory_order_relaxed);
+  if (shards_per_node_ == 0) return id;
+
+  // The executors of a shard are connected and used by the threads of one node, so their buffers are allocated
+  // (first touched) on that node.
+  uint32_t node = MysqlNumaTopology::GetInstance().GetCurrentNode();
+  return (node * shards_per_node_ + id % shards_per_node_) % pool_option_.num_shard_group;
+}
+
 RefPtr<MysqlExecutor> MysqlExecutorPool::CreateExecutor(uint32_t shard_id) {
   uint64_t executor_id = static_cast<uint64_t>(shard_id) << 32;
   executor_id |= executor_id_gen_.fetch_add(1, std::memory_order_relaxed);
@@ -79,46 +107,97 @@ RefPtr<MysqlExecutor> MysqlExecutorPool::CreateExecutor(uint32_t shard_id) {
   MysqlConnOption conn_option;
   conn_option.hostname = target_.ip;
   conn_option.port = target_.port;
+
+  std::scoped_lock _(conn_mutex_);
   conn_option.username = pool_option_.username;
   conn_option.database = pool_option_.dbname;
   conn_option.password = pool_option_.password;
   conn_option.char_set = pool_option_.char_set;
+  conn_option.multi_statements = pool_option_.multi_statements;
+  conn_option.track_gtids = pool_option_.track_gtids;
 
   auto executor = MakeRefCounted<MysqlExecutor>(conn_option);
   executor->SetExecutorId(executor_id);
+  executor->SetGeneration(generation_.load(std::memory_order_relaxed));
   return executor;
 }
 
 void MysqlExecutorPool::Reclaim(int ret, RefPtr<MysqlExecutor>&& executor) {
+  // Connected with settings replaced since, see Reconfigure.
+  if (executor->GetGeneration() != generation_.load(std::memory_order_relaxed)) ret = -1;
+  // Returned by a transaction which outlived the pool manager, see MysqlExecutorPoolManager::GetShared.
+  if (stopped_.load(std::memory_order_acquire)) ret = -1;
+
+  // A cheap COM_RESET_CONNECTION keeps the connection in the pool instead of a full reconnect.
+  if (ret == 0 && executor->NeedReset() && !executor->ResetConnection()) {
+    TRPC_FMT_WARN("Reset mysql connection to {}:{} failed: {}", target_.ip, target_.port, executor->GetErrorMessage());
+    ret = -1;
+  }
+
   if (ret == 0) {
     uint32_t shard_id = (executor->GetExecutorId() >> 32);
     auto& shard = executor_shards_[shard_id % pool_option_.num_shard_group];
 
     std::scoped_lock _(shard.lock);
-    if ((shard.mysql_executors.size() <= max_num_per_shard_) &&
-        (executor_num_.load(std::memory_order_relaxed) <= pool_option_.max_size)) {
+    // Checked again under the lock, Stop may have emptied the shard meanwhile.
+    if (!stopped_.load(std::memory_order_acquire) &&
+        (shard.mysql_executors.size() <= max_num_per_shard_.load(std::memory_order_relaxed)) &&
+        (executor_num_.load(std::memory_order_relaxed) <= max_size_.load(std::memory_order_relaxed))) {
       executor->RefreshAliveTime();
       shard.mysql_executors.push_back(std::move(executor));
       return;
     }
   }
 
-  executor_num_.fetch_add(1, std::memory_order_relaxed);
+  executor_num_.fetch_sub(1, std::memory_order_relaxed);
   executor->Close();
 }
 
+void MysqlExecutorPool::Reconfigure(const MysqlExecutorPoolOption& option) {
+  SetLimits(option);
+  if (limiter_ != nullptr) limiter_->SetBounds(option.min_concurrency, option.max_concurrency);
+  // Not a connection setting, the connections are kept.
+  std::atomic_store(&statement_observer_, option.statement_observer);
+
+  std::scoped_lock _(conn_mutex_);
+  if (pool_option_.username == option.username && pool_option_.password == option.password &&
+      pool_option_.dbname == option.dbname && pool_option_.char_set == option.char_set &&
+      pool_option_.multi_statements == option.multi_statements && pool_option_.track_gtids == option.track_gtids) {
+    return;
+  }
+
+  pool_option_.username = option.username;
+  pool_option_.password = option.password;
+  pool_option_.dbname = option.dbname;
+  pool_option_.char_set = option.char_set;
+  pool_option_.multi_statements = option.multi_statements;
+  pool_option_.track_gtids = option.track_gtids;
+  uint32_t generation = generation_.fetch_add(1, std::memory_order_relaxed) + 1;
+  TRPC_FMT_INFO("Connection settings of mysql pool {}:{} changed (generation {}), replace the connections gradually.",
+                target_.ip, target_.port, generation);
+}
+
+void MysqlExecutorPool::SetLimits(const MysqlExecutorPoolOption& option) {
+  max_size_.store(option.max_size, std::memory_order_relaxed);
+  max_idle_time_.store(option.max_idle_time, std::memory_order_relaxed);
+  max_num_per_shard_.store(std::ceil(option.max_size / pool_option_.num_shard_group), std::memory_order_relaxed);
+}
+
 void MysqlExecutorPool::Stop() {
+  stopped_.store(true, std::memory_order_release);
   for (uint32_t i = 0; i != pool_option_.num_shard_group; ++i) {
     auto&& shard = executor_shards_[i];
 
     std::list<RefPtr<MysqlExecutor>> mysql_executors;
     {
+      // Taken out of the shard, so that no call gets a connection which is being closed.
       std::scoped_lock _(shard.lock);
-      mysql_executors = shard.mysql_executors;
+      mysql_executors.swap(shard.mysql_executors);
     }
 
     for (const auto& executor : mysql_executors) {
       TRPC_ASSERT(executor != nullptr);
+      executor_num_.fetch_sub(1, std::memory_order_relaxed);
       executor->Close();
     }
   }
@@ -138,11 +217,33 @@ void MysqlExecutorPool::Destroy() {
   }
 }
 
-RefPtr<MysqlExecutor> MysqlExecutorPool::GetExecutor() { return GetOrCreate(); }
+RefPtr<MysqlExecutor> MysqlExecutorPool::GetExecutor() {
+  RefPtr<MysqlExecutor> executor = GetOrCreate();
+  // Set by the thread which is about to use the executor, so the executor reads it without synchronization.
+  executor->SetObserver(std::atomic_load(&statement_observer_));
+  return executor;
+}
+
+bool MysqlExecutorPool::TryAcquireLaneConn(size_t lane) {
+  if (lane >= pool_option_.lane_max_conn.size() || pool_option_.lane_max_conn[lane] == 0) return true;
+
+  uint32_t max_conn = pool_option_.lane_max_conn[lane];
+  uint32_t used = lane_conns_[lane].load(std::memory_order_relaxed);
+  do {
+    if (used >= max_conn) return false;
+  } while (!lane_conns_[lane].compare_exchange_weak(used, used + 1, std::memory_order_relaxed));
+  return true;
+}
+
+void MysqlExecutorPool::ReleaseLaneConn(size_t lane) {
+  if (lane >= pool_option_.lane_max_conn.size() || pool_option_.lane_max_conn[lane] == 0) return;
+  lane_conns_[lane].fetch_sub(1, std::memory_order_relaxed);
+}
 
 bool MysqlExecutorPool::IsIdleTimeout(RefPtr<MysqlExecutor> executor) {
   if (executor != nullptr) {
-    if (pool_option_.max_idle_time == 0 || executor->GetAliveTime() < pool_option_.max_idle_time) {
+    uint64_t max_idle_time = max_idle_time_.load(std::memory_order_relaxed);
+    if (max_idle_time == 0 || executor->GetAliveTime() < max_idle_time) {
       return false;
     }
     return true;
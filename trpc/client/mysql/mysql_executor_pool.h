@@ -13,11 +13,15 @@
 
 #pragma once
 
+#include <atomic>
 #include <list>
+#include <mutex>
+#include <vector>
 
 #include "trpc/transport/common/transport_message_common.h"
 
 #include "trpc/client/mysql/executor/mysql_executor.h"
+#include "trpc/client/mysql/mysql_concurrency_limiter.h"
 
 namespace trpc::mysql {
 
@@ -28,6 +32,9 @@ struct MysqlExecutorPoolOption {
 
   uint32_t num_shard_group{4};
 
+  /// Splits the shards between the NUMA nodes, a thread takes and creates executors in the shards of its node.
+  bool numa_aware{false};
+
   std::string dbname;
 
   std::string username;
@@ -35,6 +42,23 @@ struct MysqlExecutorPoolOption {
   std::string password;
 
   std::string char_set;
+
+  bool multi_statements{false};
+
+  bool track_gtids{false};
+
+  /// Limit the in-flight statements adaptively, see MysqlConcurrencyLimiter.
+  bool adaptive_concurrency{false};
+
+  uint32_t min_concurrency{1};
+
+  uint32_t max_concurrency{0};
+
+  /// Connection quota of each query class by its index (see MysqlQueryLane), 0 means no quota.
+  std::vector<uint32_t> lane_max_conn;
+
+  /// Set on each executor when it is taken from the pool, see MysqlExecutor::SetObserver.
+  std::shared_ptr<MysqlStatementObserver> statement_observer;
 };
 
 class MysqlExecutorPool {
@@ -47,8 +71,37 @@ class MysqlExecutorPool {
   /// retrieve error information from the executor without adding extra parameters.
   RefPtr<MysqlExecutor> GetExecutor();
 
+  /// @brief Give the executor back to the pool.
+  /// @param ret 0 if the executor can be reused, otherwise it will be closed.
+  /// @note If the session state may be dirty (see MysqlExecutor::NeedReset), the connection is reset
+  /// with COM_RESET_CONNECTION before being pooled again. It is closed if the reset fails, or if the pool has been
+  /// stopped. It may block on the reset, so it only runs as a blocking task.
   void Reclaim(int ret, RefPtr<MysqlExecutor>&&);
 
+  /// @return nullptr unless `adaptive_concurrency` is set.
+  MysqlConcurrencyLimiter* GetLimiter() { return limiter_.get(); }
+
+  const NodeAddr& GetNodeAddr() const { return target_; }
+
+  /// @brief Takes a connection of the quota of the query class `lane` on this node.
+  /// @return false if the class uses its whole quota. `ReleaseLaneConn` must not be called then.
+  bool TryAcquireLaneConn(size_t lane);
+
+  void ReleaseLaneConn(size_t lane);
+
+  /// @brief Applies a new option without dropping the pool. `max_size`, `max_idle_time` and the concurrency bounds
+  /// take effect at once. A change of the connection settings (user, password, database, charset, ...) starts a new
+  /// generation: the executors of older ones are closed as they are returned or taken from the pool, so the
+  /// connections are replaced gradually by the following calls. A new `statement_observer` keeps the connections, it
+  /// is used from the next GetExecutor on.
+  /// @note `num_shard_group`, `lane_max_conn` and `adaptive_concurrency` are kept.
+  void Reconfigure(const MysqlExecutorPoolOption& option);
+
+  /// @brief Incremented by each change of the connection settings.
+  uint32_t GetGeneration() const { return generation_.load(std::memory_order_relaxed); }
+
+  /// @brief Closes the idle connections. The connections in use are closed once they are returned, so calls still
+  /// holding the pool may go on.
   void Stop();
 
   void Destroy();
@@ -58,17 +111,38 @@ class MysqlExecutorPool {
 
   RefPtr<MysqlExecutor> GetOrCreate();
 
+  /// @brief Picks the shard of the next executor, among the shards of the node of the calling thread if
+  /// `numa_aware`. The executor keeps it in its id, so it is always returned to that shard.
+  uint32_t NextShardId();
+
   bool IsIdleTimeout(RefPtr<MysqlExecutor> executor);
 
+  void SetLimits(const MysqlExecutorPoolOption& option);
+
  private:
+  /// Its connection settings are guarded by `conn_mutex_`, its limits are superseded by the atomics below.
   MysqlExecutorPoolOption pool_option_;
 
+  std::mutex conn_mutex_;
+
+  /// Supersedes the one of `pool_option_`, accessed with std::atomic_load and std::atomic_store.
+  std::shared_ptr<MysqlStatementObserver> statement_observer_;
+
+  /// Set by Stop, the executors returned afterwards are closed.
+  std::atomic<bool> stopped_{false};
+
+  std::atomic<uint32_t> generation_{0};
+
+  std::atomic<uint32_t> max_size_{0};
+
+  std::atomic<uint64_t> max_idle_time_{0};
+
   NodeAddr target_;
 
   std::atomic<uint32_t> executor_num_{0};
 
   // The maximum number of connections that can be stored per `Shard` in `conn_shards_`
-  uint32_t max_num_per_shard_{0};
+  std::atomic<uint32_t> max_num_per_shard_{0};
 
   struct alignas(hardware_destructive_interference_size) Shard {
     std::mutex lock;
@@ -79,7 +153,15 @@ class MysqlExecutorPool {
 
   std::atomic<uint32_t> shard_id_gen_{0};
 
+  /// Shards of each NUMA node with `numa_aware`, 0 otherwise.
+  uint32_t shards_per_node_{0};
+
   std::atomic<uint32_t> executor_id_gen_{0};
+
+  std::unique_ptr<MysqlConcurrencyLimiter> limiter_{nullptr};
+
+  /// Connections used by each query class, by the index of the class.
+  std::unique_ptr<std::atomic<uint32_t>[]> lane_conns_;
 };
 
 }  // namespace trpc::mysql
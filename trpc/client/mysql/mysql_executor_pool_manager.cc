@@ -17,48 +17,68 @@ namespace trpc::mysql {
 
 MysqlExecutorPoolManager::MysqlExecutorPoolManager(const MysqlExecutorPoolOption& option) : option_(option) {}
 
-MysqlExecutorPool* MysqlExecutorPoolManager::Get(const NodeAddr& node_addr) {
+std::shared_ptr<MysqlExecutorPool> MysqlExecutorPoolManager::GetShared(const NodeAddr& node_addr) {
   const int len = 64;
   std::string endpoint(len, 0x0);
   std::snprintf(const_cast<char*>(endpoint.c_str()), len, "%s:%d", node_addr.ip.c_str(), node_addr.port);
 
-  MysqlExecutorPool* executor_pool{nullptr};
+  std::shared_ptr<MysqlExecutorPool> executor_pool{nullptr};
   bool ret = executor_pools_.Get(endpoint, executor_pool);
 
   if (ret) {
     return executor_pool;
   }
 
-  MysqlExecutorPool* pool = CreateExecutorPool(node_addr);
+  std::scoped_lock _(option_mutex_);
+  std::shared_ptr<MysqlExecutorPool> pool = CreateExecutorPool(node_addr);
+  // Asked for by a call which still holds a stopped manager, its connections are closed once returned.
+  if (stopped_) pool->Stop();
   ret = executor_pools_.GetOrInsert(endpoint, pool, executor_pool);
   if (!ret) {
     return pool;
   }
 
-  delete pool;
-  pool = nullptr;
-
   return executor_pool;
 }
 
-MysqlExecutorPool* MysqlExecutorPoolManager::CreateExecutorPool(const NodeAddr& node_addr) {
-  MysqlExecutorPool* new_pool{nullptr};
-  new_pool = new MysqlExecutorPool(option_, node_addr);
-  return new_pool;
+std::unordered_map<std::string, ConcurrencyLimitStats> MysqlExecutorPoolManager::GetConcurrencyLimits() {
+  std::unordered_map<std::string, std::shared_ptr<MysqlExecutorPool>> pools;
+  executor_pools_.GetAllItems(pools);
+
+  std::unordered_map<std::string, ConcurrencyLimitStats> limits;
+  for (auto& [key, pool] : pools) {
+    MysqlConcurrencyLimiter* limiter = pool->GetLimiter();
+    if (limiter == nullptr) continue;
+    const NodeAddr& node_addr = pool->GetNodeAddr();
+    limits.emplace(node_addr.ip + ":" + std::to_string(node_addr.port), limiter->GetStats());
+  }
+  return limits;
+}
+
+std::shared_ptr<MysqlExecutorPool> MysqlExecutorPoolManager::CreateExecutorPool(const NodeAddr& node_addr) {
+  return std::make_shared<MysqlExecutorPool>(option_, node_addr);
+}
+
+void MysqlExecutorPoolManager::Reconfigure(const MysqlExecutorPoolOption& option) {
+  std::scoped_lock _(option_mutex_);
+  option_ = option;
+
+  std::unordered_map<std::string, std::shared_ptr<MysqlExecutorPool>> pools;
+  executor_pools_.GetAllItems(pools);
+  for (auto& [key, pool] : pools) pool->Reconfigure(option);
 }
 
 void MysqlExecutorPoolManager::Stop() {
+  std::scoped_lock _(option_mutex_);
+  stopped_ = true;
   executor_pools_.GetAllItems(pools_to_destroy_);
 
   for (auto& [key, pool] : pools_to_destroy_) pool->Stop();
 }
 
 void MysqlExecutorPoolManager::Destroy() {
-  for (auto& [key, pool] : pools_to_destroy_) {
-    pool->Destroy();
-    delete pool;
-    pool = nullptr;
-  }
+  // A pool still held elsewhere (e.g. by an open transaction) is freed by its last holder.
+  for (auto& [key, pool] : pools_to_destroy_) pool->Destroy();
 
   executor_pools_.Reclaim();
   pools_to_destroy_.clear();
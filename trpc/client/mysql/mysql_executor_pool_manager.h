@@ -13,6 +13,9 @@
 
 #pragma once
 
+#include <memory>
+#include <mutex>
+#include <string>
 #include <unordered_map>
 
 #include "trpc/transport/common/transport_message_common.h"
@@ -26,19 +29,37 @@ class MysqlExecutorPoolManager {
  public:
   explicit MysqlExecutorPoolManager(const MysqlExecutorPoolOption& option);
 
-  MysqlExecutorPool* Get(const NodeAddr& node_addr);
+  /// @note The pool lives until Destroy. Use GetShared to keep it beyond, e.g. for a transaction.
+  MysqlExecutorPool* Get(const NodeAddr& node_addr) { return GetShared(node_addr).get(); }
 
+  /// @brief Same as Get, but the pool stays valid while the pointer is kept. Its connections are closed once it is
+  /// stopped, see MysqlExecutorPool::Stop.
+  std::shared_ptr<MysqlExecutorPool> GetShared(const NodeAddr& node_addr);
+
+  /// @brief The adaptive concurrency limit of each node by "ip:port" (`adaptive_concurrency` in MysqlClientConf).
+  std::unordered_map<std::string, ConcurrencyLimitStats> GetConcurrencyLimits();
+
+  /// @brief Reconfigures the pool of each node in place (see MysqlExecutorPool::Reconfigure), and creates the pools
+  /// of new nodes with `option`.
+  void Reconfigure(const MysqlExecutorPoolOption& option);
+
+  /// @brief Stops the pools, see MysqlExecutorPool::Stop. A pool created afterwards is stopped as well.
   void Stop();
 
   void Destroy();
 
  private:
-  MysqlExecutorPool* CreateExecutorPool(const NodeAddr& node_addr);
+  std::shared_ptr<MysqlExecutorPool> CreateExecutorPool(const NodeAddr& node_addr);
 
  private:
-  concurrency::LightlyConcurrentHashMap<std::string, MysqlExecutorPool*> executor_pools_;
+  concurrency::LightlyConcurrentHashMap<std::string, std::shared_ptr<MysqlExecutorPool>> executor_pools_;
+
+  std::unordered_map<std::string, std::shared_ptr<MysqlExecutorPool>> pools_to_destroy_;
+
+  /// Guards `option_` and `stopped_`, and the creation of pools so that a new pool cannot miss a reconfiguration.
+  std::mutex option_mutex_;
 
-  std::unordered_map<std::string, MysqlExecutorPool*> pools_to_destroy_;
+  bool stopped_{false};
 
   MysqlExecutorPoolOption option_;
 };
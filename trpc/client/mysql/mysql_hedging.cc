@@ -0,0 +1,72 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#include "trpc/client/mysql/mysql_hedging.h"
+
+#include <algorithm>
+
+namespace trpc::mysql {
+
+void LatencyTracker::Record(uint64_t latency_us) {
+  histogram_.Record(latency_us);
+  if (histogram_.Count() % kDecaySamples == 0) histogram_.Halve();
+}
+
+uint64_t LatencyTracker::Percentile(uint32_t percentile) const {
+  if (histogram_.BucketTotal() < kMinSamples) return 0;
+  return histogram_.Percentile(std::min<uint32_t>(percentile, 100));
+}
+
+HedgePolicy::HedgePolicy(uint32_t delay_ms, uint32_t percentile, uint32_t budget_percent)
+    : delay_ms_(delay_ms), percentile_(percentile), tokens_per_read_(budget_percent) {}
+
+void HedgePolicy::OnRead() {
+  reads_.fetch_add(1, std::memory_order_relaxed);
+  int64_t tokens = tokens_.load(std::memory_order_relaxed);
+  while (tokens < kMaxBurst * kTokensPerHedge &&
+         !tokens_.compare_exchange_weak(tokens, std::min(tokens + tokens_per_read_, kMaxBurst * kTokensPerHedge),
+                                        std::memory_order_relaxed)) {
+  }
+}
+
+uint64_t HedgePolicy::GetDelay() const {
+  if (percentile_ == 0) return delay_ms_;
+
+  uint64_t latency_us = tracker_.Percentile(percentile_);
+  if (latency_us == 0) return 0;
+  return std::max<uint64_t>((latency_us + 999) / 1000, std::max<uint32_t>(delay_ms_, 1));
+}
+
+bool HedgePolicy::TryHedge() {
+  int64_t tokens = tokens_.load(std::memory_order_relaxed);
+  while (tokens >= kTokensPerHedge) {
+    if (tokens_.compare_exchange_weak(tokens, tokens - kTokensPerHedge, std::memory_order_relaxed)) {
+      hedges_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  budget_rejects_.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+HedgeStats HedgePolicy::GetStats() const {
+  HedgeStats stats;
+  stats.reads = reads_.load(std::memory_order_relaxed);
+  stats.hedges = hedges_.load(std::memory_order_relaxed);
+  stats.hedge_wins = hedge_wins_.load(std::memory_order_relaxed);
+  stats.budget_rejects = budget_rejects_.load(std::memory_order_relaxed);
+  stats.kills = kills_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace trpc::mysql
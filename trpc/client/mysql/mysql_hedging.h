@@ -0,0 +1,114 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "trpc/client/mysql/mysql_histogram.h"
+
+namespace trpc::mysql {
+
+/// @brief Counters of the hedged reads (`hedge_delay` in MysqlClientConf).
+struct HedgeStats {
+  /// Reads which could have been hedged.
+  uint64_t reads{0};
+
+  /// Extra queries sent to a second node.
+  uint64_t hedges{0};
+
+  /// Hedges which returned before the first query.
+  uint64_t hedge_wins{0};
+
+  /// Hedges skipped because the hedge budget was used up.
+  uint64_t budget_rejects{0};
+
+  /// Losing queries cancelled with KILL QUERY.
+  uint64_t kills{0};
+};
+
+/// @brief Approximate latency percentiles of recent calls: a MysqlHistogram whose counts are halved every
+/// `kDecaySamples` samples, so old samples fade out.
+class LatencyTracker {
+ public:
+  static constexpr uint64_t kDecaySamples = 4096;
+
+  /// Percentiles need at least this number of samples.
+  static constexpr uint64_t kMinSamples = 100;
+
+  void Record(uint64_t latency_us);
+
+  /// @param percentile In (0, 100].
+  /// @return Upper bound of the bucket holding the percentile in microseconds, 0 without enough samples.
+  uint64_t Percentile(uint32_t percentile) const;
+
+ private:
+  MysqlHistogram histogram_;
+};
+
+/// @brief Policy of hedged reads: the delay before a hedge, the hedge budget and the counters.
+class HedgePolicy {
+ public:
+  /// @param delay_ms Fixed delay, also the minimum delay with a percentile.
+  /// @param percentile Hedge after this latency percentile of the reads, 0 for the fixed delay only.
+  /// @param budget_percent Hedges allowed in percent of the reads.
+  HedgePolicy(uint32_t delay_ms, uint32_t percentile, uint32_t budget_percent);
+
+  /// @brief Counts a read, which adds to the hedge budget.
+  void OnRead();
+
+  /// @return Milliseconds to wait before hedging the read, 0 means no hedge (e.g. not enough samples yet).
+  uint64_t GetDelay() const;
+
+  /// @brief Takes one hedge from the budget.
+  bool TryHedge();
+
+  /// @brief Records the latency of a first query, hedged or not.
+  void RecordLatency(uint64_t latency_us) { tracker_.Record(latency_us); }
+
+  void CountHedgeWin() { hedge_wins_.fetch_add(1, std::memory_order_relaxed); }
+
+  void CountKill() { kills_.fetch_add(1, std::memory_order_relaxed); }
+
+  HedgeStats GetStats() const;
+
+ private:
+  /// Budget tokens are in 1/100 of a hedge.
+  static constexpr int64_t kTokensPerHedge = 100;
+
+  /// At most this number of hedges can be sent in a burst.
+  static constexpr int64_t kMaxBurst = 10;
+
+  uint32_t delay_ms_;
+
+  uint32_t percentile_;
+
+  int64_t tokens_per_read_;
+
+  std::atomic<int64_t> tokens_{0};
+
+  LatencyTracker tracker_;
+
+  std::atomic<uint64_t> reads_{0};
+
+  std::atomic<uint64_t> hedges_{0};
+
+  std::atomic<uint64_t> hedge_wins_{0};
+
+  std::atomic<uint64_t> budget_rejects_{0};
+
+  std::atomic<uint64_t> kills_{0};
+};
+
+}  // namespace trpc::mysql
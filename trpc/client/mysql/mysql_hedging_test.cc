@@ -0,0 +1,107 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#include "trpc/client/mysql/mysql_hedging.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "trpc/client/mysql/mysql_timer.h"
+
+namespace trpc::testing {
+
+using namespace trpc::mysql;
+
+TEST(MysqlHedgingTest, LatencyPercentile) {
+  LatencyTracker tracker;
+  EXPECT_EQ(tracker.Percentile(95), 0);
+
+  // 1..1000us, p95 is 950us within the bucket error.
+  for (uint64_t i = 1; i <= 1000; ++i) tracker.Record(i);
+  uint64_t p95 = tracker.Percentile(95);
+  EXPECT_GE(p95, 950);
+  EXPECT_LE(p95, 950 * 9 / 8 + 1);
+  EXPECT_LE(tracker.Percentile(50), 600);
+  EXPECT_GE(tracker.Percentile(100), 1000);
+}
+
+TEST(MysqlHedgingTest, Delay) {
+  HedgePolicy fixed(20, 0, 10);
+  EXPECT_EQ(fixed.GetDelay(), 20);
+
+  // No hedge before enough samples, then the percentile but never below the fixed delay.
+  HedgePolicy adaptive(2, 95, 10);
+  EXPECT_EQ(adaptive.GetDelay(), 0);
+  for (int i = 0; i < 1000; ++i) adaptive.RecordLatency(10000);
+  EXPECT_GE(adaptive.GetDelay(), 10);
+  EXPECT_LE(adaptive.GetDelay(), 12);
+
+  HedgePolicy fast(5, 95, 10);
+  for (int i = 0; i < 1000; ++i) fast.RecordLatency(100);
+  EXPECT_EQ(fast.GetDelay(), 5);
+}
+
+TEST(MysqlHedgingTest, Budget) {
+  HedgePolicy policy(10, 0, 10);
+  EXPECT_FALSE(policy.TryHedge());
+
+  // 10% of the reads may be hedged.
+  for (int i = 0; i < 30; ++i) policy.OnRead();
+  EXPECT_TRUE(policy.TryHedge());
+  EXPECT_TRUE(policy.TryHedge());
+  EXPECT_TRUE(policy.TryHedge());
+  EXPECT_FALSE(policy.TryHedge());
+
+  // The budget does not build up beyond a burst.
+  for (int i = 0; i < 100000; ++i) policy.OnRead();
+  int hedges = 0;
+  while (policy.TryHedge()) ++hedges;
+  EXPECT_EQ(hedges, 10);
+
+  HedgeStats stats = policy.GetStats();
+  EXPECT_EQ(stats.reads, 100030);
+  EXPECT_EQ(stats.hedges, 13);
+  EXPECT_EQ(stats.budget_rejects, 3);
+}
+
+TEST(MysqlTimerTest, RunAndCancel) {
+  MysqlTimer timer;
+  EXPECT_EQ(timer.Add(1, []() {}), 0);
+
+  timer.Start();
+  std::vector<int> order;
+  std::atomic<int> runs{0};
+  timer.Add(30, [&]() {
+    order.push_back(2);
+    ++runs;
+  });
+  timer.Add(10, [&]() {
+    order.push_back(1);
+    ++runs;
+  });
+  uint64_t cancelled = timer.Add(20, [&]() { ++runs; });
+  EXPECT_TRUE(timer.Cancel(cancelled));
+  EXPECT_FALSE(timer.Cancel(cancelled));
+
+  while (runs.load() < 2) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  EXPECT_EQ(runs.load(), 2);
+  EXPECT_EQ(order, (std::vector<int>{1, 2}));
+  timer.Stop();
+}
+
+}  // namespace trpc::testing
@@ -0,0 +1,75 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+
+#include "trpc/client/mysql/mysql_histogram.h"
+
+#include <algorithm>
+
+namespace trpc::mysql {
+
+size_t MysqlHistogram::BucketOf(uint64_t value) {
+  if (value < kLinearBuckets) return static_cast<size_t>(value);
+
+  // Exponent e >= 4, then the 3 bits below the leading one select one of the 8 sub buckets.
+  size_t exponent = 63 - __builtin_clzll(value);
+  size_t sub = (value >> (exponent - 3)) & (kSubBuckets - 1);
+  return std::min(kLinearBuckets + (exponent - 4) * kSubBuckets + sub, kBuckets - 1);
+}
+
+uint64_t MysqlHistogram::UpperBoundOf(size_t bucket) {
+  if (bucket < kLinearBuckets) return bucket + 1;
+
+  size_t exponent = (bucket - kLinearBuckets) / kSubBuckets + 4;
+  uint64_t sub = (bucket - kLinearBuckets) % kSubBuckets;
+  return ((kSubBuckets + sub + 1) << (exponent - 3));
+}
+
+void MysqlHistogram::Record(uint64_t value) {
+  buckets_[BucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(value, std::memory_order_relaxed);
+
+  uint64_t max = max_.load(std::memory_order_relaxed);
+  while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+  }
+}
+
+uint64_t MysqlHistogram::BucketTotal() const {
+  uint64_t total = 0;
+  for (const auto& bucket : buckets_) total += bucket.load(std::memory_order_relaxed);
+  return total;
+}
+
+uint64_t MysqlHistogram::Percentile(double percentile) const {
+  uint64_t total = BucketTotal();
+  if (total == 0) return 0;
+
+  double rank = static_cast<double>(total) * std::clamp(percentile, 0.0, 100.0) / 100.0;
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kBuckets; ++i) {
+    seen += buckets_[i].load(std::memory_order_relaxed);
+    if (seen > 0 && static_cast<double>(seen) >= rank) return UpperBoundOf(i);
+  }
+  return UpperBoundOf(kBuckets - 1);
+}
+
+void MysqlHistogram::Halve() {
+  // Concurrent records may be lost or halved twice, which only shifts the percentiles slightly.
+  for (auto& bucket : buckets_) {
+    uint64_t count = bucket.load(std::memory_order_relaxed);
+    if (count > 0) bucket.fetch_sub(count / 2, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace trpc::mysql
@@ -0,0 +1,69 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace trpc::mysql {
+
+/// @brief Lock free histogram of non negative values in the manner of HDR histograms: values below 16 are exact,
+/// larger ones fall into 8 logarithmic sub buckets per power of two (at most 12.5% relative error). Values of 2^40
+/// and above share the last bucket.
+/// @note Concurrent `Record` and reads are safe, a read may miss the records made meanwhile.
+class MysqlHistogram {
+ public:
+  void Record(uint64_t value);
+
+  uint64_t Count() const { return count_.load(std::memory_order_relaxed); }
+
+  uint64_t Sum() const { return sum_.load(std::memory_order_relaxed); }
+
+  uint64_t Max() const { return max_.load(std::memory_order_relaxed); }
+
+  /// @brief Number of values recorded in the buckets, which differs from `Count` after `Halve`.
+  uint64_t BucketTotal() const;
+
+  /// @param percentile In (0, 100].
+  /// @return Upper bound of the bucket holding the percentile, 0 if the histogram is empty.
+  uint64_t Percentile(double percentile) const;
+
+  /// @brief Halves the count of each bucket, so that old values fade out of the percentiles.
+  void Halve();
+
+ private:
+  static constexpr size_t kLinearBuckets = 16;
+
+  static constexpr size_t kSubBuckets = 8;
+
+  static constexpr size_t kBuckets = kLinearBuckets + 36 * kSubBuckets;
+
+  static size_t BucketOf(uint64_t value);
+
+  static uint64_t UpperBoundOf(size_t bucket);
+
+ private:
+  std::array<std::atomic<uint64_t>, kBuckets> buckets_{};
+
+  std::atomic<uint64_t> count_{0};
+
+  std::atomic<uint64_t> sum_{0};
+
+  std::atomic<uint64_t> max_{0};
+};
+
+}  // namespace trpc::mysql
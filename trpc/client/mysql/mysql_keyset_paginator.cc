@@ -0,0 +1,50 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#include "trpc/client/mysql/mysql_keyset_paginator.h"
+
+namespace trpc::mysql {
+
+std::string MysqlKeysetPaginatorBase::MakePageSql(const KeysetPageQuery& query, bool after_key) {
+  std::string sql = query.select;
+  if (after_key) {
+    sql.append(" WHERE ");
+    if (!query.filter.empty()) sql.append("(").append(query.filter).append(") AND ");
+    sql.append(query.key_column).append(" > ?");
+  } else if (!query.filter.empty()) {
+    sql.append(" WHERE ").append(query.filter);
+  }
+  // Same page size as MysqlKeysetPaginator, which tells the last page by a short one.
+  size_t page_size = std::max<size_t>(query.page_size, 1);
+  sql.append(" ORDER BY ").append(query.key_column).append(" LIMIT ").append(std::to_string(page_size));
+  return sql;
+}
+
+ClientContextPtr MysqlKeysetPaginatorBase::MakePrefetchContext(const ClientContextPtr& context) const {
+  ClientContextPtr prefetch_context = MakeClientContext(proxy_);
+  prefetch_context->SetTimeout(context->GetTimeout());
+  if (!context->GetIp().empty()) prefetch_context->SetAddr(context->GetIp(), context->GetPort());
+  prefetch_context->SetCallerName(context->GetCallerName());
+  const auto& trans_info = context->GetPbReqTransInfo();
+  prefetch_context->SetReqTransInfo(trans_info.begin(), trans_info.end());
+
+  const MysqlContextData* data = GetMysqlContextData(context);
+  if (data != nullptr) {
+    MysqlContextData copy = *data;
+    copy.timeline = MysqlCallTimeline{};
+    prefetch_context->SetFilterData(kMysqlContextDataId, std::move(copy));
+  }
+  return prefetch_context;
+}
+
+}  // namespace trpc::mysql
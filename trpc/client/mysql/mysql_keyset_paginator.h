@@ -0,0 +1,161 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include "trpc/client/make_client_context.h"
+#include "trpc/coroutine/fiber.h"
+#include "trpc/coroutine/future.h"
+#include "trpc/util/function.h"
+
+#include "trpc/client/mysql/mysql_service_proxy.h"
+
+namespace trpc::mysql {
+
+/// @brief Statement of a page of a MysqlKeysetPaginator.
+struct KeysetPageQuery {
+  /// The select list and tables, without WHERE, ORDER BY and LIMIT, e.g. "select id, name from users".
+  std::string select;
+
+  /// The ordered unique key, also the first column selected, e.g. "id".
+  std::string key_column;
+
+  /// The condition of the scanned rows, e.g. "status = ?", empty for all the rows.
+  std::string filter;
+
+  size_t page_size{1000};
+};
+
+/// @brief The part of MysqlKeysetPaginator which does not depend on the row type.
+class MysqlKeysetPaginatorBase {
+ public:
+  MysqlKeysetPaginatorBase(const MysqlKeysetPaginatorBase&) = delete;
+
+  MysqlKeysetPaginatorBase& operator=(const MysqlKeysetPaginatorBase&) = delete;
+
+  /// @brief Whether the last page has been returned.
+  bool Done() const { return done_; }
+
+  /// @brief The statement of the first page ("... ORDER BY key LIMIT n"), or of the pages after a key
+  /// ("... WHERE key > ? ORDER BY key LIMIT n") if `after_key`. A page size of 0 is taken as 1.
+  static std::string MakePageSql(const KeysetPageQuery& query, bool after_key);
+
+ protected:
+  explicit MysqlKeysetPaginatorBase(std::shared_ptr<MysqlServiceProxy> proxy, size_t page_size)
+      : proxy_(std::move(proxy)), page_size_(std::max<size_t>(page_size, 1)) {}
+
+  /// @brief The context of the prefetch of the page after the one queried with `context`: the same timeout,
+  /// address, caller, transparent info and MysqlContextData (query class, GTID...), without the timeline.
+  ClientContextPtr MakePrefetchContext(const ClientContextPtr& context) const;
+
+ protected:
+  std::shared_ptr<MysqlServiceProxy> proxy_;
+
+  size_t page_size_;
+
+  bool done_{false};
+};
+
+/// @brief Scans a large table page by page with keyset pagination: each page starts after the key of the last row
+/// of the previous page ("WHERE key > ? ORDER BY key LIMIT n"), so every page costs one index range scan, unlike
+/// "LIMIT n OFFSET m" which reads and drops the m rows before the page.
+///
+/// The key is the first column of OutputArgs. As soon as a full page arrives, the next one is queried in the
+/// background while the caller processes the page, so the I/O of the scan overlaps with its processing.
+/// @note Not thread-safe, call Next or AsyncNext once at a time. The paginator must outlive the futures returned
+/// by AsyncNext. The rows modified during the scan may or may not be seen, as with any scan made of several
+/// statements.
+template <typename... OutputArgs>
+class MysqlKeysetPaginator : public MysqlKeysetPaginatorBase {
+ public:
+  using Results = MysqlResults<OutputArgs...>;
+
+  using Key = std::tuple_element_t<0, std::tuple<OutputArgs...>>;
+
+  static_assert(Results::mode == MysqlResultsMode::BindType, "Only BindType results can be paginated");
+
+  /// @param args Bound to the markers of `query.filter`.
+  template <typename... InputArgs>
+  MysqlKeysetPaginator(std::shared_ptr<MysqlServiceProxy> proxy, const KeysetPageQuery& query,
+                       const InputArgs&... args);
+
+  /// @brief The next page, empty once the scan is done. A failed page is queried again by the next call.
+  Status Next(const ClientContextPtr& context, Results& res);
+
+  Future<Results> AsyncNext(const ClientContextPtr& context);
+
+ private:
+  /// @brief Queries the page after `after`, or the first page if nullptr.
+  Function<Future<Results>(const ClientContextPtr&, const Key*)> query_;
+
+  std::optional<Key> last_key_;
+
+  /// The page after `last_key_`, queried in the background.
+  std::optional<Future<Results>> prefetched_;
+};
+
+template <typename... OutputArgs>
+template <typename... InputArgs>
+MysqlKeysetPaginator<OutputArgs...>::MysqlKeysetPaginator(std::shared_ptr<MysqlServiceProxy> proxy,
+                                                          const KeysetPageQuery& query, const InputArgs&... args)
+    : MysqlKeysetPaginatorBase(std::move(proxy), query.page_size) {
+  query_ = [proxy = proxy_, first_sql = MakePageSql(query, false), next_sql = MakePageSql(query, true),
+            args...](const ClientContextPtr& context, const Key* after) {
+    if (after == nullptr) return proxy->template AsyncQuery<OutputArgs...>(context, first_sql, args...);
+    return proxy->template AsyncQuery<OutputArgs...>(context, next_sql, args..., *after);
+  };
+}
+
+template <typename... OutputArgs>
+Status MysqlKeysetPaginator<OutputArgs...>::Next(const ClientContextPtr& context, Results& res) {
+  auto fut = AsyncNext(context);
+  auto done = IsRunningInFiberWorker() ? fiber::BlockingGet(std::move(fut)) : future::BlockingGet(std::move(fut));
+  if (done.IsFailed()) {
+    context->SetStatus(Status(TrpcRetCode::TRPC_INVOKE_UNKNOWN_ERR, done.GetException().what()));
+  } else {
+    res = done.GetValue0();
+    context->SetStatus(Status());
+  }
+  return context->GetStatus();
+}
+
+template <typename... OutputArgs>
+Future<MysqlResults<OutputArgs...>> MysqlKeysetPaginator<OutputArgs...>::AsyncNext(const ClientContextPtr& context) {
+  if (done_) return MakeReadyFuture<Results>(Results());
+
+  Future<Results> fut = prefetched_ ? std::move(*prefetched_) : query_(context, last_key_ ? &*last_key_ : nullptr);
+  prefetched_.reset();
+  return fut.Then([this, context](Future<Results>&& f) {
+    if (f.IsFailed()) return MakeExceptionFuture<Results>(f.GetException());
+
+    Results res = f.GetValue0();
+    const auto& rows = res.ResultSet();
+    if (rows.size() < page_size_) {
+      done_ = true;
+    } else {
+      last_key_ = std::get<0>(rows.back());
+      prefetched_ = query_(MakePrefetchContext(context), &*last_key_);
+    }
+    return MakeReadyFuture<Results>(std::move(res));
+  });
+}
+
+}  // namespace trpc::mysql
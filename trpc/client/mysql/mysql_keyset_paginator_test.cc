@@ -0,0 +1,47 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#include "trpc/client/mysql/mysql_keyset_paginator.h"
+
+#include "gtest/gtest.h"
+
+namespace trpc::testing {
+
+using trpc::mysql::KeysetPageQuery;
+using trpc::mysql::MysqlKeysetPaginatorBase;
+
+TEST(MysqlKeysetPaginatorTest, MakePageSql) {
+  KeysetPageQuery query;
+  query.select = "select id, name from users";
+  query.key_column = "id";
+  query.page_size = 100;
+  EXPECT_EQ(MysqlKeysetPaginatorBase::MakePageSql(query, false), "select id, name from users ORDER BY id LIMIT 100");
+  EXPECT_EQ(MysqlKeysetPaginatorBase::MakePageSql(query, true),
+            "select id, name from users WHERE id > ? ORDER BY id LIMIT 100");
+
+  query.filter = "status = ? or vip = 1";
+  EXPECT_EQ(MysqlKeysetPaginatorBase::MakePageSql(query, false),
+            "select id, name from users WHERE status = ? or vip = 1 ORDER BY id LIMIT 100");
+  EXPECT_EQ(MysqlKeysetPaginatorBase::MakePageSql(query, true),
+            "select id, name from users WHERE (status = ? or vip = 1) AND id > ? ORDER BY id LIMIT 100");
+}
+
+TEST(MysqlKeysetPaginatorTest, MakePageSqlClampsPageSize) {
+  KeysetPageQuery query;
+  query.select = "select id from users";
+  query.key_column = "id";
+  query.page_size = 0;
+  EXPECT_EQ(MysqlKeysetPaginatorBase::MakePageSql(query, false), "select id from users ORDER BY id LIMIT 1");
+}
+
+}  // namespace trpc::testing
@@ -0,0 +1,124 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#include "trpc/client/mysql/mysql_numa.h"
+
+#include <sched.h>
+
+#include <algorithm>
+#include <fstream>
+
+#include "trpc/util/log/logging.h"
+
+namespace trpc::mysql {
+
+namespace {
+
+/// Node indexes above it are ignored, MAX_NUMNODES of the kernel.
+constexpr int kMaxNodes = 1024;
+
+}  // namespace
+
+const MysqlNumaTopology& MysqlNumaTopology::GetInstance() {
+  static const MysqlNumaTopology topology(ReadNodeCpuLists("/sys/devices/system/node"));
+  return topology;
+}
+
+std::vector<std::string> MysqlNumaTopology::ReadNodeCpuLists(const std::string& node_dir) {
+  // The online nodes may be sparse, e.g. "0,2" once a node was taken offline.
+  std::string online;
+  std::ifstream online_file(node_dir + "/online");
+  if (!online_file || !std::getline(online_file, online)) return {};
+  std::vector<int> nodes;
+  if (!ParseCpuList(online, nodes) || nodes.empty()) {
+    TRPC_FMT_ERROR("Invalid online numa nodes: {}, ignore them.", online);
+    return {};
+  }
+
+  std::vector<std::string> cpu_lists;
+  for (int node : nodes) {
+    if (node >= kMaxNodes) continue;
+    if (static_cast<size_t>(node) >= cpu_lists.size()) cpu_lists.resize(node + 1);
+    std::ifstream file(node_dir + "/node" + std::to_string(node) + "/cpulist");
+    if (file) std::getline(file, cpu_lists[node]);
+  }
+  return cpu_lists;
+}
+
+MysqlNumaTopology::MysqlNumaTopology(const std::vector<std::string>& node_cpu_lists) {
+  if (node_cpu_lists.empty()) return;
+
+  // Offline nodes and nodes with memory only get no index, no thread ever runs on them.
+  uint32_t index = 0;
+  for (size_t node = 0; node < node_cpu_lists.size(); ++node) {
+    std::vector<int> cpus;
+    if (!ParseCpuList(node_cpu_lists[node], cpus)) {
+      TRPC_FMT_ERROR("Invalid cpu list of numa node {}: {}, ignore it.", node, node_cpu_lists[node]);
+      continue;
+    }
+    if (cpus.empty()) continue;
+    for (int cpu : cpus) {
+      if (static_cast<size_t>(cpu) >= cpu_nodes_.size()) cpu_nodes_.resize(cpu + 1, 0);
+      cpu_nodes_[cpu] = index;
+    }
+    ++index;
+  }
+  node_count_ = std::max<uint32_t>(index, 1);
+}
+
+uint32_t MysqlNumaTopology::GetNodeOfCpu(int cpu) const {
+  if (cpu < 0 || static_cast<size_t>(cpu) >= cpu_nodes_.size()) return 0;
+  return cpu_nodes_[cpu];
+}
+
+uint32_t MysqlNumaTopology::GetCurrentNode() const {
+  if (node_count_ == 1) return 0;
+  // A vDSO call on common platforms, no system call.
+  return GetNodeOfCpu(sched_getcpu());
+}
+
+bool MysqlNumaTopology::ParseCpuList(const std::string& cpu_list, std::vector<int>& cpus) {
+  cpus.clear();
+  size_t pos = 0;
+  while (pos < cpu_list.size()) {
+    size_t end = cpu_list.find(',', pos);
+    if (end == std::string::npos) end = cpu_list.size();
+    std::string range = cpu_list.substr(pos, end - pos);
+    pos = end + 1;
+    if (range.empty()) continue;
+
+    size_t dash = range.find('-');
+    int first = 0;
+    int last = 0;
+    try {
+      size_t parsed = 0;
+      first = std::stoi(range, &parsed);
+      if (dash == std::string::npos) {
+        if (parsed != range.size()) return false;
+        last = first;
+      } else {
+        if (parsed != dash) return false;
+        std::string tail = range.substr(dash + 1);
+        last = std::stoi(tail, &parsed);
+        if (parsed != tail.size()) return false;
+      }
+    } catch (const std::exception&) {
+      return false;
+    }
+    if (first < 0 || last < first) return false;
+    for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+  }
+  return true;
+}
+
+}  // namespace trpc::mysql
@@ -0,0 +1,58 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace trpc::mysql {
+
+/// @brief The NUMA topology of the host, read from /sys/devices/system/node once (`numa_aware` in MysqlClientConf).
+/// A host without NUMA information is seen as a single node.
+class MysqlNumaTopology {
+ public:
+  static const MysqlNumaTopology& GetInstance();
+
+  /// @brief Builds the topology from the "cpulist" of each node, by node index. Nodes may be empty.
+  /// The nodes with CPUs are numbered from 0 in the order of their indexes, the empty ones are left out.
+  explicit MysqlNumaTopology(const std::vector<std::string>& node_cpu_lists);
+
+  /// @brief The number of nodes with CPUs, at least 1.
+  uint32_t GetNodeCount() const { return node_count_; }
+
+  /// @return The number of the node of `cpu` among the nodes with CPUs, 0 if unknown.
+  uint32_t GetNodeOfCpu(int cpu) const;
+
+  /// @brief The node of the CPU running the calling thread, 0 if unknown. Stable for pinned threads, e.g. with
+  /// `thread_bind_core`.
+  uint32_t GetCurrentNode() const;
+
+  /// @brief Reads the "cpulist" of each online node listed by "online" in `node_dir`, by node index. The nodes which
+  /// are not online have an empty list.
+  /// @return Empty if `node_dir` has no NUMA information.
+  static std::vector<std::string> ReadNodeCpuLists(const std::string& node_dir);
+
+  /// @brief Parses a Linux cpu list, e.g. "0-3,8,10-11".
+  /// @return false if it is malformed.
+  static bool ParseCpuList(const std::string& cpu_list, std::vector<int>& cpus);
+
+ private:
+  uint32_t node_count_{1};
+
+  /// Node of each CPU by its index.
+  std::vector<uint32_t> cpu_nodes_;
+};
+
+}  // namespace trpc::mysql
@@ -0,0 +1,95 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#include "trpc/client/mysql/mysql_numa.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace trpc::testing {
+
+using trpc::mysql::MysqlNumaTopology;
+
+TEST(MysqlNumaTopologyTest, ParseCpuList) {
+  std::vector<int> cpus;
+  EXPECT_TRUE(MysqlNumaTopology::ParseCpuList("0-3,8,10-11", cpus));
+  EXPECT_EQ(cpus, std::vector<int>({0, 1, 2, 3, 8, 10, 11}));
+
+  EXPECT_TRUE(MysqlNumaTopology::ParseCpuList("", cpus));
+  EXPECT_TRUE(cpus.empty());
+
+  EXPECT_FALSE(MysqlNumaTopology::ParseCpuList("3-1", cpus));
+  EXPECT_FALSE(MysqlNumaTopology::ParseCpuList("1-", cpus));
+  EXPECT_FALSE(MysqlNumaTopology::ParseCpuList("a", cpus));
+  EXPECT_FALSE(MysqlNumaTopology::ParseCpuList("1x", cpus));
+}
+
+TEST(MysqlNumaTopologyTest, NodeOfCpu) {
+  MysqlNumaTopology topology({"0-3,8-11", "4-7,12-15"});
+  EXPECT_EQ(topology.GetNodeCount(), 2);
+  EXPECT_EQ(topology.GetNodeOfCpu(2), 0);
+  EXPECT_EQ(topology.GetNodeOfCpu(9), 0);
+  EXPECT_EQ(topology.GetNodeOfCpu(5), 1);
+  EXPECT_EQ(topology.GetNodeOfCpu(15), 1);
+  // Unknown CPUs fall back to the first node.
+  EXPECT_EQ(topology.GetNodeOfCpu(64), 0);
+  EXPECT_EQ(topology.GetNodeOfCpu(-1), 0);
+
+  // No NUMA information: a single node.
+  MysqlNumaTopology single({});
+  EXPECT_EQ(single.GetNodeCount(), 1);
+  EXPECT_EQ(single.GetCurrentNode(), 0);
+
+  const MysqlNumaTopology& host = MysqlNumaTopology::GetInstance();
+  EXPECT_GE(host.GetNodeCount(), 1);
+  EXPECT_LT(host.GetCurrentNode(), host.GetNodeCount());
+}
+
+TEST(MysqlNumaTopologyTest, ReadNodeCpuLists) {
+  char dir_template[] = "/tmp/mysql_numa_test_XXXXXX";
+  ASSERT_NE(mkdtemp(dir_template), nullptr);
+  std::string dir = dir_template;
+
+  // No NUMA information.
+  EXPECT_TRUE(MysqlNumaTopology::ReadNodeCpuLists(dir).empty());
+
+  // Node 1 is offline, the nodes after it are still read.
+  std::ofstream(dir + "/online") << "0,2\n";
+  ASSERT_EQ(mkdir((dir + "/node0").c_str(), 0755), 0);
+  ASSERT_EQ(mkdir((dir + "/node2").c_str(), 0755), 0);
+  std::ofstream(dir + "/node0/cpulist") << "0-1\n";
+  std::ofstream(dir + "/node2/cpulist") << "2-3\n";
+
+  std::vector<std::string> cpu_lists = MysqlNumaTopology::ReadNodeCpuLists(dir);
+  EXPECT_EQ(cpu_lists, std::vector<std::string>({"0-1", "", "2-3"}));
+  MysqlNumaTopology topology(cpu_lists);
+  // The offline node takes no shards of the pools.
+  EXPECT_EQ(topology.GetNodeCount(), 2);
+  EXPECT_EQ(topology.GetNodeOfCpu(1), 0);
+  EXPECT_EQ(topology.GetNodeOfCpu(3), 1);
+
+  unlink((dir + "/node0/cpulist").c_str());
+  unlink((dir + "/node2/cpulist").c_str());
+  rmdir((dir + "/node0").c_str());
+  rmdir((dir + "/node2").c_str());
+  unlink((dir + "/online").c_str());
+  rmdir(dir.c_str());
+}
+
+}  // namespace trpc::testing
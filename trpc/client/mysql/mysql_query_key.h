@@ -0,0 +1,97 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
+#if __cplusplus >= 202002L
+#include <span>
+#endif
+
+#include "trpc/client/mysql/executor/mysql_results.h"
+#include "trpc/client/mysql/executor/mysql_type.h"
+
+namespace trpc::mysql {
+
+/// @brief Identity of a query, used to share its results between identical calls (see MysqlResultCache and
+/// MysqlSingleflight).
+class MysqlQueryKey {
+ public:
+  /// @brief The exact statement text (a fingerprint would lose the inline literals), the type of the results and
+  /// the bound arguments, each with its type so that e.g. 1 and "1" differ.
+  template <typename... OutputArgs, typename... InputArgs>
+  static std::string Make(const std::string& sql_str, const InputArgs&... args) {
+    std::string key;
+    key.reserve(sql_str.size() + 64);
+    AppendBytes(key, sql_str);
+    AppendBytes(key, typeid(MysqlResults<OutputArgs...>).name());
+    (AppendArg(key, args), ...);
+    return key;
+  }
+
+ private:
+  static void AppendArg(std::string& key, std::string_view value) {
+    key.push_back('s');
+    AppendBytes(key, value);
+  }
+
+  static void AppendArg(std::string& key, const MysqlBlob& value) {
+    key.push_back('b');
+    AppendBytes(key, std::string_view(value.DataConstPtr(), value.Size()));
+  }
+
+  static void AppendArg(std::string& key, const MysqlTime& value) {
+    key.push_back('t');
+    AppendBytes(key, value.ToString() + "." + std::to_string(value.SetSecondPart()));
+  }
+
+  template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+  static void AppendArg(std::string& key, T value) {
+    key.push_back(std::is_floating_point_v<T> ? 'f' : (std::is_signed_v<T> ? 'i' : 'u'));
+    key.push_back(static_cast<char>(sizeof(T)));
+    key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  template <typename T, typename Alloc>
+  static void AppendArg(std::string& key, const std::vector<T, Alloc>& values) {
+    AppendList(key, values);
+  }
+
+#if __cplusplus >= 202002L
+  template <typename T, size_t Extent>
+  static void AppendArg(std::string& key, const std::span<T, Extent>& values) {
+    AppendList(key, values);
+  }
+#endif
+
+  template <typename List>
+  static void AppendList(std::string& key, const List& values) {
+    uint32_t size = static_cast<uint32_t>(values.size());
+    key.push_back('l');
+    key.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    for (const auto& value : values) AppendArg(key, value);
+  }
+
+  static void AppendBytes(std::string& key, std::string_view bytes) {
+    uint32_t size = static_cast<uint32_t>(bytes.size());
+    key.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    key.append(bytes);
+  }
+};
+
+}  // namespace trpc::mysql
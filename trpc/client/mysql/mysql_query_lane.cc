@@ -0,0 +1,55 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+
+#include "trpc/client/mysql/mysql_query_lane.h"
+
+#include <utility>
+
+namespace trpc::mysql {
+
+MysqlQueryLane::MysqlQueryLane(size_t index, const MysqlQueryClassConf& conf) : index_(index), conf_(conf) {}
+
+void MysqlQueryLane::Start(bool fiber_mode) {
+  if (fiber_mode || conf_.thread_num == 0 || thread_pool_ != nullptr) return;
+
+  thread_pool_ = std::make_unique<MysqlWorkerPool>(conf_.thread_num, false);
+  thread_pool_->Start();
+}
+
+void MysqlQueryLane::Stop() {
+  if (thread_pool_) thread_pool_->Stop();
+}
+
+void MysqlQueryLane::Join() {
+  if (thread_pool_) thread_pool_->Join();
+}
+
+void MysqlQueryLane::Retire() {
+  if (thread_pool_) thread_pool_->Retire();
+}
+
+bool MysqlQueryLane::TryEnter() {
+  if (conf_.max_queue_size == 0) {
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  uint32_t pending = pending_.load(std::memory_order_relaxed);
+  do {
+    if (pending >= conf_.max_queue_size) return false;
+  } while (!pending_.compare_exchange_weak(pending, pending + 1, std::memory_order_relaxed));
+  return true;
+}
+
+}  // namespace trpc::mysql
@@ -0,0 +1,71 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "trpc/client/mysql/config/mysql_client_conf.h"
+#include "trpc/client/mysql/mysql_worker_pool.h"
+
+namespace trpc::mysql {
+
+/// @brief Runtime of a query class (`query_classes` in MysqlClientConf): its own worker threads and its queue limit.
+/// Its connection quota is kept by each MysqlExecutorPool under the index of the lane.
+/// @note Classes are isolated rather than scheduled by priority on shared workers: a worker blocked in libmysqlclient
+/// cannot be preempted, so once slow queries hold every shared worker no priority would let a fast query run.
+class MysqlQueryLane {
+ public:
+  MysqlQueryLane(size_t index, const MysqlQueryClassConf& conf);
+
+  /// @brief Starts the worker threads of the class, if it has its own (`thread_num` > 0 in "thread_pool" mode).
+  void Start(bool fiber_mode);
+
+  void Stop();
+
+  void Join();
+
+  /// @brief Stops the workers once the tasks posted to them have run, see MysqlWorkerPool::Retire.
+  void Retire();
+
+  size_t GetIndex() const { return index_; }
+
+  const MysqlQueryClassConf& GetConf() const { return conf_; }
+
+  /// @return nullptr if the class uses the default workers.
+  MysqlWorkerPool* GetThreadPool() { return thread_pool_.get(); }
+
+  /// @brief Counts a call queued or running in the class.
+  /// @return false if the class has `max_queue_size` calls already. `Leave` must not be called then.
+  bool TryEnter();
+
+  void Leave() { pending_.fetch_sub(1, std::memory_order_relaxed); }
+
+  uint32_t GetPending() const { return pending_.load(std::memory_order_relaxed); }
+
+ private:
+  size_t index_;
+
+  MysqlQueryClassConf conf_;
+
+  std::unique_ptr<MysqlWorkerPool> thread_pool_{nullptr};
+
+  std::atomic<uint32_t> pending_{0};
+};
+
+}  // namespace trpc::mysql
@@ -0,0 +1,67 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+
+#include "trpc/client/mysql/mysql_query_lane.h"
+
+#include "gtest/gtest.h"
+
+namespace trpc::testing {
+
+using trpc::mysql::MysqlQueryClassConf;
+using trpc::mysql::MysqlQueryLane;
+
+TEST(MysqlQueryLaneTest, QueueLimit) {
+  MysqlQueryClassConf conf;
+  conf.name = "report";
+  conf.max_queue_size = 2;
+  MysqlQueryLane lane(1, conf);
+  EXPECT_EQ(lane.GetIndex(), 1);
+  EXPECT_EQ(lane.GetConf().name, "report");
+
+  EXPECT_TRUE(lane.TryEnter());
+  EXPECT_TRUE(lane.TryEnter());
+  EXPECT_FALSE(lane.TryEnter());
+  EXPECT_EQ(lane.GetPending(), 2);
+
+  lane.Leave();
+  EXPECT_TRUE(lane.TryEnter());
+  lane.Leave();
+  lane.Leave();
+  EXPECT_EQ(lane.GetPending(), 0);
+}
+
+TEST(MysqlQueryLaneTest, Unlimited) {
+  MysqlQueryClassConf conf;
+  conf.name = "lookup";
+  MysqlQueryLane lane(0, conf);
+  for (int i = 0; i < 1000; ++i) EXPECT_TRUE(lane.TryEnter());
+  EXPECT_EQ(lane.GetPending(), 1000);
+}
+
+TEST(MysqlQueryLaneTest, SharedWorkers) {
+  MysqlQueryClassConf conf;
+  conf.name = "shared";
+  conf.thread_num = 0;
+  MysqlQueryLane lane(0, conf);
+  lane.Start(false);
+  EXPECT_EQ(lane.GetThreadPool(), nullptr);
+
+  // Fiber mode never creates threads.
+  conf.thread_num = 2;
+  MysqlQueryLane fiber_lane(0, conf);
+  fiber_lane.Start(true);
+  EXPECT_EQ(fiber_lane.GetThreadPool(), nullptr);
+}
+
+}  // namespace trpc::testing
@@ -0,0 +1,105 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#include "trpc/client/mysql/mysql_replica_router.h"
+
+#include <limits>
+
+#include "trpc/util/log/logging.h"
+
+namespace trpc::mysql {
+
+MysqlReplicaRouter::MysqlReplicaRouter(const std::string& primary, const std::vector<std::string>& replicas) {
+  if (!primary.empty()) {
+    has_primary_ = ParseAddr(primary, primary_);
+    if (!has_primary_) TRPC_FMT_ERROR("Invalid mysql primary address: {}.", primary);
+  }
+
+  for (const auto& replica : replicas) {
+    auto entry = std::make_unique<Replica>();
+    if (!ParseAddr(replica, entry->addr)) {
+      TRPC_FMT_ERROR("Invalid mysql replica address: {}, ignore it.", replica);
+      continue;
+    }
+    replicas_.emplace_back(std::move(entry));
+  }
+}
+
+size_t MysqlReplicaRouter::AcquireReplica(NodeAddr& node_addr, int exclude) {
+  const size_t n = replicas_.size();
+  const size_t start = next_.fetch_add(1, std::memory_order_relaxed) % n;
+
+  size_t best = start;
+  uint32_t least = std::numeric_limits<uint32_t>::max();
+  for (size_t i = 0; i < n; ++i) {
+    size_t index = (start + i) % n;
+    if (n > 1 && static_cast<int>(index) == exclude) continue;
+    uint32_t outstanding = replicas_[index]->outstanding.load(std::memory_order_relaxed);
+    if (outstanding < least) {
+      least = outstanding;
+      best = index;
+      if (least == 0) break;
+    }
+  }
+
+  replicas_[best]->outstanding.fetch_add(1, std::memory_order_relaxed);
+  node_addr = replicas_[best]->addr;
+  return best;
+}
+
+void MysqlReplicaRouter::ReleaseReplica(size_t index) {
+  replicas_[index]->outstanding.fetch_sub(1, std::memory_order_relaxed);
+}
+
+uint32_t MysqlReplicaRouter::GetOutstanding(size_t index) const {
+  return replicas_[index]->outstanding.load(std::memory_order_relaxed);
+}
+
+void MysqlReplicaRouter::CountGtidWait(bool fallback) {
+  gtid_waits_.fetch_add(1, std::memory_order_relaxed);
+  if (fallback) gtid_fallbacks_.fetch_add(1, std::memory_order_relaxed);
+}
+
+ReplicaReadStats MysqlReplicaRouter::GetReadStats() const {
+  ReplicaReadStats stats;
+  stats.gtid_waits = gtid_waits_.load(std::memory_order_relaxed);
+  stats.gtid_fallbacks = gtid_fallbacks_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+bool MysqlReplicaRouter::ParseAddr(const std::string& addr, NodeAddr& node_addr) {
+  size_t pos = addr.rfind(':');
+  if (pos == std::string::npos || pos == 0 || pos + 1 == addr.size()) return false;
+
+  std::string ip = addr.substr(0, pos);
+  bool ipv6 = false;
+  if (ip.front() == '[') {
+    if (ip.size() < 3 || ip.back() != ']') return false;
+    ip = ip.substr(1, ip.size() - 2);
+    ipv6 = true;
+  }
+
+  uint32_t port = 0;
+  for (size_t i = pos + 1; i < addr.size(); ++i) {
+    if (addr[i] < '0' || addr[i] > '9') return false;
+    port = port * 10 + (addr[i] - '0');
+    if (port > std::numeric_limits<uint16_t>::max()) return false;
+  }
+
+  node_addr.addr_type = ipv6 ? NodeAddr::AddrType::kIpV6 : NodeAddr::AddrType::kIpV4;
+  node_addr.ip = std::move(ip);
+  node_addr.port = static_cast<uint16_t>(port);
+  return true;
+}
+
+}  // namespace trpc::mysql
@@ -0,0 +1,91 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "trpc/transport/common/transport_message_common.h"
+
+namespace trpc::mysql {
+
+/// @brief Counters of the replica reads which waited for a GTID (`read_your_writes` in MysqlClientConf).
+struct ReplicaReadStats {
+  /// Replica reads preceded by WAIT_FOR_EXECUTED_GTID_SET.
+  uint64_t gtid_waits{0};
+
+  /// Reads sent to the primary because the replica did not apply the GTID in time.
+  uint64_t gtid_fallbacks{0};
+};
+
+/// @brief Routes the calls of MysqlServiceProxy between a primary and its replicas (read/write splitting).
+/// Writes go to the primary, reads go to the replica with the least outstanding requests.
+/// @note Each address has its own MysqlExecutorPool in MysqlExecutorPoolManager.
+class MysqlReplicaRouter {
+ public:
+  /// @param primary "ip:port", empty means the target selected by the service proxy is used for writes.
+  /// @param replicas "ip:port" of each replica. Reads go to the primary if it is empty.
+  MysqlReplicaRouter(const std::string& primary, const std::vector<std::string>& replicas);
+
+  bool HasPrimary() const { return has_primary_; }
+
+  const NodeAddr& GetPrimary() const { return primary_; }
+
+  bool HasReplicas() const { return !replicas_.empty(); }
+
+  size_t GetReplicaCount() const { return replicas_.size(); }
+
+  /// @brief Picks the replica with the least outstanding requests and counts a request on it.
+  /// Ties are broken round robin.
+  /// @param exclude Index of a replica not to pick unless it is the only one, e.g. the replica of a hedged read.
+  /// @return Index of the replica, which must be passed to `ReleaseReplica` when the request finishes.
+  size_t AcquireReplica(NodeAddr& node_addr, int exclude = -1);
+
+  void ReleaseReplica(size_t index);
+
+  /// @brief Outstanding requests on the replica `index`.
+  uint32_t GetOutstanding(size_t index) const;
+
+  /// @brief Counts a replica read which waited for a GTID.
+  /// @param fallback Whether the read has been sent to the primary instead.
+  void CountGtidWait(bool fallback);
+
+  ReplicaReadStats GetReadStats() const;
+
+  /// @brief Parses "ip:port". The ip may be an IPv6 address in brackets, e.g. "[::1]:3306".
+  static bool ParseAddr(const std::string& addr, NodeAddr& node_addr);
+
+ private:
+  struct Replica {
+    NodeAddr addr;
+    std::atomic<uint32_t> outstanding{0};
+  };
+
+  bool has_primary_{false};
+
+  NodeAddr primary_;
+
+  std::vector<std::unique_ptr<Replica>> replicas_;
+
+  std::atomic<uint32_t> next_{0};
+
+  std::atomic<uint64_t> gtid_waits_{0};
+
+  std::atomic<uint64_t> gtid_fallbacks_{0};
+};
+
+}  // namespace trpc::mysql
@@ -0,0 +1,82 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#include "trpc/client/mysql/mysql_replica_router.h"
+
+#include "gtest/gtest.h"
+
+namespace trpc::testing {
+
+using trpc::mysql::MysqlReplicaRouter;
+
+TEST(MysqlReplicaRouterTest, ParseAddr) {
+  NodeAddr node_addr;
+  EXPECT_TRUE(MysqlReplicaRouter::ParseAddr("127.0.0.1:3306", node_addr));
+  EXPECT_EQ(node_addr.ip, "127.0.0.1");
+  EXPECT_EQ(node_addr.port, 3306);
+
+  EXPECT_TRUE(MysqlReplicaRouter::ParseAddr("[::1]:3307", node_addr));
+  EXPECT_EQ(node_addr.ip, "::1");
+  EXPECT_EQ(node_addr.port, 3307);
+  EXPECT_EQ(node_addr.addr_type, NodeAddr::AddrType::kIpV6);
+
+  EXPECT_FALSE(MysqlReplicaRouter::ParseAddr("127.0.0.1", node_addr));
+  EXPECT_FALSE(MysqlReplicaRouter::ParseAddr("127.0.0.1:", node_addr));
+  EXPECT_FALSE(MysqlReplicaRouter::ParseAddr(":3306", node_addr));
+  EXPECT_FALSE(MysqlReplicaRouter::ParseAddr("127.0.0.1:65536", node_addr));
+  EXPECT_FALSE(MysqlReplicaRouter::ParseAddr("127.0.0.1:33a", node_addr));
+}
+
+TEST(MysqlReplicaRouterTest, Config) {
+  MysqlReplicaRouter empty("", {});
+  EXPECT_FALSE(empty.HasPrimary());
+  EXPECT_FALSE(empty.HasReplicas());
+
+  MysqlReplicaRouter router("10.0.0.1:3306", {"10.0.0.2:3306", "invalid", "10.0.0.3:3306"});
+  EXPECT_TRUE(router.HasPrimary());
+  EXPECT_EQ(router.GetPrimary().ip, "10.0.0.1");
+  EXPECT_EQ(router.GetReplicaCount(), 2);
+}
+
+TEST(MysqlReplicaRouterTest, LeastOutstandingRequests) {
+  MysqlReplicaRouter router("", {"10.0.0.1:3306", "10.0.0.2:3306", "10.0.0.3:3306"});
+
+  // Idle replicas are used in turn.
+  NodeAddr node_addr;
+  size_t a = router.AcquireReplica(node_addr);
+  size_t b = router.AcquireReplica(node_addr);
+  size_t c = router.AcquireReplica(node_addr);
+  EXPECT_NE(a, b);
+  EXPECT_NE(b, c);
+  EXPECT_NE(a, c);
+
+  // The only replica without an outstanding request is picked.
+  router.ReleaseReplica(b);
+  for (int i = 0; i < 3; ++i) {
+    size_t picked = router.AcquireReplica(node_addr);
+    EXPECT_EQ(picked, b);
+    EXPECT_EQ(router.GetOutstanding(b), 1);
+    router.ReleaseReplica(picked);
+  }
+
+  // The excluded replica is skipped even though it is the least loaded one.
+  size_t other = router.AcquireReplica(node_addr, static_cast<int>(b));
+  EXPECT_NE(other, b);
+  router.ReleaseReplica(other);
+
+  router.ReleaseReplica(a);
+  router.ReleaseReplica(c);
+  for (size_t i = 0; i < router.GetReplicaCount(); ++i) EXPECT_EQ(router.GetOutstanding(i), 0);
+}
+
+}  // namespace trpc::testing
@@ -0,0 +1,267 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#include "trpc/client/mysql/mysql_result_cache.h"
+
+#include <algorithm>
+#include <cctype>
+
+#include "trpc/util/time.h"
+
+namespace trpc::mysql {
+
+namespace {
+
+/// Fixed cost of an entry in the LRU list and the index.
+constexpr size_t kEntryOverhead = 128;
+
+std::string ToLower(std::string s) {
+  std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::tolower(c); });
+  return s;
+}
+
+/// Reads the SQL words of a statement, skipping comments.
+class WordReader {
+ public:
+  explicit WordReader(std::string_view sql) : sql_(sql) {}
+
+  /// @return The next word in lower case: a keyword, or an identifier without its backquotes. Empty at the end
+  /// or before a punctuation.
+  std::string Next() {
+    SkipSpaces();
+    std::string word;
+    if (pos_ < sql_.size() && sql_[pos_] == '`') {
+      size_t end = sql_.find('`', pos_ + 1);
+      if (end == std::string_view::npos) end = sql_.size();
+      word.assign(sql_.substr(pos_ + 1, end - pos_ - 1));
+      pos_ = std::min(end + 1, sql_.size());
+    } else {
+      while (pos_ < sql_.size() && (std::isalnum(static_cast<unsigned char>(sql_[pos_])) || sql_[pos_] == '_' ||
+                                    sql_[pos_] == '$')) {
+        word.push_back(sql_[pos_++]);
+      }
+    }
+    return ToLower(std::move(word));
+  }
+
+  /// @brief Consumes `c` if it is the next character.
+  bool Consume(char c) {
+    SkipSpaces();
+    if (pos_ >= sql_.size() || sql_[pos_] != c) return false;
+    ++pos_;
+    return true;
+  }
+
+  /// @return The table name of "[schema.]table", without the schema.
+  std::string NextTable() {
+    std::string table = Next();
+    while (!table.empty() && Consume('.')) table = Next();
+    return table;
+  }
+
+ private:
+  void SkipSpaces() {
+    while (pos_ < sql_.size()) {
+      char c = sql_[pos_];
+      if (std::isspace(static_cast<unsigned char>(c))) {
+        ++pos_;
+      } else if (c == '#' || (c == '-' && sql_.substr(pos_, 3) == "-- ")) {
+        size_t end = sql_.find('\n', pos_);
+        pos_ = end == std::string_view::npos ? sql_.size() : end + 1;
+      } else if (sql_.substr(pos_, 2) == "/*") {
+        size_t end = sql_.find("*/", pos_ + 2);
+        pos_ = end == std::string_view::npos ? sql_.size() : end + 2;
+      } else {
+        break;
+      }
+    }
+  }
+
+  std::string_view sql_;
+
+  size_t pos_{0};
+};
+
+/// @return The first word which is not one of `modifiers`.
+std::string SkipModifiers(WordReader& reader, std::initializer_list<std::string_view> modifiers) {
+  std::string word = reader.Next();
+  while (std::find(modifiers.begin(), modifiers.end(), word) != modifiers.end()) word = reader.Next();
+  return word;
+}
+
+}  // namespace
+
+MysqlResultCache::MysqlResultCache(size_t capacity_bytes, size_t shard_num) {
+  shard_num = std::max<size_t>(shard_num, 1);
+  shard_capacity_ = capacity_bytes / shard_num;
+  for (size_t i = 0; i < shard_num; ++i) shards_.emplace_back(std::make_unique<Shard>());
+}
+
+std::shared_ptr<const void> MysqlResultCache::Lookup(const std::string& key) {
+  Shard& shard = GetShard(key);
+  std::scoped_lock _(shard.mutex);
+  auto it = shard.index.find(key);
+  if (it == shard.index.end()) {
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  auto entry = it->second;
+  if (entry->expire_ms <= trpc::GetSteadyMilliSeconds() || !IsValid(entry->tags)) {
+    Erase(shard, entry);
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  shard.lru.splice(shard.lru.begin(), shard.lru, entry);
+  hits_.fetch_add(1, std::memory_order_relaxed);
+  return entry->value;
+}
+
+void MysqlResultCache::Insert(const std::string& key, std::shared_ptr<const void> value, size_t bytes,
+                              uint64_t ttl_ms, ResultCacheTags tags) {
+  bytes += kEntryOverhead;
+  if (bytes > shard_capacity_ || !IsValid(tags)) return;
+
+  Shard& shard = GetShard(key);
+  std::scoped_lock _(shard.mutex);
+  auto it = shard.index.find(key);
+  if (it != shard.index.end()) Erase(shard, it->second);
+
+  while (shard.bytes + bytes > shard_capacity_ && !shard.lru.empty()) {
+    Erase(shard, std::prev(shard.lru.end()));
+    evictions_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  shard.lru.emplace_front(Entry{key, std::move(value), bytes, trpc::GetSteadyMilliSeconds() + ttl_ms,
+                                std::move(tags)});
+  shard.index.emplace(shard.lru.front().key, shard.lru.begin());
+  shard.bytes += bytes;
+}
+
+void MysqlResultCache::Erase(Shard& shard, std::list<Entry>::iterator it) {
+  shard.bytes -= it->bytes;
+  shard.index.erase(it->key);
+  shard.lru.erase(it);
+}
+
+bool MysqlResultCache::IsValid(const ResultCacheTags& tags) const {
+  if (tags.all_generation != all_generation_.load(std::memory_order_acquire)) return false;
+  for (const auto& [generation, value] : tags.generations) {
+    if (generation->load(std::memory_order_acquire) != value) return false;
+  }
+  return true;
+}
+
+std::atomic<uint64_t>* MysqlResultCache::GetGeneration(const std::string& table) {
+  {
+    std::shared_lock _(tables_mutex_);
+    auto it = table_generations_.find(table);
+    if (it != table_generations_.end()) return it->second.get();
+  }
+
+  std::unique_lock _(tables_mutex_);
+  auto& generation = table_generations_[table];
+  if (generation == nullptr) generation = std::make_unique<std::atomic<uint64_t>>(0);
+  return generation.get();
+}
+
+ResultCacheTags MysqlResultCache::GetTags(const std::vector<std::string>& tables) {
+  ResultCacheTags tags;
+  tags.all_generation = all_generation_.load(std::memory_order_acquire);
+  tags.generations.reserve(tables.size());
+  for (const auto& table : tables) {
+    const std::atomic<uint64_t>* generation = GetGeneration(ToLower(table));
+    tags.generations.emplace_back(generation, generation->load(std::memory_order_acquire));
+  }
+  return tags;
+}
+
+void MysqlResultCache::Invalidate(const std::vector<std::string>& tables) {
+  for (const auto& table : tables) {
+    invalidations_.fetch_add(1, std::memory_order_relaxed);
+    if (table == kAllTables) {
+      all_generation_.fetch_add(1, std::memory_order_acq_rel);
+      for (auto& shard : shards_) {
+        std::scoped_lock _(shard->mutex);
+        shard->index.clear();
+        shard->lru.clear();
+        shard->bytes = 0;
+      }
+      return;
+    }
+
+    // Stale entries are dropped when they are looked up or evicted.
+    GetGeneration(ToLower(table))->fetch_add(1, std::memory_order_acq_rel);
+  }
+}
+
+ResultCacheStats MysqlResultCache::GetStats() const {
+  ResultCacheStats stats;
+  stats.hits = hits_.load(std::memory_order_relaxed);
+  stats.misses = misses_.load(std::memory_order_relaxed);
+  stats.evictions = evictions_.load(std::memory_order_relaxed);
+  stats.invalidations = invalidations_.load(std::memory_order_relaxed);
+  for (const auto& shard : shards_) {
+    std::scoped_lock _(shard->mutex);
+    stats.entries += shard->lru.size();
+    stats.bytes += shard->bytes;
+  }
+  return stats;
+}
+
+std::vector<std::string> MysqlResultCache::GetWrittenTables(std::string_view sql) {
+  WordReader reader(sql);
+  std::string word = reader.Next();
+
+  std::string table;
+  if (word == "insert" || word == "replace") {
+    word = SkipModifiers(reader, {"low_priority", "delayed", "high_priority", "ignore"});
+    table = word == "into" ? reader.NextTable() : word;
+    while (reader.Consume('.')) table = reader.Next();
+  } else if (word == "update") {
+    table = SkipModifiers(reader, {"low_priority", "ignore"});
+    while (reader.Consume('.')) table = reader.Next();
+    // Only "UPDATE t [[AS] alias] SET", the tables of a multi-table UPDATE are given by its SET clause.
+    word = reader.Next();
+    if (word == "as") reader.Next();
+    if (word != "set" && !word.empty()) word = reader.Next();
+    if (word != "set") table.clear();
+  } else if (word == "delete") {
+    if (SkipModifiers(reader, {"low_priority", "quick", "ignore"}) == "from") {
+      table = reader.NextTable();
+      if (reader.Consume(',')) table.clear();
+    }
+  } else if (word == "truncate") {
+    table = reader.NextTable();
+    if (table == "table") table = reader.NextTable();
+  } else if (word == "alter" || word == "drop") {
+    // ALTER TABLE t, DROP TABLE [IF EXISTS] t. Other objects (e.g. views) fall back to all tables.
+    if (reader.Next() == "table") {
+      table = reader.NextTable();
+      if (table == "if" && reader.Next() == "exists") table = reader.NextTable();
+      if (reader.Consume(',')) table.clear();
+    }
+  } else if (word.empty() || word == "select" || word == "show" || word == "explain" || word == "describe" ||
+             word == "desc" || word == "set" || word == "use" || word == "begin" || word == "start" ||
+             word == "commit" || word == "rollback" || word == "savepoint" || word == "release" ||
+             word == "create" || word == "do" || word == "kill" || word == "analyze" || word == "lock" ||
+             word == "unlock") {
+    return {};
+  }
+
+  if (table.empty()) return {kAllTables};
+  return {std::move(table)};
+}
+
+}  // namespace trpc::mysql
@@ -0,0 +1,199 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "trpc/client/mysql/executor/mysql_results.h"
+#include "trpc/client/mysql/executor/mysql_type.h"
+
+namespace trpc::mysql {
+
+/// @brief Counters of a MysqlResultCache.
+struct ResultCacheStats {
+  uint64_t hits{0};
+
+  uint64_t misses{0};
+
+  /// Entries dropped to stay within the byte bound.
+  uint64_t evictions{0};
+
+  /// Tables invalidated by writes, each "all tables" invalidation counts once.
+  uint64_t invalidations{0};
+
+  uint64_t entries{0};
+
+  uint64_t bytes{0};
+};
+
+/// @brief Generations of the tables of a query, taken before the query runs. A result is only valid while none of
+/// them changed, so that a result read before a write is never cached after the write invalidated its tables.
+struct ResultCacheTags {
+  uint64_t all_generation{0};
+
+  std::vector<std::pair<const std::atomic<uint64_t>*, uint64_t>> generations;
+};
+
+/// @brief In-process cache of decoded query results (`result_cache_bytes` in MysqlClientConf): sharded, bounded in
+/// bytes, least recently used entries are evicted first, and each entry has its own TTL. Entries are tagged with
+/// tables, and invalidated when a statement of the same proxy writes one of them (see GetWrittenTables). The keys
+/// are made by MysqlQueryKey.
+/// @note Only BindType results can be cached, NativeString rows point into the MYSQL_RES of their results.
+class MysqlResultCache {
+ public:
+  /// Table name of the statements whose written tables are unknown, which invalidate all the entries.
+  static constexpr char kAllTables[] = "*";
+
+  MysqlResultCache(size_t capacity_bytes, size_t shard_num);
+
+  /// @brief Copies the cached results of `key` to `res`.
+  /// @return false if there is none, or it has expired or been invalidated.
+  template <typename... OutputArgs>
+  bool Get(const std::string& key, MysqlResults<OutputArgs...>& res);
+
+  /// @brief Takes the generations of `tables`, to be passed to `Put` once the query returns.
+  ResultCacheTags GetTags(const std::vector<std::string>& tables);
+
+  /// @brief Caches a copy of `res` for `ttl_ms`, unless `tags` have been invalidated meanwhile.
+  template <typename... OutputArgs>
+  void Put(const std::string& key, const MysqlResults<OutputArgs...>& res, uint64_t ttl_ms, ResultCacheTags tags);
+
+  /// @brief Invalidates the entries tagged with `tables` (case insensitive). kAllTables invalidates all the
+  /// entries.
+  void Invalidate(const std::vector<std::string>& tables);
+
+  ResultCacheStats GetStats() const;
+
+  /// @brief Tables written by `sql`, without schema and in lower case, e.g. "users" for
+  /// "UPDATE `db`.`Users` SET ...". kAllTables if they can not be told (e.g. CALL or a multi-table DELETE), and
+  /// none for a statement which writes no table (e.g. SELECT).
+  static std::vector<std::string> GetWrittenTables(std::string_view sql);
+
+ private:
+  struct Entry {
+    std::string key;
+
+    std::shared_ptr<const void> value;
+
+    size_t bytes{0};
+
+    uint64_t expire_ms{0};
+
+    ResultCacheTags tags;
+  };
+
+  struct Shard {
+    std::mutex mutex;
+
+    /// Most recently used first.
+    std::list<Entry> lru;
+
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+
+    size_t bytes{0};
+  };
+
+  Shard& GetShard(const std::string& key) { return *shards_[std::hash<std::string>()(key) % shards_.size()]; }
+
+  bool IsValid(const ResultCacheTags& tags) const;
+
+  /// @return The cached value, nullptr if there is none or it is stale.
+  std::shared_ptr<const void> Lookup(const std::string& key);
+
+  void Insert(const std::string& key, std::shared_ptr<const void> value, size_t bytes, uint64_t ttl_ms,
+              ResultCacheTags tags);
+
+  static void Erase(Shard& shard, std::list<Entry>::iterator it);
+
+  std::atomic<uint64_t>* GetGeneration(const std::string& table);
+
+  template <typename T>
+  static size_t EstimateBytes(const T& value);
+
+ private:
+  size_t shard_capacity_;
+
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  std::atomic<uint64_t> all_generation_{0};
+
+  mutable std::shared_mutex tables_mutex_;
+
+  /// Generation of each table, bumped by each invalidation. Never erased, so the pointers in ResultCacheTags stay
+  /// valid.
+  std::unordered_map<std::string, std::unique_ptr<std::atomic<uint64_t>>> table_generations_;
+
+  std::atomic<uint64_t> hits_{0};
+
+  std::atomic<uint64_t> misses_{0};
+
+  std::atomic<uint64_t> evictions_{0};
+
+  std::atomic<uint64_t> invalidations_{0};
+};
+
+template <typename T>
+size_t MysqlResultCache::EstimateBytes(const T& value) {
+  if constexpr (std::is_same_v<T, std::string>) {
+    return sizeof(T) + value.capacity();
+  } else if constexpr (std::is_same_v<T, MysqlBlob>) {
+    return sizeof(T) + value.Size();
+  } else {
+    return sizeof(T);
+  }
+}
+
+template <typename... OutputArgs>
+bool MysqlResultCache::Get(const std::string& key, MysqlResults<OutputArgs...>& res) {
+  static_assert(MysqlResults<OutputArgs...>::mode == MysqlResultsMode::BindType, "Only BindType results are cached");
+
+  std::shared_ptr<const void> value = Lookup(key);
+  if (value == nullptr) return false;
+
+  // The cached results are never modified, so they are copied out of the lock.
+  res.CopyFrom(*static_cast<const MysqlResults<OutputArgs...>*>(value.get()));
+  return true;
+}
+
+template <typename... OutputArgs>
+void MysqlResultCache::Put(const std::string& key, const MysqlResults<OutputArgs...>& res, uint64_t ttl_ms,
+                           ResultCacheTags tags) {
+  static_assert(MysqlResults<OutputArgs...>::mode == MysqlResultsMode::BindType, "Only BindType results are cached");
+
+  auto cached = std::make_shared<MysqlResults<OutputArgs...>>();
+  cached->CopyFrom(res);
+
+  size_t bytes = sizeof(*cached) + key.size();
+  for (const auto& row : cached->ResultSet()) {
+    std::apply([&bytes](const auto&... field) { bytes += (EstimateBytes(field) + ... + 0); }, row);
+  }
+  for (const auto& flags : cached->GetNullFlag()) bytes += sizeof(flags) + flags.size();
+  for (const auto& name : cached->GetFieldsName()) bytes += EstimateBytes(name);
+
+  Insert(key, std::move(cached), bytes, ttl_ms, std::move(tags));
+}
+
+}  // namespace trpc::mysql
@@ -0,0 +1,160 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#include "trpc/client/mysql/mysql_result_cache.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "trpc/client/mysql/mysql_query_key.h"
+
+namespace trpc::testing {
+
+using trpc::mysql::MysqlQueryKey;
+using trpc::mysql::MysqlResultCache;
+using trpc::mysql::MysqlResults;
+
+namespace {
+
+void FillResults(MysqlResults<int, std::string>& res, int id, const std::string& name) {
+  res.MutableResultSet().emplace_back(id, name);
+}
+
+std::vector<std::string> Tables(std::string_view sql) { return MysqlResultCache::GetWrittenTables(sql); }
+
+}  // namespace
+
+TEST(MysqlResultCacheTest, QueryKey) {
+  std::string key = MysqlQueryKey::Make<int, std::string>("select * from t where id = ?", 1);
+  EXPECT_EQ(key, (MysqlQueryKey::Make<int, std::string>("select * from t where id = ?", 1)));
+  EXPECT_NE(key, (MysqlQueryKey::Make<int, std::string>("select * from t where id = ?", 2)));
+  EXPECT_NE(key, (MysqlQueryKey::Make<int, std::string>("select * from t where id = ?", int64_t{1})));
+  EXPECT_NE(key, (MysqlQueryKey::Make<int, std::string>("select * from t where id = ?", "1")));
+  EXPECT_NE(key, (MysqlQueryKey::Make<int>("select * from t where id = ?", 1)));
+  EXPECT_NE((MysqlQueryKey::Make<int>("select ?, ?", "a", "bc")),
+            (MysqlQueryKey::Make<int>("select ?, ?", "ab", "c")));
+  EXPECT_NE((MysqlQueryKey::Make<int>("select ? in (?)", std::vector<int>{1, 2}, std::vector<int>{3})),
+            (MysqlQueryKey::Make<int>("select ? in (?)", std::vector<int>{1}, std::vector<int>{2, 3})));
+}
+
+TEST(MysqlResultCacheTest, GetPut) {
+  MysqlResultCache cache(1 << 20, 4);
+  std::string key = MysqlQueryKey::Make<int, std::string>("select id, name from users where id = ?", 1);
+
+  MysqlResults<int, std::string> res;
+  EXPECT_FALSE(cache.Get(key, res));
+
+  MysqlResults<int, std::string> fetched;
+  FillResults(fetched, 1, "alice");
+  cache.Put(key, fetched, 10000, cache.GetTags({"users"}));
+
+  ASSERT_TRUE(cache.Get(key, res));
+  ASSERT_EQ(res.ResultSet().size(), 1);
+  EXPECT_EQ(std::get<1>(res.ResultSet()[0]), "alice");
+
+  auto stats = cache.GetStats();
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.misses, 1);
+  EXPECT_EQ(stats.entries, 1);
+  EXPECT_GT(stats.bytes, 0);
+}
+
+TEST(MysqlResultCacheTest, Ttl) {
+  MysqlResultCache cache(1 << 20, 1);
+  MysqlResults<int, std::string> fetched;
+  FillResults(fetched, 1, "alice");
+  cache.Put("key", fetched, 1, cache.GetTags({}));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  MysqlResults<int, std::string> res;
+  EXPECT_FALSE(cache.Get("key", res));
+  EXPECT_EQ(cache.GetStats().entries, 0);
+}
+
+TEST(MysqlResultCacheTest, Lru) {
+  // One shard which holds about two entries.
+  MysqlResultCache cache(900, 1);
+  MysqlResults<int, std::string> fetched;
+  FillResults(fetched, 1, "alice");
+
+  cache.Put("a", fetched, 10000, cache.GetTags({}));
+  cache.Put("b", fetched, 10000, cache.GetTags({}));
+  MysqlResults<int, std::string> res;
+  EXPECT_TRUE(cache.Get("a", res));
+  cache.Put("c", fetched, 10000, cache.GetTags({}));
+
+  EXPECT_TRUE(cache.Get("a", res));
+  EXPECT_FALSE(cache.Get("b", res));
+  EXPECT_TRUE(cache.Get("c", res));
+  EXPECT_EQ(cache.GetStats().evictions, 1);
+  EXPECT_LE(cache.GetStats().bytes, 900);
+
+  // Larger than the shard.
+  MysqlResults<int, std::string> large;
+  FillResults(large, 1, std::string(1000, 'x'));
+  cache.Put("d", large, 10000, cache.GetTags({}));
+  EXPECT_FALSE(cache.Get("d", res));
+}
+
+TEST(MysqlResultCacheTest, Invalidate) {
+  MysqlResultCache cache(1 << 20, 4);
+  MysqlResults<int, std::string> fetched;
+  FillResults(fetched, 1, "alice");
+  MysqlResults<int, std::string> res;
+
+  cache.Put("users", fetched, 10000, cache.GetTags({"Users"}));
+  cache.Put("orders", fetched, 10000, cache.GetTags({"orders"}));
+  cache.Invalidate(Tables("UPDATE `db`.`USERS` SET name = 'bob' WHERE id = 1"));
+  EXPECT_FALSE(cache.Get("users", res));
+  EXPECT_TRUE(cache.Get("orders", res));
+
+  // Read before the write, put after it.
+  auto tags = cache.GetTags({"orders"});
+  cache.Invalidate({"orders"});
+  cache.Put("orders", fetched, 10000, tags);
+  EXPECT_FALSE(cache.Get("orders", res));
+
+  cache.Put("orders", fetched, 10000, cache.GetTags({"orders"}));
+  cache.Invalidate(Tables("CALL refresh()"));
+  EXPECT_FALSE(cache.Get("orders", res));
+  EXPECT_EQ(cache.GetStats().entries, 0);
+}
+
+TEST(MysqlResultCacheTest, GetWrittenTables) {
+  using Result = std::vector<std::string>;
+  const Result all{MysqlResultCache::kAllTables};
+
+  EXPECT_EQ(Tables("INSERT INTO users (id) VALUES (?)"), Result{"users"});
+  EXPECT_EQ(Tables("insert ignore users values (1)"), Result{"users"});
+  EXPECT_EQ(Tables("/* batch */ REPLACE INTO db.t VALUES (1)"), Result{"t"});
+  EXPECT_EQ(Tables("UPDATE users SET a = 1"), Result{"users"});
+  EXPECT_EQ(Tables("UPDATE LOW_PRIORITY users AS u SET u.a = 1"), Result{"users"});
+  EXPECT_EQ(Tables("UPDATE users u JOIN orders o ON u.id = o.uid SET o.a = 1"), all);
+  EXPECT_EQ(Tables("UPDATE users, orders SET orders.a = 1"), all);
+  EXPECT_EQ(Tables("DELETE FROM `users` WHERE id = ?"), Result{"users"});
+  EXPECT_EQ(Tables("DELETE u FROM users u JOIN orders o"), all);
+  EXPECT_EQ(Tables("TRUNCATE TABLE users"), Result{"users"});
+  EXPECT_EQ(Tables("DROP TABLE IF EXISTS users"), Result{"users"});
+  EXPECT_EQ(Tables("ALTER TABLE users ADD COLUMN b INT"), Result{"users"});
+  EXPECT_EQ(Tables("CALL refresh()"), all);
+  EXPECT_EQ(Tables("WITH x AS (SELECT 1) UPDATE users SET a = 1"), all);
+  EXPECT_TRUE(Tables("SELECT * FROM users FOR UPDATE").empty());
+  EXPECT_TRUE(Tables("commit").empty());
+  EXPECT_TRUE(Tables("SAVEPOINT `sp`").empty());
+}
+
+}  // namespace trpc::testing
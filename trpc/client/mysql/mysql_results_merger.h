@@ -0,0 +1,145 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#pragma once
+
+#include <cstddef>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "trpc/client/mysql/executor/mysql_results.h"
+
+namespace trpc::mysql {
+
+/// @brief Merges the MysqlResults of the same statement run on several shards, or splits the MysqlResults of a
+/// batched statement between its callers.
+/// @note NativeString results can not be merged, their rows point into the MYSQL_RES owned by each part.
+class MysqlResultsMerger {
+ public:
+  /// @brief Appends the rows of `parts` in order. Affected rows are summed, which is all there is to merge for
+  /// OnlyExec results.
+  /// @param limit Keeps at most `limit` rows, 0 means no limit.
+  template <typename... Args>
+  static MysqlResults<Args...> Concat(std::vector<MysqlResults<Args...>>& parts, size_t limit = 0);
+
+  /// @brief k-way merge of parts which are each sorted by `less`. The result is sorted by `less` as well.
+  /// @param less bool(const Row&, const Row&), Row is `typename MysqlResults<Args...>::ResultSetType::value_type`.
+  /// @param limit Stops after `limit` rows, 0 means no limit.
+  template <typename... Args, typename Less>
+  static MysqlResults<Args...> Merge(std::vector<MysqlResults<Args...>>& parts, Less&& less, size_t limit = 0);
+
+  /// @brief Moves each row of `whole` to the part `part_of(row)`, in order. Rows of a part `count` or above are
+  /// dropped. Each part gets the field names of `whole`.
+  /// @param part_of size_t(const Row&), Row is `typename MysqlResults<Args...>::ResultSetType::value_type`.
+  template <typename... Args, typename PartOf>
+  static std::vector<MysqlResults<Args...>> Split(MysqlResults<Args...>& whole, size_t count, PartOf&& part_of);
+
+ private:
+  template <typename... Args>
+  static MysqlResults<Args...> MergeMeta(std::vector<MysqlResults<Args...>>& parts);
+
+  /// @brief Moves row `index` of `part` and its null flags to `out`.
+  template <typename... Args>
+  static void MoveRow(MysqlResults<Args...>& part, size_t index, MysqlResults<Args...>& out);
+};
+
+template <typename... Args>
+MysqlResults<Args...> MysqlResultsMerger::MergeMeta(std::vector<MysqlResults<Args...>>& parts) {
+  static_assert(MysqlResults<Args...>::mode != MysqlResultsMode::NativeString,
+                "NativeString results can not be merged");
+
+  MysqlResults<Args...> out;
+  size_t total = 0;
+  for (auto& part : parts) {
+    total += part.result_set_.size();
+    out.affected_rows_ += part.affected_rows_;
+    out.has_value_ = out.has_value_ || part.has_value_;
+    if (out.fields_name_.empty()) out.fields_name_ = std::move(part.fields_name_);
+  }
+  if constexpr (MysqlResults<Args...>::mode == MysqlResultsMode::BindType) {
+    out.result_set_.reserve(total);
+    out.null_flags_.reserve(total);
+  }
+  return out;
+}
+
+template <typename... Args>
+void MysqlResultsMerger::MoveRow(MysqlResults<Args...>& part, size_t index, MysqlResults<Args...>& out) {
+  out.result_set_.emplace_back(std::move(part.result_set_[index]));
+  if (index < part.null_flags_.size()) {
+    out.null_flags_.emplace_back(std::move(part.null_flags_[index]));
+  } else {
+    out.null_flags_.emplace_back(sizeof...(Args), 0);
+  }
+}
+
+template <typename... Args>
+MysqlResults<Args...> MysqlResultsMerger::Concat(std::vector<MysqlResults<Args...>>& parts, size_t limit) {
+  MysqlResults<Args...> out = MergeMeta(parts);
+  if constexpr (MysqlResults<Args...>::mode == MysqlResultsMode::BindType) {
+    for (auto& part : parts) {
+      for (size_t i = 0; i < part.result_set_.size(); ++i) {
+        if (limit != 0 && out.result_set_.size() >= limit) return out;
+        MoveRow(part, i, out);
+      }
+    }
+  }
+  return out;
+}
+
+template <typename... Args, typename Less>
+MysqlResults<Args...> MysqlResultsMerger::Merge(std::vector<MysqlResults<Args...>>& parts, Less&& less,
+                                                size_t limit) {
+  static_assert(MysqlResults<Args...>::mode == MysqlResultsMode::BindType, "Only BindType results can be sorted");
+
+  MysqlResults<Args...> out = MergeMeta(parts);
+
+  // (part, row) cursors, the heap top is the cursor on the least row.
+  using Cursor = std::pair<size_t, size_t>;
+  auto greater = [&parts, &less](const Cursor& a, const Cursor& b) {
+    return less(parts[b.first].result_set_[b.second], parts[a.first].result_set_[a.second]);
+  };
+  std::priority_queue<Cursor, std::vector<Cursor>, decltype(greater)> heap(greater);
+  for (size_t i = 0; i < parts.size(); ++i) {
+    if (!parts[i].result_set_.empty()) heap.emplace(i, 0);
+  }
+
+  while (!heap.empty() && (limit == 0 || out.result_set_.size() < limit)) {
+    Cursor top = heap.top();
+    heap.pop();
+    MoveRow(parts[top.first], top.second, out);
+    if (top.second + 1 < parts[top.first].result_set_.size()) heap.emplace(top.first, top.second + 1);
+  }
+  return out;
+}
+
+template <typename... Args, typename PartOf>
+std::vector<MysqlResults<Args...>> MysqlResultsMerger::Split(MysqlResults<Args...>& whole, size_t count,
+                                                             PartOf&& part_of) {
+  static_assert(MysqlResults<Args...>::mode == MysqlResultsMode::BindType, "Only BindType results can be split");
+
+  std::vector<MysqlResults<Args...>> parts(count);
+  for (auto& part : parts) {
+    part.option_ = whole.option_;
+    part.fields_name_ = whole.fields_name_;
+    part.has_value_ = whole.has_value_;
+  }
+  for (size_t i = 0; i < whole.result_set_.size(); ++i) {
+    size_t part = part_of(whole.result_set_[i]);
+    if (part < count) MoveRow(whole, i, parts[part]);
+  }
+  return parts;
+}
+
+}  // namespace trpc::mysql
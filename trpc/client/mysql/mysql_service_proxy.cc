@@ -13,92 +13,530 @@
 
 #include "trpc/client/mysql/mysql_service_proxy.h"
 
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <thread>
+
 #include "trpc/client/service_proxy_option.h"
+#include "trpc/coroutine/fiber.h"
+#include "trpc/runtime/fiber_runtime.h"
 #include "trpc/util/bind_core_manager.h"
+#include "trpc/util/random.h"
 #include "trpc/util/string/string_util.h"
 
 #include "trpc/client/mysql/config/mysql_client_conf_parser.h"
 
 namespace trpc::mysql {
 
-bool MysqlServiceProxy::InitManager() {
-  if (pool_manager_ != nullptr) return false;
+namespace {
+
+// A KILL QUERY is short, more of them than this are rare (e.g. a deadline hit by many statements at once).
+constexpr uint32_t kKillThreadNum = 2;
+
+bool IsValidSavepointName(const std::string& name) {
+  if (name.empty() || name.size() > 64) return false;
+  return std::all_of(name.begin(), name.end(), [](unsigned char c) { return std::isalnum(c) || c == '_' || c == '$'; });
+}
+
+}  // namespace
+
+void MysqlServiceProxy::InitResultCache(Snapshot& snapshot) {
+  const MysqlClientConf& conf = snapshot.conf;
+  snapshot.result_cache = nullptr;
+  if (conf.result_cache_bytes == 0) return;
+
+  snapshot.result_cache = std::make_shared<MysqlResultCache>(conf.result_cache_bytes, conf.result_cache_shards);
+}
+
+bool MysqlServiceProxy::StartLocalCall(const ClientContextPtr& context) {
+  FillClientContext(context);
+  auto filter_status = filter_controller_.RunMessageClientFilters(FilterPoint::CLIENT_PRE_RPC_INVOKE, context);
+  if (filter_status == FilterStatus::REJECT) {
+    TRPC_FMT_ERROR("service name:{}, filter execute failed.", GetServiceName());
+    RunFilters(FilterPoint::CLIENT_POST_RPC_INVOKE, context);
+    return false;
+  }
+  return true;
+}
+
+void MysqlServiceProxy::FinishLocalCall(const ClientContextPtr& context) {
+  ProxyStatistics(context);
+  RunFilters(FilterPoint::CLIENT_POST_RPC_INVOKE, context);
+}
+
+Status MysqlServiceProxy::GetExceptionStatus(const Exception& ex) {
+  int code = ex.GetExceptionCode();
+  return Status(code != 0 ? code : static_cast<int>(TrpcRetCode::TRPC_INVOKE_UNKNOWN_ERR), ex.what());
+}
+
+Future<> MysqlServiceProxy::WaitForLeader(const ClientContextPtr& context,
+                                          const std::shared_ptr<MysqlSingleflight::Flight>& flight) {
+  uint32_t timeout = context->GetTimeout();
+  if (timeout == 0 || timeout == std::numeric_limits<uint32_t>::max() || timer_ == nullptr)
+    return singleflight_.Wait(flight);
+
+  // Settled by whichever of the leader and the timer comes first.
+  struct Race {
+    std::atomic<bool> settled{false};
+    Promise<> promise;
+  };
+  auto race = std::make_shared<Race>();
+  Future<> fu = race->promise.GetFuture();
+
+  // The continuations of an async follower run where the promise is settled, so not on the timer thread.
+  uint64_t timer_id = timer_->Add(timeout, [this, race]() {
+    if (race->settled.exchange(true)) return;
+    auto expire = [race]() {
+      race->promise.SetException(
+          CommonException("mysql singleflight: the leader did not finish within the timeout of the follower.",
+                          TrpcRetCode::TRPC_CLIENT_INVOKE_TIMEOUT_ERR));
+    };
+    if (!PostBlockingTask(expire)) expire();
+  });
+
+  singleflight_.Wait(flight).Then([this, race, timer_id](Future<>&&) {
+    if (!race->settled.exchange(true)) {
+      if (timer_id != 0) timer_->Cancel(timer_id);
+      race->promise.SetValue();
+    }
+    return MakeReadyFuture<>();
+  });
+  return fu;
+}
+
+void MysqlServiceProxy::InvalidateResultCache(const std::string& sql) {
+  auto cache = LoadSnapshot()->result_cache;
+  if (cache != nullptr) cache->Invalidate(MysqlResultCache::GetWrittenTables(sql));
+}
+
+void MysqlServiceProxy::RecordTransactionWrite(const TxHandlePtr& handle, const std::string& sql) {
+  if (LoadSnapshot()->result_cache != nullptr) handle->AddWrittenTables(MysqlResultCache::GetWrittenTables(sql));
+}
+
+void MysqlServiceProxy::InitSqlStats(Snapshot& snapshot) {
+  const MysqlClientConf& conf = snapshot.conf;
+  snapshot.sql_stats = nullptr;
+  if (!conf.sql_stats && conf.slow_query_threshold == 0) return;
+
+  snapshot.sql_stats = std::make_shared<MysqlSqlStats>(conf.sql_stats ? conf.max_sql_fingerprints : 0,
+                                                       conf.slow_query_threshold, conf.slow_query_log_per_second);
+}
+
+void MysqlServiceProxy::InitManager(Snapshot& snapshot) {
+  snapshot.pool_manager = std::make_shared<MysqlExecutorPoolManager>(MakePoolOption(snapshot));
+}
 
+MysqlExecutorPoolOption MysqlServiceProxy::MakePoolOption(const Snapshot& snapshot) {
   const ServiceProxyOption* option = GetServiceProxyOption();
+  const MysqlClientConf& conf = snapshot.conf;
   MysqlExecutorPoolOption pool_option;
   pool_option.max_size = option->max_conn_num;
   pool_option.max_idle_time = option->idle_time;
-  pool_option.num_shard_group = mysql_conf_.num_shard_group;
-  pool_option.username = mysql_conf_.user_name;
-  pool_option.dbname = mysql_conf_.dbname;
-  pool_option.password = mysql_conf_.password;
-  pool_option.char_set = mysql_conf_.char_set;
-  pool_manager_ = std::make_unique<MysqlExecutorPoolManager>(pool_option);
-  return true;
+  pool_option.num_shard_group = conf.num_shard_group;
+  pool_option.numa_aware = conf.numa_aware;
+  pool_option.username = conf.user_name;
+  pool_option.dbname = conf.dbname;
+  pool_option.password = conf.password;
+  pool_option.char_set = conf.char_set;
+  pool_option.multi_statements = conf.multi_statements;
+  pool_option.track_gtids = conf.read_your_writes;
+  pool_option.adaptive_concurrency = conf.adaptive_concurrency;
+  pool_option.min_concurrency = conf.min_concurrency;
+  pool_option.max_concurrency = conf.max_concurrency != 0 ? conf.max_concurrency : option->max_conn_num;
+  for (const auto& class_conf : conf.query_classes) pool_option.lane_max_conn.push_back(class_conf.max_conn);
+  pool_option.statement_observer = snapshot.sql_stats;
+  return pool_option;
 }
 
-bool MysqlServiceProxy::InitThreadPool() {
-  if (thread_pool_ != nullptr) return false;
+void MysqlServiceProxy::InitThreadPool(const MysqlClientConf& conf) {
+  bool fiber_mode = IsFiberMode(conf);
+  if (conf.execute_mode == "fiber" && !fiber_mode) {
+    TRPC_FMT_ERROR("service name:{}, execute_mode fiber needs a fiber_scheduling_group reserved for MySQL calls, "
+                   "use thread_pool.", GetServiceName());
+  } else if (!fiber_mode && conf.execute_mode != "thread_pool") {
+    TRPC_FMT_WARN("service name:{}, unknown execute_mode: {}, use thread_pool.", GetServiceName(), conf.execute_mode);
+  }
+
+  // Switched before the thread pool is removed, so that no task is rejected in between.
+  if (fiber_mode) fiber_mode_.store(true, std::memory_order_release);
+  auto old_thread_pool = std::atomic_exchange(&thread_pool_, fiber_mode ? nullptr : StartThreadPool(conf));
+  fiber_mode_.store(fiber_mode, std::memory_order_release);
+  if (old_thread_pool) old_thread_pool->Retire();
+}
 
-  ::trpc::ThreadPoolOption thread_pool_option;
-  thread_pool_option.thread_num = mysql_conf_.thread_num;
-  thread_pool_option.bind_core = !mysql_conf_.thread_bind_core.empty();
-  thread_pool_ = std::make_unique<::trpc::ThreadPool>(std::move(thread_pool_option));
-  BindCoreManager::ParseBindCoreGroup(mysql_conf_.thread_bind_core);
-  thread_pool_->Start();
+std::shared_ptr<MysqlWorkerPool> MysqlServiceProxy::StartThreadPool(const MysqlClientConf& conf) {
+  auto thread_pool = std::make_shared<MysqlWorkerPool>(conf.thread_num, !conf.thread_bind_core.empty());
+  BindCoreManager::ParseBindCoreGroup(conf.thread_bind_core);
+  thread_pool->Start();
   BindCoreManager::ParseBindCoreGroup("");  // Reset config.
+  return thread_pool;
+}
+
+void MysqlServiceProxy::ResizeThreadPool(const MysqlClientConf& conf) {
+  std::atomic_exchange(&thread_pool_, StartThreadPool(conf))->Retire();
+}
+
+void MysqlServiceProxy::InitQueryLanes(Snapshot& snapshot) {
+  snapshot.lanes.clear();
+  bool fiber_mode = fiber_mode_.load(std::memory_order_acquire);
+  for (const auto& class_conf : snapshot.conf.query_classes) {
+    auto lane = std::make_shared<MysqlQueryLane>(snapshot.lanes.size(), class_conf);
+    lane->Start(fiber_mode);
+    snapshot.lanes.emplace_back(std::move(lane));
+  }
+}
+
+void MysqlServiceProxy::StopQueryLanes() {
+  for (auto& lane : LoadSnapshot()->lanes) lane->Stop();
+}
+
+std::shared_ptr<MysqlQueryLane> MysqlServiceProxy::GetQueryLane(const Snapshot& snapshot,
+                                                                const ClientContextPtr& context) {
+  if (snapshot.lanes.empty()) return nullptr;
+
+  std::string name = GetMysqlQueryClass(context);
+  if (name.empty()) return nullptr;
+  for (const auto& lane : snapshot.lanes) {
+    if (lane->GetConf().name == name) return lane;
+  }
+  return nullptr;
+}
+
+bool MysqlServiceProxy::IsFiberMode(const MysqlClientConf& conf) {
+  // Blocking a fiber worker of the callers on network I/O would stall the unrelated fibers queued on it.
+  return conf.execute_mode == "fiber" && conf.fiber_scheduling_group >= 0;
+}
+
+int MysqlServiceProxy::GetSchedulingGroup(MysqlQueryLane* lane) const {
+  if (lane != nullptr && lane->GetConf().fiber_scheduling_group >= 0) return lane->GetConf().fiber_scheduling_group;
+  return LoadSnapshot()->conf.fiber_scheduling_group;
+}
+
+bool MysqlServiceProxy::CanRunInCaller(MysqlQueryLane* lane) const {
+  if (!fiber_mode_.load(std::memory_order_acquire) || !IsRunningInFiberWorker()) return false;
+  int group = GetSchedulingGroup(lane);
+  return group >= 0 && fiber::GetCurrentSchedulingGroupIndex() == static_cast<std::size_t>(group);
+}
+
+bool MysqlServiceProxy::RunBlockingTask(Function<void()>&& task, MysqlQueryLane* lane) {
+  if (CanRunInCaller(lane)) {
+    task();
+    return true;
+  }
+
+  // Running it in the caller instead would turn the overload of the workers into blocked callers.
+  FiberEvent e;
+  if (!PostBlockingTask(
+          [&task, &e]() {
+            task();
+            e.Set();
+          },
+          lane)) {
+    return false;
+  }
+  e.Wait();
   return true;
 }
 
+bool MysqlServiceProxy::PostBlockingTask(Function<void()>&& task, MysqlQueryLane* lane) {
+  if (!fiber_mode_.load(std::memory_order_acquire)) {
+    // The workers of a query class replaced by SetMysqlConfig are retired, its late tasks go to the default ones.
+    MysqlWorkerPool* lane_pool = lane != nullptr ? lane->GetThreadPool() : nullptr;
+    if (lane_pool != nullptr) {
+      MysqlWorkerPool::AddResult result = lane_pool->AddTask(task);
+      if (result != MysqlWorkerPool::AddResult::kRetired) return result == MysqlWorkerPool::AddResult::kAdded;
+    }
+    // A pool retired by a reload has been replaced already, the task goes to the new one.
+    while (std::shared_ptr<MysqlWorkerPool> thread_pool = std::atomic_load(&thread_pool_)) {
+      MysqlWorkerPool::AddResult result = thread_pool->AddTask(task);
+      if (result != MysqlWorkerPool::AddResult::kRetired) return result == MysqlWorkerPool::AddResult::kAdded;
+    }
+    // Switched to "fiber" by SetMysqlConfig meanwhile.
+    if (!fiber_mode_.load(std::memory_order_acquire)) return false;
+  }
+
+  int group = GetSchedulingGroup(lane);
+  if (group < 0 || static_cast<std::size_t>(group) >= fiber::GetSchedulingGroupCount()) {
+    TRPC_FMT_ERROR("service name:{}, fiber_scheduling_group {} out of range.", GetServiceName(), group);
+    return false;
+  }
+  Fiber::Attributes attr;
+  attr.scheduling_group = group;
+  attr.scheduling_group_local = true;
+  return StartFiberDetached(std::move(attr), std::move(task));
+}
+
+void MysqlServiceProxy::InitReplicaRouter(Snapshot& snapshot) {
+  snapshot.router = std::make_shared<MysqlReplicaRouter>(snapshot.conf.primary, snapshot.conf.replicas);
+}
+
+void MysqlServiceProxy::InitTimer() {
+  if (timer_ == nullptr) timer_ = std::make_unique<MysqlTimer>();
+  timer_->Start();
+  if (kill_pool_ == nullptr) {
+    kill_pool_ = std::make_unique<MysqlWorkerPool>(kKillThreadNum, false);
+    kill_pool_->Start();
+  }
+}
+
+void MysqlServiceProxy::InitHedging(Snapshot& snapshot) {
+  const MysqlClientConf& conf = snapshot.conf;
+  snapshot.hedge = nullptr;
+  if (conf.hedge_delay == 0 && conf.hedge_percentile == 0) return;
+
+  snapshot.hedge = std::make_shared<HedgePolicy>(conf.hedge_delay, conf.hedge_percentile, conf.hedge_budget);
+}
+
+uint64_t MysqlServiceProxy::GetCallDeadline(const MysqlClientConf& conf, const ClientContextPtr& context) {
+  if (!conf.deadline_propagation) return 0;
+
+  uint32_t timeout = context->GetTimeout();
+  if (timeout == 0 || timeout == std::numeric_limits<uint32_t>::max()) return 0;
+  return trpc::GetSteadyMilliSeconds() + timeout;
+}
+
+bool MysqlServiceProxy::AcquireConcurrency(MysqlQueryLane* lane, MysqlExecutorPool* pool,
+                                           const ClientContextPtr& context) {
+  if (lane != nullptr && !lane->TryEnter()) {
+    if (context != nullptr) {
+      context->SetStatus(Status(TrpcRetCode::TRPC_CLIENT_OVERLOAD_ERR,
+                                util::FormatString("service name:{}, the queue of query class {} is full.",
+                                                   GetServiceName(), lane->GetConf().name)));
+    }
+    return false;
+  }
+  if (pool == nullptr) return true;
+
+  if (lane != nullptr && !pool->TryAcquireLaneConn(lane->GetIndex())) {
+    lane->Leave();
+    if (context != nullptr) {
+      const NodeAddr& node_addr = pool->GetNodeAddr();
+      context->SetStatus(Status(TrpcRetCode::TRPC_CLIENT_LIMITED_ERR,
+                                util::FormatString("service name:{}, query class {} uses all its connections to {}:{}.",
+                                                   GetServiceName(), lane->GetConf().name, node_addr.ip,
+                                                   node_addr.port)));
+    }
+    return false;
+  }
+
+  MysqlConcurrencyLimiter* limiter = pool->GetLimiter();
+  if (limiter == nullptr || limiter->TryAcquire()) return true;
+
+  if (lane != nullptr) {
+    pool->ReleaseLaneConn(lane->GetIndex());
+    lane->Leave();
+  }
+  if (context != nullptr) {
+    const NodeAddr& node_addr = pool->GetNodeAddr();
+    context->SetStatus(Status(TrpcRetCode::TRPC_CLIENT_LIMITED_ERR,
+                              util::FormatString("service name:{}, {}:{} is at its concurrency limit {}.",
+                                                 GetServiceName(), node_addr.ip, node_addr.port, limiter->GetLimit())));
+  }
+  return false;
+}
+
+void MysqlServiceProxy::ReleaseConcurrency(MysqlQueryLane* lane, MysqlExecutorPool* pool, uint64_t begin_us,
+                                           bool dropped) {
+  if (lane != nullptr) lane->Leave();
+  if (pool == nullptr) return;
+
+  if (lane != nullptr) pool->ReleaseLaneConn(lane->GetIndex());
+  MysqlConcurrencyLimiter* limiter = pool->GetLimiter();
+  if (limiter == nullptr) return;
+
+  uint64_t latency_us = begin_us != 0 ? std::max<uint64_t>(trpc::GetSteadyMicroSeconds() - begin_us, 1) : 0;
+  limiter->Release(latency_us, dropped);
+}
+
+Status MysqlServiceProxy::DeadlineExceededStatus() {
+  return Status(TrpcRetCode::TRPC_CLIENT_INVOKE_TIMEOUT_ERR, "mysql statement exceeded the deadline of the call");
+}
+
+HedgeStats MysqlServiceProxy::GetHedgeStats() const {
+  auto hedge = LoadSnapshot()->hedge;
+  return hedge != nullptr ? hedge->GetStats() : HedgeStats();
+}
+
+bool MysqlServiceProxy::SelectHedgeTarget(const NodeAddr& first, NodeAddr& node_addr) {
+  ClientContextPtr temp_ctx = MakeRefCounted<ClientContext>(this->GetClientCodec());
+  FillClientContext(temp_ctx);
+  if (!SelectTarget(temp_ctx)) return false;
+
+  node_addr = temp_ctx->GetNodeAddr();
+  return node_addr.ip != first.ip || node_addr.port != first.port;
+}
+
+void MysqlServiceProxy::KillQuery(const NodeAddr& node_addr, unsigned long thread_id) {
+  if (thread_id == 0) return;
+
+  std::shared_ptr<MysqlExecutorPool> pool = LoadSnapshot()->pool_manager->GetShared(node_addr);
+  ExecutorPtr conn = pool->GetExecutor();
+  if (!conn->IsConnected()) {
+    TRPC_FMT_WARN("service name:{}, kill query {} on {}:{} failed: {}.", GetServiceName(), thread_id, node_addr.ip,
+                  node_addr.port, conn->GetErrorMessage());
+    return;
+  }
+
+  MysqlResults<OnlyExec> res;
+  conn->Execute(res, "KILL QUERY " + std::to_string(thread_id));
+  // The statement may have finished meanwhile, which is harmless.
+  if (!res.OK())
+    TRPC_FMT_DEBUG("service name:{}, kill query {} on {}:{}: {}.", GetServiceName(), thread_id, node_addr.ip,
+                   node_addr.port, res.GetErrorMessage());
+  pool->Reclaim(0, std::move(conn));
+}
+
+void MysqlServiceProxy::PostKillQuery(const std::shared_ptr<KillGuard>& guard, const NodeAddr& node_addr,
+                                      unsigned long thread_id) {
+  {
+    std::scoped_lock _(guard->mutex);
+    if (guard->finished) return;
+  }
+
+  Function<void()> task = [this, guard, node_addr, thread_id]() {
+    {
+      std::scoped_lock _(guard->mutex);
+      // Finished while the task was queued, the connection may already run another statement.
+      if (guard->finished) return;
+      guard->killing = true;
+    }
+    KillQuery(node_addr, thread_id);
+    guard->killed.CountDown();
+  };
+  bool posted = kill_pool_ != nullptr && kill_pool_->AddTask(task) == MysqlWorkerPool::AddResult::kAdded;
+  if (!posted)
+    TRPC_FMT_WARN("service name:{}, failed to post the kill of query {} on {}:{}.", GetServiceName(), thread_id,
+                  node_addr.ip, node_addr.port);
+}
+
+bool MysqlServiceProxy::FinishKillable(KillGuard& guard) {
+  {
+    std::scoped_lock _(guard.mutex);
+    guard.finished = true;
+    if (!guard.killing) return false;
+  }
+  guard.killed.Wait();
+  return true;
+}
+
+int MysqlServiceProxy::RouteCall(const std::shared_ptr<MysqlReplicaRouter>& router, const ClientContextPtr& context,
+                                 bool read) {
+  if (read && router->HasReplicas()) {
+    NodeAddr node_addr;
+    size_t replica = router->AcquireReplica(node_addr);
+    context->SetAddr(node_addr.ip, node_addr.port);
+    return static_cast<int>(replica);
+  }
+
+  if (router->HasPrimary()) context->SetAddr(router->GetPrimary().ip, router->GetPrimary().port);
+  return -1;
+}
+
+void MysqlServiceProxy::SaveSessionGtid(const ClientContextPtr& context, const ExecutorPtr& conn) {
+  std::string gtid = conn->TakeSessionGtid();
+  if (!gtid.empty()) SetMysqlGtid(context, std::move(gtid));
+}
+
+bool MysqlServiceProxy::WaitForGtid(const ExecutorPtr& conn, const std::string& gtid,
+                                    uint32_t gtid_wait_timeout_ms) {
+  // WAIT_FOR_EXECUTED_GTID_SET returns 0 once the GTID set is applied and 1 on timeout.
+  MysqlResults<int64_t> res;
+  double timeout_seconds = gtid_wait_timeout_ms / 1000.0;
+  conn->QueryAll(res, "SELECT WAIT_FOR_EXECUTED_GTID_SET(?, ?)", gtid, timeout_seconds);
+  if (!res.OK()) {
+    TRPC_FMT_WARN("service name:{}, wait for gtid on {}:{} failed: {}.", GetServiceName(), conn->GetIp(),
+                  conn->GetPort(), res.GetErrorMessage());
+    return false;
+  }
+  return !res.ResultSet().empty() && std::get<0>(res.ResultSet()[0]) == 0;
+}
+
+void MysqlServiceProxy::InitTransactionWatchdog(Snapshot& snapshot) {
+  const MysqlClientConf& conf = snapshot.conf;
+  snapshot.tx_watchdog = nullptr;
+  if (conf.tx_idle_timeout == 0 && conf.tx_max_duration == 0) return;
+
+  snapshot.tx_watchdog = std::make_shared<TransactionWatchdog>(conf.tx_idle_timeout, conf.tx_max_duration);
+  snapshot.tx_watchdog->Start();
+}
+
+void MysqlServiceProxy::StopTransactionWatchdog() {
+  // Handles keep the watchdog alive, only the sweep is stopped here.
+  auto watchdog = LoadSnapshot()->tx_watchdog;
+  if (watchdog) watchdog->Stop();
+}
+
+void MysqlServiceProxy::InitSnapshot(std::shared_ptr<Snapshot> snapshot) {
+  InitSqlStats(*snapshot);
+  InitResultCache(*snapshot);
+  InitManager(*snapshot);
+  InitQueryLanes(*snapshot);
+  InitReplicaRouter(*snapshot);
+  InitHedging(*snapshot);
+  InitTransactionWatchdog(*snapshot);
+  PublishSnapshot(std::move(snapshot));
+}
+
 void MysqlServiceProxy::SetServiceProxyOptionInner(const std::shared_ptr<ServiceProxyOption>& option) {
   ServiceProxy::SetServiceProxyOptionInner(option);
-  SetConfigFromFile();
-  mysql_conf_.Display();
-  InitThreadPool();
-  InitManager();
+  auto snapshot = std::make_shared<Snapshot>();
+  snapshot->conf = GetConfigFromFile();
+  snapshot->conf.Display();
+  InitThreadPool(snapshot->conf);
+  InitTimer();
+  InitSnapshot(std::move(snapshot));
 }
 
 void MysqlServiceProxy::Destroy() {
   ServiceProxy::Destroy();
-  thread_pool_->Join();
-  pool_manager_->Destroy();
+  if (auto thread_pool = std::atomic_load(&thread_pool_)) thread_pool->Join();
+  if (kill_pool_) kill_pool_->Join();
+  SnapshotPtr snapshot = LoadSnapshot();
+  for (auto& lane : snapshot->lanes) lane->Join();
+  snapshot->pool_manager->Destroy();
 }
 
 void MysqlServiceProxy::Stop() {
   ServiceProxy::Stop();
-  thread_pool_->Stop();
-  pool_manager_->Stop();
+  StopTransactionWatchdog();
+  if (timer_) timer_->Stop();
+  if (auto thread_pool = std::atomic_load(&thread_pool_)) thread_pool->Stop();
+  if (kill_pool_) kill_pool_->Stop();
+  StopQueryLanes();
+  LoadSnapshot()->pool_manager->Stop();
 }
 
-Status MysqlServiceProxy::Begin(const ClientContextPtr& context, TxHandlePtr& handle) {
-  FillClientContext(context);
-  auto filter_status = filter_controller_.RunMessageClientFilters(FilterPoint::CLIENT_PRE_RPC_INVOKE, context);
-  if (filter_status == FilterStatus::REJECT) {
-    TRPC_FMT_ERROR("service name:{}, filter execute failed.", GetServiceName());
-    RunFilters(FilterPoint::CLIENT_POST_RPC_INVOKE, context);
-    return context->GetStatus();
+bool MysqlServiceProxy::SelectTransactionTarget(const ClientContextPtr& context, NodeAddr& node_addr) {
+  // Transactions always run on the primary with read/write splitting.
+  auto router = LoadSnapshot()->router;
+  if (router->HasPrimary()) {
+    node_addr = router->GetPrimary();
+    context->SetAddr(node_addr.ip, node_addr.port);
+    return true;
   }
 
-  MysqlResults<OnlyExec> res;
-  NodeAddr node_addr;
-
   // Bypass the selector to use or test the service_proxy independently
   // (since the selector might not be registered)
-  if (context->GetIp().empty()) {
-    ClientContextPtr temp_ctx = MakeRefCounted<ClientContext>(this->GetClientCodec());
-    FillClientContext(temp_ctx);
-
-    if (!SelectTarget(temp_ctx)) {
-      TRPC_LOG_ERROR("select target failed: " << temp_ctx->GetStatus().ToString());
-      context->SetStatus(temp_ctx->GetStatus());
-      return context->GetStatus();
-    }
-    node_addr = temp_ctx->GetNodeAddr();
-  } else {
+  if (!context->GetIp().empty()) {
     node_addr = context->GetNodeAddr();
+    return true;
   }
 
-  MysqlExecutorPool* pool = this->pool_manager_->Get(node_addr);
+  ClientContextPtr temp_ctx = MakeRefCounted<ClientContext>(this->GetClientCodec());
+  FillClientContext(temp_ctx);
+
+  if (!SelectTarget(temp_ctx)) {
+    TRPC_LOG_ERROR("select target failed: " << temp_ctx->GetStatus().ToString());
+    context->SetStatus(temp_ctx->GetStatus());
+    return false;
+  }
+  node_addr = temp_ctx->GetNodeAddr();
+  return true;
+}
+
+MysqlServiceProxy::ExecutorPtr MysqlServiceProxy::StartTransaction(const ClientContextPtr& context,
+                                                                   MysqlExecutorPool* pool) {
   auto executor = pool->GetExecutor();
 
   Status status;
@@ -109,20 +547,72 @@ Status MysqlServiceProxy::Begin(const ClientContextPtr& context, TxHandlePtr& ha
     status.SetFrameworkRetCode(executor->GetErrorNumber());
     status.SetErrorMessage(error_message);
     context->SetStatus(std::move(status));
-  } else {
-    status = UnaryInvoke(context, executor, res, "begin");
+    return nullptr;
   }
 
-  if (context->GetStatus().OK()) {
-    handle = MakeRefCounted<TransactionHandle>();
-    handle->SetExecutor(std::move(executor));
-    handle->SetState(TransactionHandle::TxState::kStarted);
+  if (LoadSnapshot()->conf.deferred_begin) {
+    executor->SetBeginPending(true);
+    return executor;
   }
 
+  MysqlResults<OnlyExec> res;
+  executor->Execute(res, "begin");
+  if (!res.OK()) {
+    status.SetFrameworkRetCode(res.GetErrorNumber());
+    status.SetErrorMessage(res.GetErrorMessage());
+    context->SetStatus(std::move(status));
+    pool->Reclaim(0, std::move(executor));
+    return nullptr;
+  }
+
+  return executor;
+}
+
+Status MysqlServiceProxy::Begin(const ClientContextPtr& context, TxHandlePtr& handle) {
+  FillClientContext(context);
+  auto filter_status = filter_controller_.RunMessageClientFilters(FilterPoint::CLIENT_PRE_RPC_INVOKE, context);
+  if (filter_status == FilterStatus::REJECT) {
+    TRPC_FMT_ERROR("service name:{}, filter execute failed.", GetServiceName());
+    RunFilters(FilterPoint::CLIENT_POST_RPC_INVOKE, context);
+    return context->GetStatus();
+  }
+
+  NodeAddr node_addr;
+  if (!SelectTransactionTarget(context, node_addr)) return context->GetStatus();
+
+  SnapshotPtr snapshot = LoadSnapshot();
+  std::shared_ptr<MysqlQueryLane> lane = GetQueryLane(*snapshot, context);
+  std::shared_ptr<MysqlExecutorPool> pool = snapshot->pool_manager->GetShared(node_addr);
+  ExecutorPtr executor{nullptr};
+
+  if (!CheckTimeout(context)) {
+    if (RunFilters(FilterPoint::CLIENT_PRE_SEND_MSG, context) == 0) {
+      // Connecting on a pool miss happens in the blocking task, the calling fiber is suspended meanwhile.
+      if (!RunBlockingTask([this, &context, &pool, &executor]() { executor = StartTransaction(context, pool.get()); },
+                           lane.get())) {
+        context->SetStatus(Status(TrpcRetCode::TRPC_CLIENT_OVERLOAD_ERR, "Failed to post the mysql task."));
+      }
+    }
+    ProxyStatistics(context);
+    RunFilters(FilterPoint::CLIENT_POST_RECV_MSG, context);
+  }
+
+  if (executor != nullptr) handle = MakeTransactionHandle(std::move(executor), std::move(pool));
+
   RunFilters(FilterPoint::CLIENT_POST_RPC_INVOKE, context);
   return context->GetStatus();
 }
 
+TxHandlePtr MysqlServiceProxy::MakeTransactionHandle(ExecutorPtr&& executor, std::shared_ptr<MysqlExecutorPool> pool) {
+  TxHandlePtr handle = MakeRefCounted<TransactionHandle>();
+  handle->SetExecutor(std::move(executor));
+  handle->SetPool(std::move(pool));
+  handle->SetReclaimPoster([this](Function<void()>&& task) { return PostBlockingTask(std::move(task)); });
+  handle->SetState(TransactionHandle::TxState::kStarted);
+  handle->SetWatchdog(LoadSnapshot()->tx_watchdog);
+  return handle;
+}
+
 Future<TxHandlePtr> MysqlServiceProxy::AsyncBegin(const ClientContextPtr& context) {
   FillClientContext(context);
 
@@ -136,75 +626,89 @@ Future<TxHandlePtr> MysqlServiceProxy::AsyncBegin(const ClientContextPtr& contex
     return exception_fut;
   }
 
-  MysqlResults<OnlyExec> res;
   NodeAddr node_addr;
+  if (!SelectTransactionTarget(context, node_addr))
+    return MakeExceptionFuture<TxHandlePtr>(trpc::CommonException(context->GetStatus().ToString().c_str()));
 
-  // Bypass the selector to use or test the service_proxy independently
-  // (since the selector might not be registered)
-  if (context->GetIp().empty()) {
-    ClientContextPtr temp_ctx = MakeRefCounted<ClientContext>(this->GetClientCodec());
-    FillClientContext(temp_ctx);
-
-    if (!SelectTarget(temp_ctx)) {
-      TRPC_LOG_ERROR("select target failed: " << temp_ctx->GetStatus().ToString());
-      context->SetStatus(temp_ctx->GetStatus());
-      return MakeExceptionFuture<TxHandlePtr>(trpc::CommonException(temp_ctx->GetStatus().ToString().c_str()));
-    }
-    node_addr = temp_ctx->GetNodeAddr();
+  if (CheckTimeout(context)) {
+    const Status& result = context->GetStatus();
+    return MakeExceptionFuture<TxHandlePtr>(
+        CommonException(result.ErrorMessage().c_str(), result.GetFrameworkRetCode()));
+  }
 
-  } else {
-    node_addr = context->GetNodeAddr();
+  if (RunFilters(FilterPoint::CLIENT_PRE_SEND_MSG, context) != 0) {
+    RunFilters(FilterPoint::CLIENT_POST_RECV_MSG, context);
+    RunFilters(FilterPoint::CLIENT_POST_RPC_INVOKE, context);
+    return MakeExceptionFuture<TxHandlePtr>(CommonException(context->GetStatus().ErrorMessage().c_str()));
   }
 
-  MysqlExecutorPool* pool = this->pool_manager_->Get(node_addr);
-  auto executor = pool->GetExecutor();
-  if (!executor->IsConnected()) {
-    std::string error_message =
-        util::FormatString("service name:{}, connection failed. {}.", GetServiceName(), executor->GetErrorMessage());
-    TRPC_LOG_ERROR(error_message);
-    Status status;
-    status.SetFrameworkRetCode(executor->GetErrorNumber());
-    status.SetErrorMessage(error_message);
+  SnapshotPtr snapshot = LoadSnapshot();
+  std::shared_ptr<MysqlQueryLane> lane = GetQueryLane(*snapshot, context);
+  std::shared_ptr<MysqlExecutorPool> pool = snapshot->pool_manager->GetShared(node_addr);
+  Promise<TxHandlePtr> pr;
+  auto fu = pr.GetFuture();
+
+  // Both the connection acquisition and "begin" run in the blocking task, so the caller never waits on network I/O.
+  bool posted = PostBlockingTask([p = std::move(pr), this, context, pool, lane]() mutable {
+    ExecutorPtr executor = StartTransaction(context, pool.get());
+    ProxyStatistics(context);
+
+    if (executor == nullptr) {
+      p.SetException(CommonException(context->GetStatus().ErrorMessage().c_str()));
+      return;
+    }
+
+    p.SetValue(MakeTransactionHandle(std::move(executor), std::move(pool)));
+  }, lane.get());
+
+  if (TRPC_UNLIKELY(!posted)) {
+    Status status(TrpcRetCode::TRPC_CLIENT_OVERLOAD_ERR, "Failed to post the mysql task.");
     context->SetStatus(status);
-    return MakeExceptionFuture<TxHandlePtr>(CommonException(error_message.c_str()));
+    RunFilters(FilterPoint::CLIENT_POST_RECV_MSG, context);
+    RunFilters(FilterPoint::CLIENT_POST_RPC_INVOKE, context);
+    return MakeExceptionFuture<TxHandlePtr>(CommonException(status.ErrorMessage().c_str()));
   }
 
-  return AsyncUnaryInvoke<OnlyExec>(context, executor, "begin")
-      .Then([executor](Future<MysqlResults<OnlyExec>>&& f) mutable {
-        TxHandlePtr handle_ptr = MakeRefCounted<TransactionHandle>();
-        if (f.IsFailed()) {
-          return MakeExceptionFuture<TxHandlePtr>(f.GetException());
-        }
-        handle_ptr->SetState(TransactionHandle::TxState::kStarted);
-        handle_ptr->SetExecutor(std::move(executor));
-        return MakeReadyFuture(std::move(handle_ptr));
-      });
+  return fu.Then([this, context](Future<TxHandlePtr>&& f) {
+    RunFilters(FilterPoint::CLIENT_POST_RECV_MSG, context);
+    RunFilters(FilterPoint::CLIENT_POST_RPC_INVOKE, context);
+    if (f.IsFailed()) return MakeExceptionFuture<TxHandlePtr>(f.GetException());
+    return MakeReadyFuture<TxHandlePtr>(f.GetValue0());
+  });
 }
 
 Status MysqlServiceProxy::Commit(const ClientContextPtr& context, const TxHandlePtr& handle) {
+  if (EndPendingTransaction(handle, false)) return context->GetStatus();
+
   MysqlResults<OnlyExec> res;
   Status s = Execute(context, handle, res, "commit");
 
   if (!res.OK()) {
-    Status status = kUnknownErrorStatus;
+    // The MySQL error number, so that RunInTransaction retries a deadlock or lock wait timeout raised at the end.
+    Status status;
+    status.SetFrameworkRetCode(res.GetErrorNumber());
     status.SetErrorMessage(res.GetErrorMessage());
-    context->SetStatus(status);
-  } else {
+    context->SetStatus(std::move(status));
+  } else if (s.OK()) {
     EndTransaction(handle, false);
   }
+  // Otherwise "commit" was not sent (e.g. timeout or overload), the transaction is still open.
 
   return context->GetStatus();
 }
 
 Status MysqlServiceProxy::Rollback(const ClientContextPtr& context, const TxHandlePtr& handle) {
+  if (EndPendingTransaction(handle, true)) return context->GetStatus();
+
   MysqlResults<OnlyExec> res;
   Status s = Execute(context, handle, res, "rollback");
 
   if (!res.OK()) {
-    Status status = kUnknownErrorStatus;
+    Status status;
+    status.SetFrameworkRetCode(res.GetErrorNumber());
     status.SetErrorMessage(res.GetErrorMessage());
-    context->SetStatus(status);
-  } else {
+    context->SetStatus(std::move(status));
+  } else if (s.OK()) {
     EndTransaction(handle, true);
   }
 
@@ -212,7 +716,9 @@ Status MysqlServiceProxy::Rollback(const ClientContextPtr& context, const TxHand
 }
 
 Future<> MysqlServiceProxy::AsyncCommit(const ClientContextPtr& context, const TxHandlePtr& handle) {
-  MysqlResults<OnlyExec> res;
+  if (EndPendingTransaction(handle, false)) return MakeReadyFuture<>();
+
+  // The future fails unless "commit" ran and succeeded, the transaction is still open then.
   return AsyncQuery<OnlyExec>(context, handle, "commit")
       .Then([this, context, handle](Future<MysqlResults<OnlyExec>>&& f) {
         if (f.IsFailed()) {
@@ -224,55 +730,318 @@ Future<> MysqlServiceProxy::AsyncCommit(const ClientContextPtr& context, const T
 }
 
 Future<> MysqlServiceProxy::AsyncRollback(const ClientContextPtr& context, const TxHandlePtr& handle) {
-  MysqlResults<OnlyExec> res;
+  if (EndPendingTransaction(handle, true)) return MakeReadyFuture<>();
+
   return AsyncQuery<OnlyExec>(context, handle, "rollback")
       .Then([this, context, handle](Future<MysqlResults<OnlyExec>>&& f) {
         if (f.IsFailed()) {
-          auto t = f.GetValue();
           return MakeExceptionFuture<>(f.GetException());
         }
-        auto t = f.GetValue();
         EndTransaction(handle, true);
         return MakeReadyFuture<>();
       });
 }
 
+Status MysqlServiceProxy::RunTransactionScript(const ClientContextPtr& context,
+                                               const std::vector<std::string>& statements,
+                                               MysqlResults<OnlyExec>& res) {
+  FillClientContext(context);
+
+  auto filter_status = filter_controller_.RunMessageClientFilters(FilterPoint::CLIENT_PRE_RPC_INVOKE, context);
+  if (filter_status == FilterStatus::REJECT) {
+    TRPC_FMT_ERROR("service name:{}, filter execute failed.", GetServiceName());
+  } else {
+    RouteCall(LoadSnapshot()->router, context, false);
+    InvokeWith(context, nullptr, res, [&statements](const ExecutorPtr& conn, MysqlResults<OnlyExec>& conn_res) {
+      conn->ExecuteTransaction(conn_res, statements);
+    });
+    for (const auto& statement : statements) InvalidateResultCache(statement);
+  }
+
+  RunFilters(FilterPoint::CLIENT_POST_RPC_INVOKE, context);
+  return context->GetStatus();
+}
+
+Future<MysqlResults<OnlyExec>> MysqlServiceProxy::AsyncRunTransactionScript(const ClientContextPtr& context,
+                                                                            std::vector<std::string> statements) {
+  FillClientContext(context);
+
+  auto filter_status = filter_controller_.RunMessageClientFilters(FilterPoint::CLIENT_PRE_RPC_INVOKE, context);
+  if (filter_status == FilterStatus::REJECT) {
+    TRPC_FMT_ERROR("service name:{}, filter execute failed.", GetServiceName());
+    context->SetRequestData(nullptr);
+    const Status& result = context->GetStatus();
+    auto exception_fut = MakeExceptionFuture<MysqlResults<OnlyExec>>(CommonException(result.ErrorMessage().c_str()));
+    filter_controller_.RunMessageClientFilters(FilterPoint::CLIENT_POST_RPC_INVOKE, context);
+    return exception_fut;
+  }
+
+  RouteCall(LoadSnapshot()->router, context, false);
+  auto shared_statements = std::make_shared<std::vector<std::string>>(std::move(statements));
+  return AsyncInvokeWith<MysqlResults<OnlyExec>>(
+             context, nullptr,
+             [shared_statements](const ExecutorPtr& conn, MysqlResults<OnlyExec>& conn_res) {
+               conn->ExecuteTransaction(conn_res, *shared_statements);
+             })
+      .Then([this, context, shared_statements](Future<MysqlResults<OnlyExec>>&& f) {
+        for (const auto& statement : *shared_statements) InvalidateResultCache(statement);
+        RunFilters(FilterPoint::CLIENT_POST_RPC_INVOKE, context);
+        if (f.IsFailed()) return MakeExceptionFuture<MysqlResults<OnlyExec>>(f.GetException());
+        return MakeReadyFuture<MysqlResults<OnlyExec>>(f.GetValue0());
+      });
+}
+
+Status MysqlServiceProxy::Savepoint(const ClientContextPtr& context, const TxHandlePtr& handle,
+                                    const std::string& name) {
+  if (!IsValidSavepointName(name)) {
+    context->SetStatus(Status(TrpcMysqlRetCode::TRPC_MYSQL_INVALID_SAVEPOINT, "Invalid savepoint name: " + name));
+    return context->GetStatus();
+  }
+
+  MysqlResults<OnlyExec> res;
+  Status s = Execute(context, handle, res, "SAVEPOINT `" + name + "`");
+  if (s.OK()) handle->AddSavepoint(name);
+  return s;
+}
+
+Status MysqlServiceProxy::RollbackTo(const ClientContextPtr& context, const TxHandlePtr& handle,
+                                     const std::string& name) {
+  if (!handle->HasSavepoint(name)) {
+    context->SetStatus(Status(TrpcMysqlRetCode::TRPC_MYSQL_INVALID_SAVEPOINT, "No such savepoint: " + name));
+    return context->GetStatus();
+  }
+
+  MysqlResults<OnlyExec> res;
+  Status s = Execute(context, handle, res, "ROLLBACK TO SAVEPOINT `" + name + "`");
+  if (s.OK()) handle->RemoveSavepointsAfter(name, false);
+  return s;
+}
+
+Status MysqlServiceProxy::Release(const ClientContextPtr& context, const TxHandlePtr& handle,
+                                  const std::string& name) {
+  if (!handle->HasSavepoint(name)) {
+    context->SetStatus(Status(TrpcMysqlRetCode::TRPC_MYSQL_INVALID_SAVEPOINT, "No such savepoint: " + name));
+    return context->GetStatus();
+  }
+
+  MysqlResults<OnlyExec> res;
+  Status s = Execute(context, handle, res, "RELEASE SAVEPOINT `" + name + "`");
+  if (s.OK()) handle->RemoveSavepointsAfter(name, true);
+  return s;
+}
+
+TransactionWatchdogStats MysqlServiceProxy::GetTransactionWatchdogStats() const {
+  auto watchdog = LoadSnapshot()->tx_watchdog;
+  if (watchdog == nullptr) return TransactionWatchdogStats{};
+  return watchdog->GetStats();
+}
+
+TransactionRetryStats MysqlServiceProxy::GetTransactionRetryStats() const {
+  TransactionRetryStats stats;
+  stats.transactions = tx_retry_counters_.transactions.load(std::memory_order_relaxed);
+  stats.retries = tx_retry_counters_.retries.load(std::memory_order_relaxed);
+  stats.deadlock_retries = tx_retry_counters_.deadlock_retries.load(std::memory_order_relaxed);
+  stats.lock_wait_retries = tx_retry_counters_.lock_wait_retries.load(std::memory_order_relaxed);
+  stats.exhausted = tx_retry_counters_.exhausted.load(std::memory_order_relaxed);
+  return stats;
+}
+
+Status MysqlServiceProxy::RestartTransaction(const ClientContextPtr& context, const TxHandlePtr& handle) {
+  if (!handle->TryAcquire()) {
+    context->SetStatus(Status(TrpcMysqlRetCode::TRPC_MYSQL_INVALID_HANDLE, "Transaction handle is in use."));
+    return context->GetStatus();
+  }
+  if (handle->GetState() != TransactionHandle::TxState::kStarted) {
+    handle->ReleaseUse();
+    context->SetStatus(Status(TrpcMysqlRetCode::TRPC_MYSQL_INVALID_HANDLE, "Invalid handle."));
+    return context->GetStatus();
+  }
+
+  handle->ClearSavepoints();
+  MysqlResults<OnlyExec> res;
+  bool deferred_begin = LoadSnapshot()->conf.deferred_begin;
+  Status status = InvokeWith(context, handle->GetExecutor(), res,
+                             [deferred_begin](const ExecutorPtr& conn, MysqlResults<OnlyExec>& conn_res) {
+                               // Nothing has been sent to the server in a deferred transaction yet.
+                               if (conn->IsBeginPending()) return;
+
+                               conn->Execute(conn_res, "rollback");
+                               if (!conn_res.OK()) return;
+
+                               if (deferred_begin)
+                                 conn->SetBeginPending(true);
+                               else
+                                 conn->Execute(conn_res, "begin");
+                             });
+  handle->ReleaseUse();
+  return status;
+}
+
+bool MysqlServiceProxy::WaitForTransactionRetry(const ClientContextPtr& context, const TransactionRetryPolicy& policy,
+                                                uint32_t attempt, int error_code, uint64_t begin_ms) {
+  const auto& retryable = policy.retryable_errors;
+  if (std::find(retryable.begin(), retryable.end(), error_code) == retryable.end()) return false;
+
+  uint64_t backoff_ms = policy.max_backoff_ms;
+  if (attempt < 32) backoff_ms = std::min(backoff_ms, static_cast<uint64_t>(policy.base_backoff_ms) << attempt);
+  backoff_ms = trpc::Random<uint64_t>(backoff_ms / 2, backoff_ms);
+
+  uint32_t timeout = context->GetTimeout();
+  bool has_timeout = timeout != 0 && timeout != std::numeric_limits<uint32_t>::max();
+  if (attempt >= policy.max_retries ||
+      (has_timeout && trpc::GetSteadyMilliSeconds() + backoff_ms >= begin_ms + timeout)) {
+    tx_retry_counters_.exhausted.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  tx_retry_counters_.retries.fetch_add(1, std::memory_order_relaxed);
+  if (error_code == ER_LOCK_DEADLOCK)
+    tx_retry_counters_.deadlock_retries.fetch_add(1, std::memory_order_relaxed);
+  else if (error_code == ER_LOCK_WAIT_TIMEOUT)
+    tx_retry_counters_.lock_wait_retries.fetch_add(1, std::memory_order_relaxed);
+
+  TRPC_FMT_DEBUG("service name:{}, transaction failed with {}, retry {} after {} ms.", GetServiceName(), error_code,
+                 attempt + 1, backoff_ms);
+
+  if (IsRunningInFiberWorker())
+    FiberSleepFor(std::chrono::milliseconds(backoff_ms));
+  else
+    std::this_thread::sleep_for(std::chrono::milliseconds(backoff_ms));
+  return true;
+}
+
+bool MysqlServiceProxy::EndPendingTransaction(const TxHandlePtr& handle, bool rollback) {
+  if (handle->GetState() != TransactionHandle::TxState::kStarted) return false;
+  if (!handle->TryAcquire()) return false;
+
+  auto executor = handle->GetExecutor();
+  bool pending = handle->GetState() == TransactionHandle::TxState::kStarted && executor != nullptr &&
+                 executor->IsBeginPending();
+  if (pending) executor->SetBeginPending(false);
+  handle->ReleaseUse();
+
+  // Nothing was sent to the server, so the transaction is ended even if the watchdog has taken the handle meanwhile.
+  if (pending) EndTransaction(handle, rollback);
+  return pending;
+}
+
 bool MysqlServiceProxy::EndTransaction(const TxHandlePtr& handle, bool rollback) {
+  if (!handle->TryAcquire()) return false;
+  if (handle->GetState() != TransactionHandle::TxState::kStarted) {
+    // Expired and reclaimed by the transaction watchdog.
+    handle->ReleaseUse();
+    return false;
+  }
+
   handle->SetState(rollback ? TransactionHandle::TxState::kRollBacked : TransactionHandle::TxState::kCommitted);
+  handle->ClearSavepoints();
+  std::vector<std::string> written_tables = handle->TakeWrittenTables();
+  auto cache = LoadSnapshot()->result_cache;
+  if (!rollback && cache != nullptr) cache->Invalidate(written_tables);
   auto executor = handle->GetExecutor();
   if (executor) {
-    NodeAddr node_addr;
-    node_addr.ip = executor->GetIp();
-    node_addr.port = executor->GetPort();
-    MysqlExecutorPool* pool = pool_manager_->Get(node_addr);
+    // The pool of the handle, which may no longer be in the pool manager after a rebuild by SetMysqlConfig.
+    std::shared_ptr<MysqlExecutorPool> pool = handle->GetPool();
+    if (pool == nullptr) {
+      NodeAddr node_addr;
+      node_addr.ip = executor->GetIp();
+      node_addr.port = executor->GetPort();
+      pool = LoadSnapshot()->pool_manager->GetShared(node_addr);
+    }
     pool->Reclaim(0, handle->TransferExecutor());
   }
+  handle->ReleaseUse();
   return true;
 }
 
 void MysqlServiceProxy::SetMysqlConfig(const MysqlClientConf& mysql_conf) {
-  mysql_conf_ = mysql_conf;
-  mysql_conf_.Display();
-  thread_pool_->Stop();
-  thread_pool_->Join();
-  thread_pool_ = nullptr;
-  pool_manager_->Stop();
-  pool_manager_->Destroy();
-  pool_manager_ = nullptr;
+  SnapshotPtr old_snapshot = LoadSnapshot();
+  if (old_snapshot->pool_manager != nullptr && CanReconfigureInPlace(mysql_conf)) {
+    ReconfigureInPlace(mysql_conf);
+    return;
+  }
+
+  auto snapshot = std::make_shared<Snapshot>();
+  snapshot->conf = mysql_conf;
+  snapshot->conf.Display();
+
+  // Reboot. The calls in flight hold the old snapshot, they finish on its query classes and connections, which are
+  // freed after them. The old watchdog is not stopped, the open transactions hold it and it sweeps them until they end.
+  InitThreadPool(snapshot->conf);
+  InitSnapshot(std::move(snapshot));
+  for (auto& lane : old_snapshot->lanes) lane->Retire();
+  if (old_snapshot->pool_manager != nullptr) old_snapshot->pool_manager->Stop();
+}
+
+bool MysqlServiceProxy::CanReconfigureInPlace(const MysqlClientConf& mysql_conf) const {
+  SnapshotPtr snapshot = LoadSnapshot();
+  const MysqlClientConf& conf = snapshot->conf;
+  if (conf.execute_mode != mysql_conf.execute_mode || IsFiberMode(conf) != IsFiberMode(mysql_conf) ||
+      conf.thread_bind_core != mysql_conf.thread_bind_core ||
+      conf.num_shard_group != mysql_conf.num_shard_group || conf.numa_aware != mysql_conf.numa_aware ||
+      conf.adaptive_concurrency != mysql_conf.adaptive_concurrency ||
+      conf.query_classes.size() != mysql_conf.query_classes.size()) {
+    return false;
+  }
+
+  for (size_t i = 0; i < conf.query_classes.size(); ++i) {
+    const MysqlQueryClassConf& a = conf.query_classes[i];
+    const MysqlQueryClassConf& b = mysql_conf.query_classes[i];
+    if (a.name != b.name || a.thread_num != b.thread_num || a.fiber_scheduling_group != b.fiber_scheduling_group ||
+        a.max_queue_size != b.max_queue_size || a.max_conn != b.max_conn) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void MysqlServiceProxy::ReconfigureInPlace(const MysqlClientConf& mysql_conf) {
+  // Components whose settings did not change are shared with the published snapshot.
+  SnapshotPtr old_snapshot = LoadSnapshot();
+  const MysqlClientConf& old_conf = old_snapshot->conf;
+  auto snapshot = std::make_shared<Snapshot>(*old_snapshot);
+  snapshot->conf = mysql_conf;
+  const MysqlClientConf& conf = snapshot->conf;
+  conf.Display();
+
+  if (std::atomic_load(&thread_pool_) != nullptr && conf.thread_num != old_conf.thread_num) ResizeThreadPool(conf);
+
+  if (conf.sql_stats != old_conf.sql_stats || conf.max_sql_fingerprints != old_conf.max_sql_fingerprints ||
+      conf.slow_query_threshold != old_conf.slow_query_threshold ||
+      conf.slow_query_log_per_second != old_conf.slow_query_log_per_second) {
+    InitSqlStats(*snapshot);
+  }
+  if (conf.result_cache_bytes != old_conf.result_cache_bytes ||
+      conf.result_cache_shards != old_conf.result_cache_shards) {
+    InitResultCache(*snapshot);
+  }
+
+  // Pools of other nodes keep their connections, even if the node is no longer the primary or a replica.
+  snapshot->pool_manager->Reconfigure(MakePoolOption(*snapshot));
+
+  if (conf.primary != old_conf.primary || conf.replicas != old_conf.replicas) InitReplicaRouter(*snapshot);
+  if (conf.hedge_delay != old_conf.hedge_delay || conf.hedge_percentile != old_conf.hedge_percentile ||
+      conf.hedge_budget != old_conf.hedge_budget) {
+    InitHedging(*snapshot);
+  }
+  // The old watchdog is not stopped: the open transactions hold it and keep their limits until they end.
+  if (conf.tx_idle_timeout != old_conf.tx_idle_timeout || conf.tx_max_duration != old_conf.tx_max_duration) {
+    InitTransactionWatchdog(*snapshot);
+  }
 
-  // Reboot
-  InitThreadPool();
-  InitManager();
+  PublishSnapshot(std::move(snapshot));
 }
 
-void MysqlServiceProxy::SetConfigFromFile() {
+MysqlClientConf MysqlServiceProxy::GetConfigFromFile() {
+  MysqlClientConf mysql_conf;
   YAML::Node node;
   ConfigHelper::GetInstance()->GetNode({"client", "service"}, node);
   for (auto&& idx : node) {
     if (idx["name"].as<std::string>() == GetServiceProxyOption()->name) {
-      mysql_conf_ = idx["mysql"].as<::trpc::mysql::MysqlClientConf>();
+      mysql_conf = idx["mysql"].as<::trpc::mysql::MysqlClientConf>();
     }
   }
+  return mysql_conf;
 }
 
 }  // namespace trpc::mysql
\ No newline at end of file
@@ -13,17 +13,36 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include "trpc/client/service_proxy.h"
 #include "trpc/client/service_proxy_manager.h"
+#include "trpc/coroutine/fiber.h"
 #include "trpc/coroutine/fiber_event.h"
 #include "trpc/coroutine/fiber_latch.h"
+#include "trpc/coroutine/future.h"
+#include "trpc/future/future_utility.h"
+#include "trpc/util/function.h"
 #include "trpc/util/ref_ptr.h"
-#include "trpc/util/thread/latch.h"
-#include "trpc/util/thread/thread_pool.h"
 
 #include "trpc/client/mysql/config/mysql_client_conf.h"
+#include "trpc/client/mysql/mysql_context.h"
 #include "trpc/client/mysql/mysql_executor_pool_manager.h"
+#include "trpc/client/mysql/mysql_hedging.h"
+#include "trpc/client/mysql/mysql_query_key.h"
+#include "trpc/client/mysql/mysql_query_lane.h"
+#include "trpc/client/mysql/mysql_replica_router.h"
+#include "trpc/client/mysql/mysql_result_cache.h"
+#include "trpc/client/mysql/mysql_singleflight.h"
+#include "trpc/client/mysql/mysql_sql_stats.h"
+#include "trpc/client/mysql/mysql_timer.h"
+#include "trpc/client/mysql/mysql_worker_pool.h"
 #include "trpc/client/mysql/transaction.h"
+#include "trpc/client/mysql/transaction_watchdog.h"
 
 namespace trpc::mysql {
 
@@ -51,6 +70,9 @@ class MysqlServiceProxy : public ServiceProxy {
   ///  If an error occurs during the MySQL query, the error will be stored in MysqlResults, but the Status will still be
   ///  OK. If no error occurs in the MySQL query but another error occurs in the call, MysqlResults will contain no
   ///  error, but the Status will reflect the error.
+  /// @note With `result_cache_bytes` in MysqlClientConf, the BindType results of the calls whose context has
+  /// `SetMysqlResultCache` (see mysql_context.h) are cached. Calls whose context has `SetMysqlSingleflight` share
+  /// the BindType results of an identical call in flight.
   template <typename... OutputArgs, typename... InputArgs>
   Status Query(const ClientContextPtr& context, MysqlResults<OutputArgs...>& res, const std::string& sql_str,
                const InputArgs&... args);
@@ -73,12 +95,13 @@ class MysqlServiceProxy : public ServiceProxy {
   Future<MysqlResults<OutputArgs...>> AsyncQuery(const ClientContextPtr& context, const std::string& sql_str,
                                                  const InputArgs&... args);
 
-  /// @brief "Execute" methods are completely the same with "Query" now.
+  /// @brief Same as "Query", except that it goes to the primary when `replicas` is configured in MysqlClientConf,
+  /// while "Query" goes to a replica.
   template <typename... OutputArgs, typename... InputArgs>
   Status Execute(const ClientContextPtr& context, MysqlResults<OutputArgs...>& res, const std::string& sql_str,
                  const InputArgs&... args);
 
-  /// @brief "Execute" methods are completely the same with "Query" now.
+  /// @brief Async version of "Execute", see above.
   template <typename... OutputArgs, typename... InputArgs>
   Future<MysqlResults<OutputArgs...>> AsyncExecute(const ClientContextPtr& context, const std::string& sql_str,
                                                    const InputArgs&... args);
@@ -101,16 +124,36 @@ class MysqlServiceProxy : public ServiceProxy {
   Future<MysqlResults<OutputArgs...>> AsyncExecute(const ClientContextPtr& context, const TxHandlePtr& handle,
                                                    const std::string& sql_str, const InputArgs&... args);
 
+  /// @brief Opens a read-only server-side cursor on the connection of the transaction, for result sets too large to
+  /// hold in memory. The rows are read in batches of `cursor.GetFetchRows()` with FetchCursor.
+  /// @note The cursor must be closed with CloseCursor before the transaction is committed or rolled back, as it lives
+  /// on the connection of the transaction. Other statements of the transaction may run between the fetches.
+  template <typename... OutputArgs, typename... InputArgs>
+  Status OpenCursor(const ClientContextPtr& context, const TxHandlePtr& handle, MysqlCursor<OutputArgs...>& cursor,
+                    const std::string& sql_str, const InputArgs&... args);
+
+  /// @brief Fetches the next batch of rows of the cursor into `res`, overwriting the previous batch in place.
+  /// `cursor.Done()` is true once the rows are exhausted; the last batch may be empty.
+  template <typename... OutputArgs>
+  Status FetchCursor(const ClientContextPtr& context, const TxHandlePtr& handle, MysqlCursor<OutputArgs...>& cursor,
+                     MysqlResults<OutputArgs...>& res);
+
+  template <typename... OutputArgs>
+  Status CloseCursor(const ClientContextPtr& context, const TxHandlePtr& handle, MysqlCursor<OutputArgs...>& cursor);
+
   /// @brief Begin a transaction. An empty handle is needed.
+  /// @note Getting the connection (which may connect to the server) and "begin" run in the same way as queries,
+  /// see `execute_mode` in MysqlClientConf. The calling fiber is suspended meanwhile.
   Status Begin(const ClientContextPtr& context, TxHandlePtr& handle);
 
   /// @brief Commit a transaction.
+  /// @note The handle is left started if "commit" could not be sent (e.g. on timeout), so it can be rolled back.
   Status Commit(const ClientContextPtr& context, const TxHandlePtr& handle);
 
   /// @brief Rollback a transaction.
   Status Rollback(const ClientContextPtr& context, const TxHandlePtr& handle);
 
-  /// @brief Begin a transaction.
+  /// @brief Begin a transaction. Returns immediately, the connection is acquired asynchronously.
   /// @return The refcounted handle pointer of this transaction.
   Future<TxHandlePtr> AsyncBegin(const ClientContextPtr& context);
 
@@ -120,6 +163,76 @@ class MysqlServiceProxy : public ServiceProxy {
   /// @brief Rollback a transaction.
   Future<> AsyncRollback(const ClientContextPtr& context, const TxHandlePtr& handle);
 
+  /// @brief Sets a savepoint in a transaction. An existing savepoint with the same name is moved.
+  /// @param name Savepoint identifier, made of letters, digits, '_' and '$'.
+  Status Savepoint(const ClientContextPtr& context, const TxHandlePtr& handle, const std::string& name);
+
+  /// @brief Rolls back the transaction to a savepoint, which is kept. The savepoints set after it are removed.
+  Status RollbackTo(const ClientContextPtr& context, const TxHandlePtr& handle, const std::string& name);
+
+  /// @brief Removes a savepoint and the savepoints set after it, without changing the transaction.
+  Status Release(const ClientContextPtr& context, const TxHandlePtr& handle, const std::string& name);
+
+  /// @brief Runs `fn` in a transaction and commits it. If `fn` or the commit fails with an error in
+  ///  `policy.retryable_errors` (deadlock and lock wait timeout by default), the transaction is rolled back and `fn`
+  ///  is run again on the same connection after a jittered backoff, as long as retries and the context timeout allow.
+  /// @param fn Called as `Status fn(const TxHandlePtr& handle)`. It runs its statements with `handle` and returns the
+  ///  first failed Status. It must not commit or rollback, and may be called several times.
+  /// @return The status of the last attempt. The transaction is rolled back if it is not OK.
+  template <typename Fn>
+  Status RunInTransaction(const ClientContextPtr& context, Fn&& fn,
+                          const TransactionRetryPolicy& policy = TransactionRetryPolicy());
+
+  /// @brief Counters of RunInTransaction since the proxy was created.
+  TransactionRetryStats GetTransactionRetryStats() const;
+
+  /// @brief Counters of the transactions rolled back by `tx_idle_timeout` and `tx_max_duration` in MysqlClientConf.
+  TransactionWatchdogStats GetTransactionWatchdogStats() const;
+
+  /// @brief The primary and replicas configured in MysqlClientConf, e.g. for observing the outstanding requests of
+  /// each replica.
+  std::shared_ptr<const MysqlReplicaRouter> GetReplicaRouter() const { return LoadSnapshot()->router; }
+
+  /// @brief Counters of the replica reads made with `read_your_writes` since the config was set.
+  ReplicaReadStats GetReplicaReadStats() const { return LoadSnapshot()->router->GetReadStats(); }
+
+  /// @brief The adaptive concurrency limit of each node by "ip:port" (`adaptive_concurrency` in MysqlClientConf).
+  std::unordered_map<std::string, ConcurrencyLimitStats> GetConcurrencyLimits() {
+    auto pool_manager = LoadSnapshot()->pool_manager;
+    return pool_manager != nullptr ? pool_manager->GetConcurrencyLimits()
+                                   : std::unordered_map<std::string, ConcurrencyLimitStats>();
+  }
+
+  /// @brief The cache of the Query calls (`result_cache_bytes` in MysqlClientConf), nullptr if it is disabled.
+  std::shared_ptr<MysqlResultCache> GetResultCache() const { return LoadSnapshot()->result_cache; }
+
+  /// @brief Counters of the Query calls coalesced by SetMysqlSingleflight (see mysql_context.h).
+  SingleflightStats GetSingleflightStats() const { return singleflight_.GetStats(); }
+
+  /// @brief Per SQL fingerprint statistics and slow query count (`sql_stats` and `slow_query_threshold` in
+  /// MysqlClientConf), see mysql_sql_stats_export.h to expose them. nullptr if both are disabled.
+  std::shared_ptr<MysqlSqlStats> GetSqlStats() const { return LoadSnapshot()->sql_stats; }
+
+  /// @brief Statements killed with KILL QUERY because they were still running at the deadline of their context
+  /// (`deadline_propagation` in MysqlClientConf).
+  uint64_t GetDeadlineKills() const { return deadline_kills_.load(std::memory_order_relaxed); }
+
+  /// @brief Counters of the hedged reads (`hedge_delay` and `hedge_percentile` in MysqlClientConf) since the config
+  /// was set.
+  HedgeStats GetHedgeStats() const;
+
+  /// @brief Runs write statements as one transaction. With `multi_statements` in MysqlClientConf,
+  ///  "START TRANSACTION; statements...; COMMIT" is sent as one packet, i.e. a single round trip.
+  ///  The transaction is rolled back if any statement fails.
+  /// @param statements Complete SQL statements without placeholders, and without the trailing ';'.
+  /// @param res The affected rows are summed over all statements.
+  Status RunTransactionScript(const ClientContextPtr& context, const std::vector<std::string>& statements,
+                              MysqlResults<OnlyExec>& res);
+
+  /// @brief Async version of RunTransactionScript.
+  Future<MysqlResults<OnlyExec>> AsyncRunTransactionScript(const ClientContextPtr& context,
+                                                           std::vector<std::string> statements);
+
   void Stop() override;
 
   void Destroy() override;
@@ -127,10 +240,15 @@ class MysqlServiceProxy : public ServiceProxy {
   /// @brief Set the MySQL configuration. Because MysqlClientConf is independent of ServiceProxyOption,
   /// it cannot be set via `GetProxy(const std::string& name, const ServiceProxyOption& option)`.
   /// Therefore, if you want to set the configuration using parameters at runtime instead of YAML,
-  /// @details This will destroy the thread pool and executor pool manager.
   /// This is because when using YAML for configuration, calling
   /// `GetProxy(const std::string& name)` completes the initialization directly without requiring an additional
   /// initialization function.
+  /// @details Also reloads the configuration at runtime. Most settings are applied in place while calls run: the
+  /// thread pool is resized, the pool limits adjust at once, and a change of the connection settings (user,
+  /// password, database, ...) replaces the connections gradually as they are returned (see
+  /// MysqlExecutorPool::Reconfigure). A change of `execute_mode`, `thread_bind_core`, `num_shard_group`,
+  /// `numa_aware`, `adaptive_concurrency` or `query_classes` still replaces the thread pool, the query classes and the
+  /// executor pool manager. The calls in flight finish on the old ones, which are freed after them.
   void SetMysqlConfig(const MysqlClientConf& mysql_conf);
 
  protected:
@@ -138,14 +256,266 @@ class MysqlServiceProxy : public ServiceProxy {
   void SetServiceProxyOptionInner(const std::shared_ptr<ServiceProxyOption>& option) override;
 
  private:
-  /// @brief set mysql_conf from yaml file.
-  void SetConfigFromFile();
+  /// @brief The config and the components built from it, as used by the calls. The snapshot is immutable, a reload
+  /// publishes a new one (see PublishSnapshot) while calls run. A call loads it once and uses it to its end.
+  struct Snapshot {
+    MysqlClientConf conf;
+
+    std::shared_ptr<MysqlReplicaRouter> router;
+
+    /// nullptr if hedging is disabled.
+    std::shared_ptr<HedgePolicy> hedge;
+
+    /// nullptr if `sql_stats` and `slow_query_threshold` are disabled.
+    std::shared_ptr<MysqlSqlStats> sql_stats;
+
+    /// nullptr if `result_cache_bytes` is 0.
+    std::shared_ptr<MysqlResultCache> result_cache;
+
+    /// nullptr if `tx_idle_timeout` and `tx_max_duration` are 0.
+    std::shared_ptr<TransactionWatchdog> tx_watchdog;
+
+    /// Kept by an in-place reload, replaced by a rebuild (see SetMysqlConfig).
+    std::shared_ptr<MysqlExecutorPoolManager> pool_manager;
+
+    /// Query classes in the order of `query_classes`, which is also their index in MysqlExecutorPool.
+    std::vector<std::shared_ptr<MysqlQueryLane>> lanes;
+  };
+
+  using SnapshotPtr = std::shared_ptr<const Snapshot>;
+
+  SnapshotPtr LoadSnapshot() const { return std::atomic_load(&snapshot_); }
+
+  void PublishSnapshot(SnapshotPtr snapshot) { std::atomic_store(&snapshot_, std::move(snapshot)); }
+
+  /// @brief The config in the yaml file, or the default one if the service is not there.
+  MysqlClientConf GetConfigFromFile();
+
+  /// @brief The pool manager only can be inited after the service option has been set.
+  void InitManager(Snapshot& snapshot);
+
+  /// @brief Starts the thread pool of `conf`, and retires the one it replaces (see MysqlWorkerPool::Retire).
+  /// @note No thread pool is created in "fiber" execute mode.
+  void InitThreadPool(const MysqlClientConf& conf);
+
+  static std::shared_ptr<MysqlWorkerPool> StartThreadPool(const MysqlClientConf& conf);
+
+  /// @brief Replaces the thread pool with one of `thread_num` threads. The old one is retired: tasks posted to it
+  /// meanwhile go to the new one, and it is stopped once the tasks queued on it have run.
+  void ResizeThreadPool(const MysqlClientConf& conf);
+
+  /// @brief Whether `mysql_conf` differs from the current config only by settings which can change in place.
+  bool CanReconfigureInPlace(const MysqlClientConf& mysql_conf) const;
+
+  /// @brief Applies `mysql_conf` without dropping the thread pool and the connections, see SetMysqlConfig.
+  void ReconfigureInPlace(const MysqlClientConf& mysql_conf);
+
+  /// @brief Builds the components of `snapshot` from its config and publishes it.
+  void InitSnapshot(std::shared_ptr<Snapshot> snapshot);
+
+  /// @brief Executor pool option from the service proxy option and `snapshot`.
+  MysqlExecutorPoolOption MakePoolOption(const Snapshot& snapshot);
+
+  static void InitReplicaRouter(Snapshot& snapshot);
+
+  static void InitHedging(Snapshot& snapshot);
+
+  /// @brief Points the context at the primary for a write, or at the replica with the least outstanding requests
+  /// for a read. The context is left unchanged if no such node is configured.
+  /// @return Index of the replica to release by `router->ReleaseReplica`, or -1 if no replica is used.
+  int RouteCall(const std::shared_ptr<MysqlReplicaRouter>& router, const ClientContextPtr& context, bool read);
+
+  /// @brief Runs one statement: QueryAll, or Execute for MysqlResults<OnlyExec>.
+  template <typename... OutputArgs, typename... InputArgs>
+  static void RunStatement(const ExecutorPtr& conn, MysqlResults<OutputArgs...>& res, const std::string& sql_str,
+                           const InputArgs&... args);
+
+  /// @brief Keeps the GTID committed by the last statement of `conn` in the context (`read_your_writes`).
+  void SaveSessionGtid(const ClientContextPtr& context, const ExecutorPtr& conn);
+
+  static void InitResultCache(Snapshot& snapshot);
+
+  /// @brief Whether a Query call with `context` goes through the result cache or the singleflight.
+  bool IsSharedQuery(const ClientContextPtr& context) const {
+    const MysqlContextData* data = GetMysqlContextData(context);
+    return data != nullptr && (data->singleflight || (data->cache.ttl_ms != 0 && LoadSnapshot()->result_cache));
+  }
+
+  /// @brief Query with the result cache and the singleflight, see IsSharedQuery.
+  template <typename... OutputArgs, typename... InputArgs>
+  Status SharedQuery(const ClientContextPtr& context, MysqlResults<OutputArgs...>& res, const std::string& sql_str,
+                     const InputArgs&... args);
+
+  template <typename... OutputArgs, typename... InputArgs>
+  Future<MysqlResults<OutputArgs...>> AsyncSharedQuery(const ClientContextPtr& context, const std::string& sql_str,
+                                                       const InputArgs&... args);
+
+  /// @brief Starts a call answered without a query of its own, a result cache hit or a singleflight follower: fills the context and
+  /// runs the CLIENT_PRE_RPC_INVOKE filters.
+  /// @return false if the filters rejected the call, which is finished then.
+  bool StartLocalCall(const ClientContextPtr& context);
+
+  /// @brief Finishes a call started by StartLocalCall: reports its statistics and runs the CLIENT_POST_RPC_INVOKE
+  /// filters.
+  void FinishLocalCall(const ClientContextPtr& context);
+
+  /// @brief The status of a call failed with `ex`, keeping the code of the exception.
+  static Status GetExceptionStatus(const Exception& ex);
+
+  /// @brief Resolved once the leader finished `flight`, or failed with TRPC_CLIENT_INVOKE_TIMEOUT_ERR once the
+  /// timeout of `context` elapsed, so that a follower does not wait on a leader longer than its own call may take.
+  Future<> WaitForLeader(const ClientContextPtr& context, const std::shared_ptr<MysqlSingleflight::Flight>& flight);
+
+  /// @brief Invalidates the cached results of the tables written by `sql`.
+  void InvalidateResultCache(const std::string& sql);
+
+  /// @brief Keeps the tables written by `sql` in the transaction, they are invalidated once it commits.
+  void RecordTransactionWrite(const TxHandlePtr& handle, const std::string& sql);
+
+  /// @brief Sets `mark` of `timeline` to now, if there is a timeline.
+  static void MarkTimeline(MysqlCallTimeline* timeline, uint64_t MysqlCallTimeline::*mark) {
+    if (timeline != nullptr) timeline->*mark = trpc::GetSteadyMicroSeconds();
+  }
+
+  /// @brief Waits until the replica of `conn` has applied `gtid`, for at most `gtid_wait_timeout_ms`.
+  bool WaitForGtid(const ExecutorPtr& conn, const std::string& gtid, uint32_t gtid_wait_timeout_ms);
+
+  /// @brief For replica reads with `read_your_writes`: runs `fn(conn, res)` once the replica `conn` has applied
+  /// `gtid` within `gtid_wait_timeout` of the snapshot, otherwise runs it on a connection to `primary`.
+  template <typename Results, typename Fn>
+  void RunAfterGtid(const ClientContextPtr& context, const SnapshotPtr& snapshot, const ExecutorPtr& conn,
+                    Results& res, const std::string& gtid, const NodeAddr& primary, Fn&& fn);
+
+  /// @brief Implements Query (`read`) and Execute (not `read`) without a transaction.
+  template <typename... OutputArgs, typename... InputArgs>
+  Status RoutedQuery(const ClientContextPtr& context, bool read, MysqlResults<OutputArgs...>& res,
+                     const std::string& sql_str, const InputArgs&... args);
+
+  template <typename... OutputArgs, typename... InputArgs>
+  Future<MysqlResults<OutputArgs...>> AsyncRoutedQuery(const ClientContextPtr& context, bool read,
+                                                       const std::string& sql_str, const InputArgs&... args);
+
+  /// @brief Starts the transaction watchdog of `snapshot` if `tx_idle_timeout` or `tx_max_duration` is set.
+  static void InitTransactionWatchdog(Snapshot& snapshot);
+
+  /// @brief Cancels the statement running on the connection `thread_id` of `node_addr` with KILL QUERY, which is
+  /// sent on another connection of the pool. It may connect, so it only runs on the kill workers.
+  void KillQuery(const NodeAddr& node_addr, unsigned long thread_id);
+
+  /// @brief Shared by a running statement and a KILL QUERY of it.
+  struct KillGuard;
+
+  /// @brief Posts the KILL QUERY of the statement guarded by `guard` to the kill workers, so that neither the caller
+  /// (e.g. the timer thread) blocks on it nor the KILL queues behind the statements it is meant to stop. The KILL is
+  /// skipped if the statement finishes before it is sent.
+  void PostKillQuery(const std::shared_ptr<KillGuard>& guard, const NodeAddr& node_addr, unsigned long thread_id);
+
+  /// @brief Called once the statement guarded by `guard` has finished. If KILL QUERY is being sent, waits until it
+  /// has been, so that the connection cannot run another statement before.
+  /// @return true if the statement has been killed.
+  static bool FinishKillable(KillGuard& guard);
+
+  /// @brief Starts the timer and the kill workers.
+  void InitTimer();
+
+  static void InitSqlStats(Snapshot& snapshot);
+
+  /// @brief Deadline of a call in steady milliseconds, from the timeout of the context. 0 means no deadline.
+  static uint64_t GetCallDeadline(const MysqlClientConf& conf, const ClientContextPtr& context);
+
+  /// @brief Runs `fn` on `conn` bounded by `deadline_ms` (see MysqlExecutor::SetDeadline). If the statement is still
+  /// running at the deadline, the timer posts a KILL QUERY of it to the workers, so that the worker and the
+  /// connection are freed at once.
+  /// @return true if the deadline has passed before or while running `fn`.
+  template <typename Results, typename Fn>
+  bool RunWithDeadline(const ExecutorPtr& conn, uint64_t deadline_ms, Results& res, Fn&& fn);
+
+  /// @brief Status of a call whose deadline has passed in RunWithDeadline.
+  static Status DeadlineExceededStatus();
+
+  /// @brief Admits a call: the queue limit of its query class `lane`, then on `pool` the connection quota of the
+  /// class and the adaptive concurrency limit. Either may be nullptr, e.g. `pool` for a statement in a transaction.
+  /// @param context Gets TRPC_CLIENT_OVERLOAD_ERR (queue limit) or TRPC_CLIENT_LIMITED_ERR in its status if the call
+  /// is rejected, may be nullptr.
+  bool AcquireConcurrency(MysqlQueryLane* lane, MysqlExecutorPool* pool, const ClientContextPtr& context);
+
+  /// @brief Ends a call admitted by AcquireConcurrency.
+  /// @param begin_us When the call started, 0 if the statement did not run (no latency sample).
+  static void ReleaseConcurrency(MysqlQueryLane* lane, MysqlExecutorPool* pool, uint64_t begin_us, bool dropped);
+
+  /// @return The query class of the calls made with `context`, nullptr for the default workers and connections.
+  static std::shared_ptr<MysqlQueryLane> GetQueryLane(const Snapshot& snapshot, const ClientContextPtr& context);
+
+  struct KillGuard {
+    std::mutex mutex;
+
+    /// The statement has finished, it is not killed anymore.
+    bool finished{false};
+
+    /// KILL QUERY is being sent. The connection must not run another statement before it is sent.
+    bool killing{false};
+
+    FiberLatch killed{1};
+  };
+
+  /// @brief Shared by the queries of a hedged read.
+  template <typename Results>
+  struct HedgeCall;
+
+  /// @brief Runs `fn` on the target of the context, and once more on another node if it has not finished after the
+  /// hedge delay. The first successful result is returned and the other query is killed. A failed query waits for
+  /// the other one, the call fails only if both fail (with the failure of the first query) or no hedge was sent.
+  /// @param snapshot Its `hedge` must not be nullptr.
+  /// @param replica Index of the replica of the context, released when its query finishes. -1 if not a replica.
+  /// @return The future fails if the query could not run. A failed statement is returned as a failed MysqlResults.
+  template <typename Results, typename Fn>
+  Future<Results> HedgedInvoke(const ClientContextPtr& context, const SnapshotPtr& snapshot, int replica, Fn&& fn);
+
+  /// @brief Sync version of HedgedInvoke.
+  template <typename Results, typename Fn>
+  void HedgedInvokeWait(const ClientContextPtr& context, const SnapshotPtr& snapshot, int replica, Results& res,
+                        Fn&& fn);
 
-  /// @brief pool_manager_ only can be inited after the service option has been set.
-  bool InitManager();
+  /// @brief Called by the timer after the hedge delay, sends the second query if the first one is still running.
+  template <typename Results>
+  void StartHedge(const std::shared_ptr<HedgeCall<Results>>& call);
 
-  /// @brief thread_pool_ only can be inited after the service option has been set.
-  bool InitThreadPool();
+  template <typename Results>
+  void RunHedgeAttempt(const std::shared_ptr<HedgeCall<Results>>& call, int index);
+
+  /// @brief Completes a hedged read with the outcome of the query `index`.
+  template <typename Results>
+  void FinishHedgedCall(const std::shared_ptr<HedgeCall<Results>>& call, int index);
+
+  /// @brief A target of the selector other than `first` for a hedge without replicas.
+  bool SelectHedgeTarget(const NodeAddr& first, NodeAddr& node_addr);
+
+  void StopTransactionWatchdog();
+
+  /// @brief Creates the query classes of `query_classes` and starts their workers.
+  void InitQueryLanes(Snapshot& snapshot);
+
+  void StopQueryLanes();
+
+  /// @brief Whether the blocking tasks run on fiber workers: "fiber" execute mode with a `fiber_scheduling_group`
+  /// reserved for MySQL calls. Otherwise they run on the thread pool.
+  static bool IsFiberMode(const MysqlClientConf& conf);
+
+  /// @brief Whether a blocking task can run directly in the calling fiber, which is the case in "fiber" execute
+  /// mode when the caller already runs on the scheduling group reserved for MySQL calls.
+  bool CanRunInCaller(MysqlQueryLane* lane) const;
+
+  /// @brief Fiber scheduling group of the blocking tasks of `lane` in "fiber" execute mode.
+  int GetSchedulingGroup(MysqlQueryLane* lane) const;
+
+  /// @brief Runs a blocking task (which uses libmysqlclient) by the execute mode and waits for it to finish.
+  /// @param lane The task runs on the workers of this query class, nullptr for the default workers.
+  /// @return false if the task could not be posted (see PostBlockingTask), it did not run then.
+  bool RunBlockingTask(Function<void()>&& task, MysqlQueryLane* lane = nullptr);
+
+  /// @brief Posts a blocking task (which uses libmysqlclient) by the execute mode without waiting for it.
+  /// @return false if the task could not be posted. The task is dropped in this case.
+  bool PostBlockingTask(Function<void()>&& task, MysqlQueryLane* lane = nullptr);
 
   /// @param context
   /// @param executor If executor is nullptr, it will get a executor from executor manager.
@@ -161,29 +531,170 @@ class MysqlServiceProxy : public ServiceProxy {
   Future<MysqlResults<OutputArgs...>> AsyncUnaryInvoke(const ClientContextPtr& context, const ExecutorPtr& executor,
                                                        const std::string& sql_str, const InputArgs&... args);
 
+  /// @brief Runs `fn(conn, res)` by the execute mode within the send/recv filters and statistics of a call.
+  /// @param executor If executor is nullptr, it will get a executor from executor manager and reclaim it afterwards.
+  /// @param fn Called as `fn(const ExecutorPtr&, Results&)` with a connected executor.
+  template <typename Results, typename Fn>
+  Status InvokeWith(const ClientContextPtr& context, const ExecutorPtr& executor, Results& res, Fn&& fn);
+
+  /// @brief Async version of InvokeWith. `fn` is moved into the task, so it must own what it uses.
+  template <typename Results, typename Fn>
+  Future<Results> AsyncInvokeWith(const ClientContextPtr& context, const ExecutorPtr& executor, Fn&& fn);
+
+  /// @brief Runs `fn(executor)` with the connection of the transaction `handle`, within the RPC filters, once the
+  /// handle is claimed and checked to be in a started transaction on a live connection.
+  template <typename Fn>
+  Status TransactionInvoke(const ClientContextPtr& context, const TxHandlePtr& handle, Fn&& fn);
+
+  /// @brief Resolves the MySQL server of a new transaction. The selector is bypassed if the context has an address.
+  /// @return false if no target is selected, the error is set to context.
+  bool SelectTransactionTarget(const ClientContextPtr& context, NodeAddr& node_addr);
+
+  /// @brief Gets an executor from the pool and executes "begin" on it. It may connect, so it only runs as a
+  /// blocking task (see RunBlockingTask and PostBlockingTask).
+  /// @return The executor which holds the transaction, or nullptr with the error set to context.
+  ExecutorPtr StartTransaction(const ClientContextPtr& context, MysqlExecutorPool* pool);
+
+  /// @brief Wraps the executor of a started transaction and its pool in a handle, registered with the watchdog.
+  TxHandlePtr MakeTransactionHandle(ExecutorPtr&& executor, std::shared_ptr<MysqlExecutorPool> pool);
+
+  /// @brief Rolls back the transaction and begins a new one on the same connection.
+  Status RestartTransaction(const ClientContextPtr& context, const TxHandlePtr& handle);
+
+  /// @brief Counts a retry of RunInTransaction and sleeps for its backoff.
+  /// @param begin_ms When RunInTransaction started, in steady milliseconds.
+  /// @return false if no retry should be made: `error_code` is not retryable, or retries or the context timeout
+  ///  are exhausted.
+  bool WaitForTransactionRetry(const ClientContextPtr& context, const TransactionRetryPolicy& policy,
+                               uint32_t attempt, int error_code, uint64_t begin_ms);
+
+  /// @brief Ends a `deferred_begin` transaction which has not executed any statement, without a round trip.
+  /// @return false if "START TRANSACTION" has been sent, so the transaction must be ended on the server.
+  bool EndPendingTransaction(const TxHandlePtr& handle, bool rollback);
+
   /// @brief Set the handle state and reclaim its executor.
   /// @param rollback set the state to rollback otherwise commited.
-  /// @return true if success.
+  /// @return true if success, false if the handle has been taken by the transaction watchdog.
   bool EndTransaction(const TxHandlePtr& handle, bool rollback);
 
  private:
-  std::unique_ptr<ThreadPool> thread_pool_{nullptr};
+  /// Only accessed through std::atomic_load/std::atomic_store/std::atomic_exchange, a reload replaces it while calls
+  /// post to it (see PostBlockingTask).
+  std::shared_ptr<MysqlWorkerPool> thread_pool_{nullptr};
+
+  std::atomic<bool> fiber_mode_{false};
+
+  /// Only accessed through LoadSnapshot and PublishSnapshot.
+  SnapshotPtr snapshot_{std::make_shared<Snapshot>()};
+
+  /// Runs the hedges of slow reads and the KILL QUERY of statements past their deadline.
+  std::unique_ptr<MysqlTimer> timer_{nullptr};
+
+  /// Sends the KILL QUERYs, apart from the workers which may all be blocked by the statements to kill.
+  std::unique_ptr<MysqlWorkerPool> kill_pool_{nullptr};
 
-  std::unique_ptr<MysqlExecutorPoolManager> pool_manager_{nullptr};
+  std::atomic<uint64_t> deadline_kills_{0};
 
-  MysqlClientConf mysql_conf_;
+  MysqlSingleflight singleflight_;
+
+  struct {
+    std::atomic<uint64_t> transactions{0};
+    std::atomic<uint64_t> retries{0};
+    std::atomic<uint64_t> deadlock_retries{0};
+    std::atomic<uint64_t> lock_wait_retries{0};
+    std::atomic<uint64_t> exhausted{0};
+  } tx_retry_counters_;
 };
 
 template <typename... OutputArgs, typename... InputArgs>
 Status MysqlServiceProxy::Query(const ClientContextPtr& context, MysqlResults<OutputArgs...>& res,
                                 const std::string& sql_str, const InputArgs&... args) {
+  if constexpr (MysqlResults<OutputArgs...>::mode == MysqlResultsMode::BindType) {
+    if (IsSharedQuery(context)) return SharedQuery(context, res, sql_str, args...);
+  }
+  return RoutedQuery(context, true, res, sql_str, args...);
+}
+
+template <typename... OutputArgs, typename... InputArgs>
+Status MysqlServiceProxy::SharedQuery(const ClientContextPtr& context, MysqlResults<OutputArgs...>& res,
+                                      const std::string& sql_str, const InputArgs&... args) {
+  using Results = MysqlResults<OutputArgs...>;
+  std::string key = MysqlQueryKey::Make<OutputArgs...>(sql_str, args...);
+  auto cache = LoadSnapshot()->result_cache;
+  // Taken before the call, the options live in the context which the call may modify.
+  const MysqlContextData* data = GetMysqlContextData(context);
+  uint64_t ttl_ms = cache != nullptr ? data->cache.ttl_ms : 0;
+  // A call reading its own writes must not share the results of a call which started before them.
+  bool coalesce = data->singleflight && data->gtid.empty();
+
+  if (ttl_ms != 0 && cache->Get(key, res)) {
+    if (StartLocalCall(context)) {
+      context->SetStatus(Status());
+      FinishLocalCall(context);
+    } else {
+      res.Clear();
+    }
+    return context->GetStatus();
+  }
+  ResultCacheTags tags;
+  if (ttl_ms != 0) tags = cache->GetTags(data->cache.tables);
+
+  bool leader = true;
+  std::shared_ptr<MysqlSingleflight::Flight> flight = coalesce ? singleflight_.Join(key, leader) : nullptr;
+  if (!leader) {
+    // Leaving without waiting is fine, the flight does not wait on its followers.
+    if (!StartLocalCall(context)) return context->GetStatus();
+    auto fu = WaitForLeader(context, flight);
+    fu = IsRunningInFiberWorker() ? fiber::BlockingGet(std::move(fu)) : future::BlockingGet(std::move(fu));
+    if (fu.IsFailed()) {
+      context->SetStatus(GetExceptionStatus(fu.GetException()));
+    } else {
+      if (flight->results != nullptr) res.CopyFrom(*static_cast<const Results*>(flight->results.get()));
+      context->SetStatus(flight->status);
+    }
+    FinishLocalCall(context);
+    return context->GetStatus();
+  }
+
+  RoutedQuery(context, true, res, sql_str, args...);
+  bool ok = context->GetStatus().OK();
+  if (flight != nullptr) singleflight_.Finish(key, flight, ok ? &res : nullptr, context->GetStatus());
+  if (ttl_ms != 0 && ok && res.OK()) cache->Put(key, res, ttl_ms, std::move(tags));
+  return context->GetStatus();
+}
+
+template <typename... OutputArgs, typename... InputArgs>
+Status MysqlServiceProxy::RoutedQuery(const ClientContextPtr& context, bool read, MysqlResults<OutputArgs...>& res,
+                                      const std::string& sql_str, const InputArgs&... args) {
   FillClientContext(context);
 
   auto filter_status = filter_controller_.RunMessageClientFilters(FilterPoint::CLIENT_PRE_RPC_INVOKE, context);
-  if (filter_status == FilterStatus::REJECT)
+  if (filter_status == FilterStatus::REJECT) {
     TRPC_FMT_ERROR("service name:{}, filter execute failed.", GetServiceName());
-  else
-    UnaryInvoke(context, nullptr, res, sql_str, args...);
+  } else {
+    auto snapshot = LoadSnapshot();
+    const auto& router = snapshot->router;
+    NodeAddr primary = router->HasPrimary() ? router->GetPrimary() : context->GetNodeAddr();
+    int replica = RouteCall(router, context, read);
+    std::string gtid = replica >= 0 && snapshot->conf.read_your_writes ? GetMysqlGtid(context) : "";
+
+    if (gtid.empty() && read && snapshot->hedge != nullptr) {
+      // The losing query may outlive this call, so the statement is copied.
+      auto run = [sql_str, args...](const ExecutorPtr& c, MysqlResults<OutputArgs...>& r) {
+        RunStatement(c, r, sql_str, args...);
+      };
+      HedgedInvokeWait(context, snapshot, replica, res, std::move(run));
+      replica = -1;  // Released by the query on the replica.
+    } else if (gtid.empty()) {
+      UnaryInvoke(context, nullptr, res, sql_str, args...);
+    } else {
+      auto run = [&](const ExecutorPtr& c, MysqlResults<OutputArgs...>& r) { RunStatement(c, r, sql_str, args...); };
+      InvokeWith(context, nullptr, res, [&](const ExecutorPtr& conn, MysqlResults<OutputArgs...>& conn_res) {
+        RunAfterGtid(context, snapshot, conn, conn_res, gtid, primary, run);
+      });
+    }
+    if (replica >= 0) router->ReleaseReplica(replica);
+  }
 
   RunFilters(FilterPoint::CLIENT_POST_RPC_INVOKE, context);
   return context->GetStatus();
@@ -193,6 +704,89 @@ template <typename... OutputArgs, typename... InputArgs>
 Future<MysqlResults<OutputArgs...>> MysqlServiceProxy::AsyncQuery(const ClientContextPtr& context,
                                                                   const std::string& sql_str,
                                                                   const InputArgs&... args) {
+  if constexpr (MysqlResults<OutputArgs...>::mode == MysqlResultsMode::BindType) {
+    if (IsSharedQuery(context)) return AsyncSharedQuery<OutputArgs...>(context, sql_str, args...);
+  }
+  return AsyncRoutedQuery<OutputArgs...>(context, true, sql_str, args...);
+}
+
+template <typename... OutputArgs, typename... InputArgs>
+Future<MysqlResults<OutputArgs...>> MysqlServiceProxy::AsyncSharedQuery(const ClientContextPtr& context,
+                                                                        const std::string& sql_str,
+                                                                        const InputArgs&... args) {
+  using Results = MysqlResults<OutputArgs...>;
+  std::string key = MysqlQueryKey::Make<OutputArgs...>(sql_str, args...);
+  auto cache = LoadSnapshot()->result_cache;
+  const MysqlContextData* data = GetMysqlContextData(context);
+  uint64_t ttl_ms = cache != nullptr ? data->cache.ttl_ms : 0;
+  bool coalesce = data->singleflight && data->gtid.empty();
+
+  if (ttl_ms != 0) {
+    Results res;
+    if (cache->Get(key, res)) {
+      if (!StartLocalCall(context)) {
+        const Status& result = context->GetStatus();
+        return MakeExceptionFuture<Results>(CommonException(result.ErrorMessage().c_str()));
+      }
+      context->SetStatus(Status());
+      FinishLocalCall(context);
+      return MakeReadyFuture<Results>(std::move(res));
+    }
+  }
+  ResultCacheTags tags;
+  if (ttl_ms != 0) tags = cache->GetTags(data->cache.tables);
+
+  bool leader = true;
+  std::shared_ptr<MysqlSingleflight::Flight> flight = coalesce ? singleflight_.Join(key, leader) : nullptr;
+  if (!leader) {
+    if (!StartLocalCall(context)) {
+      const Status& result = context->GetStatus();
+      return MakeExceptionFuture<Results>(CommonException(result.ErrorMessage().c_str()));
+    }
+    return WaitForLeader(context, flight).Then([this, context, flight](Future<>&& f) {
+      Results res;
+      Status status;
+      if (f.IsFailed()) {
+        status = GetExceptionStatus(f.GetException());
+      } else if (flight->results == nullptr) {
+        status = flight->status;
+      } else {
+        res.CopyFrom(*static_cast<const Results*>(flight->results.get()));
+        if (!res.OK()) {
+          status.SetFrameworkRetCode(res.GetErrorNumber());
+          status.SetErrorMessage(res.GetErrorMessage());
+        }
+      }
+      context->SetStatus(status);
+      FinishLocalCall(context);
+      if (!status.OK()) {
+        return MakeExceptionFuture<Results>(
+            CommonException(status.ErrorMessage().c_str(), status.GetFrameworkRetCode()));
+      }
+      return MakeReadyFuture<Results>(std::move(res));
+    });
+  }
+
+  return AsyncRoutedQuery<OutputArgs...>(context, true, sql_str, args...)
+      .Then([this, cache, key = std::move(key), ttl_ms, tags = std::move(tags), flight](Future<Results>&& f) mutable {
+        if (f.IsFailed()) {
+          if (flight != nullptr) {
+            Status status(TrpcRetCode::TRPC_INVOKE_UNKNOWN_ERR, f.GetException().what());
+            singleflight_.Finish<Results>(key, flight, nullptr, std::move(status));
+          }
+          return MakeExceptionFuture<Results>(f.GetException());
+        }
+        Results res = f.GetValue0();
+        if (flight != nullptr) singleflight_.Finish(key, flight, &res, Status());
+        if (ttl_ms != 0) cache->Put(key, res, ttl_ms, std::move(tags));
+        return MakeReadyFuture<Results>(std::move(res));
+      });
+}
+
+template <typename... OutputArgs, typename... InputArgs>
+Future<MysqlResults<OutputArgs...>> MysqlServiceProxy::AsyncRoutedQuery(const ClientContextPtr& context, bool read,
+                                                                        const std::string& sql_str,
+                                                                        const InputArgs&... args) {
   FillClientContext(context);
 
   auto filter_status = filter_controller_.RunMessageClientFilters(FilterPoint::CLIENT_PRE_RPC_INVOKE, context);
@@ -206,34 +800,116 @@ Future<MysqlResults<OutputArgs...>> MysqlServiceProxy::AsyncQuery(const ClientCo
     return exception_fut;
   }
 
-  return AsyncUnaryInvoke<OutputArgs...>(context, nullptr, sql_str, args...)
-      .Then([this, context](Future<MysqlResults<OutputArgs...>>&& f) {
-        if (f.IsFailed()) {
-          RunFilters(FilterPoint::CLIENT_POST_RPC_INVOKE, context);
-          return MakeExceptionFuture<MysqlResults<OutputArgs...>>(f.GetException());
-        }
-        RunFilters(FilterPoint::CLIENT_POST_RPC_INVOKE, context);
-        return MakeReadyFuture<MysqlResults<OutputArgs...>>(f.GetValue0());
-      });
+  auto snapshot = LoadSnapshot();
+  auto router = snapshot->router;
+  NodeAddr primary = router->HasPrimary() ? router->GetPrimary() : context->GetNodeAddr();
+  int replica = RouteCall(router, context, read);
+  std::string gtid = replica >= 0 && snapshot->conf.read_your_writes ? GetMysqlGtid(context) : "";
+
+  auto invoke = [&]() {
+    if (read && gtid.empty() && snapshot->hedge != nullptr) {
+      using Results = MysqlResults<OutputArgs...>;
+      auto run = [sql_str, args...](const ExecutorPtr& c, Results& r) { RunStatement(c, r, sql_str, args...); };
+      int hedged_replica = replica;
+      replica = -1;  // Released by the query on the replica.
+      return HedgedInvoke<Results>(context, snapshot, hedged_replica, std::move(run))
+          .Then([](Future<Results>&& f) {
+            if (f.IsFailed()) return MakeExceptionFuture<Results>(f.GetException());
+            Results res = f.GetValue0();
+            if (!res.OK()) return MakeExceptionFuture<Results>(CommonException(res.GetErrorMessage().c_str()));
+            return MakeReadyFuture<Results>(std::move(res));
+          });
+    }
+    if (gtid.empty()) return AsyncUnaryInvoke<OutputArgs...>(context, nullptr, sql_str, args...);
+    return AsyncInvokeWith<MysqlResults<OutputArgs...>>(
+        context, nullptr,
+        [this, context, snapshot, gtid, primary, sql_str, args...](const ExecutorPtr& conn,
+                                                                    MysqlResults<OutputArgs...>& conn_res) {
+          RunAfterGtid(context, snapshot, conn, conn_res, gtid, primary,
+                       [&](const ExecutorPtr& c, MysqlResults<OutputArgs...>& r) {
+                         RunStatement(c, r, sql_str, args...);
+                       });
+        });
+  };
+
+  // `invoke` hands the replica over to a hedged read, so it runs before `replica` is captured.
+  auto fut = invoke();
+  return fut.Then([this, context, router, replica](Future<MysqlResults<OutputArgs...>>&& f) {
+    if (replica >= 0) router->ReleaseReplica(replica);
+    if (f.IsFailed()) {
+      RunFilters(FilterPoint::CLIENT_POST_RPC_INVOKE, context);
+      return MakeExceptionFuture<MysqlResults<OutputArgs...>>(f.GetException());
+    }
+    RunFilters(FilterPoint::CLIENT_POST_RPC_INVOKE, context);
+    return MakeReadyFuture<MysqlResults<OutputArgs...>>(f.GetValue0());
+  });
 }
 
 template <typename... OutputArgs, typename... InputArgs>
 Status MysqlServiceProxy::Execute(const ClientContextPtr& context, MysqlResults<OutputArgs...>& res,
                                   const std::string& sql_str, const InputArgs&... args) {
-  return Query(context, res, sql_str, args...);
+  Status status = RoutedQuery(context, false, res, sql_str, args...);
+  InvalidateResultCache(sql_str);
+  return status;
 }
 
 template <typename... OutputArgs, typename... InputArgs>
 Future<MysqlResults<OutputArgs...>> MysqlServiceProxy::AsyncExecute(const ClientContextPtr& context,
                                                                     const std::string& sql_str,
                                                                     const InputArgs&... args) {
-  return AsyncQuery<OutputArgs...>(context, sql_str, args...);
+  auto fut = AsyncRoutedQuery<OutputArgs...>(context, false, sql_str, args...);
+  if (LoadSnapshot()->result_cache == nullptr) return fut;
+  return fut.Then([this, sql_str](Future<MysqlResults<OutputArgs...>>&& f) {
+    InvalidateResultCache(sql_str);
+    return std::move(f);
+  });
 }
 
 template <typename... OutputArgs, typename... InputArgs>
 Status MysqlServiceProxy::Query(const ClientContextPtr& context, const TxHandlePtr& handle,
                                 MysqlResults<OutputArgs...>& res, const std::string& sql_str,
                                 const InputArgs&... args) {
+  return TransactionInvoke(context, handle, [&](const ExecutorPtr& executor) {
+    RecordTransactionWrite(handle, sql_str);
+    UnaryInvoke(context, executor, res, sql_str, args...);
+  });
+}
+
+template <typename... OutputArgs, typename... InputArgs>
+Status MysqlServiceProxy::OpenCursor(const ClientContextPtr& context, const TxHandlePtr& handle,
+                                     MysqlCursor<OutputArgs...>& cursor, const std::string& sql_str,
+                                     const InputArgs&... args) {
+  MysqlResults<OutputArgs...> res;
+  return TransactionInvoke(context, handle, [&](const ExecutorPtr& executor) {
+    InvokeWith(context, executor, res, [&](const ExecutorPtr& conn, MysqlResults<OutputArgs...>& conn_res) {
+      conn->OpenCursor(cursor, conn_res, sql_str, args...);
+    });
+  });
+}
+
+template <typename... OutputArgs>
+Status MysqlServiceProxy::FetchCursor(const ClientContextPtr& context, const TxHandlePtr& handle,
+                                      MysqlCursor<OutputArgs...>& cursor, MysqlResults<OutputArgs...>& res) {
+  return TransactionInvoke(context, handle, [&](const ExecutorPtr& executor) {
+    InvokeWith(context, executor, res, [&cursor](const ExecutorPtr& conn, MysqlResults<OutputArgs...>& conn_res) {
+      conn->FetchCursor(cursor, conn_res);
+    });
+  });
+}
+
+template <typename... OutputArgs>
+Status MysqlServiceProxy::CloseCursor(const ClientContextPtr& context, const TxHandlePtr& handle,
+                                      MysqlCursor<OutputArgs...>& cursor) {
+  if (!cursor.IsOpen()) return Status();
+
+  MysqlResults<OnlyExec> res;
+  return TransactionInvoke(context, handle, [&](const ExecutorPtr& executor) {
+    InvokeWith(context, executor, res, [&cursor](const ExecutorPtr&, MysqlResults<OnlyExec>&) { cursor.Close(); });
+  });
+}
+
+template <typename Fn>
+Status MysqlServiceProxy::TransactionInvoke(const ClientContextPtr& context, const TxHandlePtr& handle, Fn&& fn) {
   Status status;
   FillClientContext(context);
 
@@ -241,22 +917,30 @@ Status MysqlServiceProxy::Query(const ClientContextPtr& context, const TxHandleP
 
   if (filter_status == FilterStatus::REJECT) {
     TRPC_FMT_ERROR("service name:{}, filter execute failed.", GetServiceName());
-  } else if (handle->GetState() != TransactionHandle::TxState::kStarted) {
-    TRPC_FMT_ERROR("service name:{}, query in an invalid transaction.", GetServiceName());
-    status.SetFrameworkRetCode(TrpcMysqlRetCode::TRPC_MYSQL_INVALID_HANDLE);
-    status.SetErrorMessage(util::FormatString("Invalid transaction state code: {}.", int(handle->GetState())));
-    context->SetStatus(std::move(status));
-
-  } else if (!handle->GetExecutor()->CheckAlive()) {
-    // If the Connection lost the transaction will be rollback automatically. (some exception?)
-    TRPC_FMT_ERROR("service name:{}, transaction connection lost.", GetServiceName());
-    handle->SetState(TransactionHandle::TxState::kRollBacked);
-    status.SetFrameworkRetCode(TrpcRetCode::TRPC_CLIENT_CONNECT_ERR);
-    status.SetErrorMessage("Connect error. Rollback.");
-    context->SetStatus(status);
+  } else if (!handle->TryAcquire()) {
+    TRPC_FMT_ERROR("service name:{}, transaction handle is in use.", GetServiceName());
+    context->SetStatus(Status(TrpcMysqlRetCode::TRPC_MYSQL_INVALID_HANDLE, "Transaction handle is in use."));
 
   } else {
-    UnaryInvoke(context, handle->GetExecutor(), res, sql_str, args...);
+    // The handle is claimed, so the transaction watchdog leaves it alone until the statement finishes.
+    if (handle->GetState() != TransactionHandle::TxState::kStarted) {
+      TRPC_FMT_ERROR("service name:{}, query in an invalid transaction.", GetServiceName());
+      status.SetFrameworkRetCode(TrpcMysqlRetCode::TRPC_MYSQL_INVALID_HANDLE);
+      status.SetErrorMessage(util::FormatString("Invalid transaction state code: {}.", int(handle->GetState())));
+      context->SetStatus(std::move(status));
+
+    } else if (!handle->GetExecutor()->CheckAlive()) {
+      // If the Connection lost the transaction will be rollback automatically. (some exception?)
+      TRPC_FMT_ERROR("service name:{}, transaction connection lost.", GetServiceName());
+      handle->SetState(TransactionHandle::TxState::kRollBacked);
+      status.SetFrameworkRetCode(TrpcRetCode::TRPC_CLIENT_CONNECT_ERR);
+      status.SetErrorMessage("Connect error. Rollback.");
+      context->SetStatus(status);
+
+    } else {
+      fn(handle->GetExecutor());
+    }
+    handle->ReleaseUse();
   }
 
   RunFilters(FilterPoint::CLIENT_POST_RPC_INVOKE, context);
@@ -286,7 +970,15 @@ Future<MysqlResults<OutputArgs...>> MysqlServiceProxy::AsyncQuery(const ClientCo
     return exception_fut;
   }
 
+  if (!handle->TryAcquire()) {
+    TRPC_FMT_ERROR("service name:{}, transaction handle is in use.", GetServiceName());
+    context->SetStatus(Status(TrpcMysqlRetCode::TRPC_MYSQL_INVALID_HANDLE, "Transaction handle is in use."));
+    filter_controller_.RunMessageClientFilters(FilterPoint::CLIENT_POST_RPC_INVOKE, context);
+    return MakeExceptionFuture<MysqlResults<OutputArgs...>>(CommonException("Transaction handle is in use."));
+  }
+
   if (handle->GetState() != TransactionHandle::TxState::kStarted) {
+    handle->ReleaseUse();
     TRPC_FMT_ERROR("service name:{}, invalid handle state.");
     context->SetStatus(Status(TrpcMysqlRetCode::TRPC_MYSQL_INVALID_HANDLE, "Invalid handle."));
     filter_controller_.RunMessageClientFilters(FilterPoint::CLIENT_POST_RPC_INVOKE, context);
@@ -295,6 +987,7 @@ Future<MysqlResults<OutputArgs...>> MysqlServiceProxy::AsyncQuery(const ClientCo
 
   if (!handle->GetExecutor()->CheckAlive()) {
     handle->SetState(TransactionHandle::TxState::kRollBacked);
+    handle->ReleaseUse();
     Status status;
     status.SetFrameworkRetCode(TrpcRetCode::TRPC_CLIENT_CONNECT_ERR);
     status.SetErrorMessage("Connect error. Rollback.");
@@ -305,9 +998,11 @@ Future<MysqlResults<OutputArgs...>> MysqlServiceProxy::AsyncQuery(const ClientCo
   }
 
   auto executor = handle->GetExecutor();
+  RecordTransactionWrite(handle, sql_str);
 
   return AsyncUnaryInvoke<OutputArgs...>(context, executor, sql_str, args...)
-      .Then([this, context](Future<MysqlResults<OutputArgs...>>&& f) mutable {
+      .Then([this, context, handle](Future<MysqlResults<OutputArgs...>>&& f) mutable {
+        handle->ReleaseUse();
         if (f.IsFailed()) {
           RunFilters(FilterPoint::CLIENT_POST_RPC_INVOKE, context);
           return MakeExceptionFuture<MysqlResults<OutputArgs...>>(f.GetException());
@@ -326,10 +1021,104 @@ Future<MysqlResults<OutputArgs...>> MysqlServiceProxy::AsyncExecute(const Client
   return AsyncQuery<OutputArgs...>(context, handle, sql_str, args...);
 }
 
+template <typename Fn>
+Status MysqlServiceProxy::RunInTransaction(const ClientContextPtr& context, Fn&& fn,
+                                           const TransactionRetryPolicy& policy) {
+  uint64_t begin_ms = trpc::GetSteadyMilliSeconds();
+
+  TxHandlePtr handle{nullptr};
+  Status status = Begin(context, handle);
+  if (!status.OK()) return status;
+
+  tx_retry_counters_.transactions.fetch_add(1, std::memory_order_relaxed);
+
+  for (uint32_t attempt = 0;; ++attempt) {
+    status = fn(handle);
+    if (status.OK()) status = Commit(context, handle);
+    if (status.OK()) return status;
+
+    if (handle->GetState() != TransactionHandle::TxState::kStarted ||
+        !WaitForTransactionRetry(context, policy, attempt, status.GetFrameworkRetCode(), begin_ms))
+      break;
+
+    // The status of the failed attempt must not leak into the next one.
+    context->SetStatus(Status());
+    Status restart_status = RestartTransaction(context, handle);
+    if (!restart_status.OK()) {
+      status = restart_status;
+      break;
+    }
+  }
+
+  if (handle->GetState() == TransactionHandle::TxState::kStarted) {
+    Rollback(context, handle);
+    context->SetStatus(status);
+  }
+  return status;
+}
+
 template <typename... OutputArgs, typename... InputArgs>
 Status MysqlServiceProxy::UnaryInvoke(const ClientContextPtr& context, const ExecutorPtr& executor,
                                       MysqlResults<OutputArgs...>& res, const std::string& sql_str,
                                       const InputArgs&... args) {
+  return InvokeWith(context, executor, res,
+                    [&sql_str, &args...](const ExecutorPtr& conn, MysqlResults<OutputArgs...>& conn_res) {
+                      RunStatement(conn, conn_res, sql_str, args...);
+                    });
+}
+
+template <typename... OutputArgs, typename... InputArgs>
+Future<MysqlResults<OutputArgs...>> MysqlServiceProxy::AsyncUnaryInvoke(const ClientContextPtr& context,
+                                                                        const ExecutorPtr& executor,
+                                                                        const std::string& sql_str,
+                                                                        const InputArgs&... args) {
+  return AsyncInvokeWith<MysqlResults<OutputArgs...>>(
+      context, executor, [sql_str, args...](const ExecutorPtr& conn, MysqlResults<OutputArgs...>& conn_res) {
+        RunStatement(conn, conn_res, sql_str, args...);
+      });
+}
+
+template <typename... OutputArgs, typename... InputArgs>
+void MysqlServiceProxy::RunStatement(const ExecutorPtr& conn, MysqlResults<OutputArgs...>& res,
+                                     const std::string& sql_str, const InputArgs&... args) {
+  if constexpr (MysqlResults<OutputArgs...>::mode == MysqlResultsMode::OnlyExec)
+    conn->Execute(res, sql_str, args...);
+  else
+    conn->QueryAll(res, sql_str, args...);
+}
+
+template <typename Results, typename Fn>
+void MysqlServiceProxy::RunAfterGtid(const ClientContextPtr& context, const SnapshotPtr& snapshot,
+                                     const ExecutorPtr& conn, Results& res, const std::string& gtid,
+                                     const NodeAddr& primary, Fn&& fn) {
+  bool applied = WaitForGtid(conn, gtid, snapshot->conf.gtid_wait_timeout);
+  snapshot->router->CountGtidWait(!applied);
+  if (applied) {
+    fn(conn, res);
+    return;
+  }
+
+  TRPC_FMT_DEBUG("service name:{}, replica {}:{} is behind {}, read from the primary.", GetServiceName(),
+                 conn->GetIp(), conn->GetPort(), gtid);
+  std::shared_ptr<MysqlExecutorPool> pool = snapshot->pool_manager->GetShared(primary);
+  ExecutorPtr primary_conn = pool->GetExecutor();
+  if (!primary_conn->IsConnected()) {
+    std::string error_message = util::FormatString("service name:{}, connection failed. {}.", GetServiceName(),
+                                                   primary_conn->GetErrorMessage());
+    TRPC_LOG_ERROR(error_message);
+    Status status;
+    status.SetFrameworkRetCode(primary_conn->GetErrorNumber());
+    status.SetErrorMessage(error_message);
+    context->SetStatus(std::move(status));
+    return;
+  }
+  fn(primary_conn, res);
+  pool->Reclaim(0, std::move(primary_conn));
+}
+
+template <typename Results, typename Fn>
+Status MysqlServiceProxy::InvokeWith(const ClientContextPtr& context, const ExecutorPtr& executor, Results& res,
+                                     Fn&& fn) {
   if (CheckTimeout(context)) return context->GetStatus();
 
   int filter_ret = RunFilters(FilterPoint::CLIENT_PRE_SEND_MSG, context);
@@ -340,19 +1129,34 @@ Status MysqlServiceProxy::UnaryInvoke(const ClientContextPtr& context, const Exe
     return context->GetStatus();
   }
 
-  FiberEvent e;
-  thread_pool_->AddTask([this, &context, &executor, &e, &res, &sql_str, &args...]() {
-    ExecutorPtr conn{nullptr};
-    MysqlExecutorPool* pool{nullptr};
+  auto snapshot = LoadSnapshot();
+  std::shared_ptr<MysqlQueryLane> lane = GetQueryLane(*snapshot, context);
+  std::shared_ptr<MysqlExecutorPool> pool{nullptr};
+  if (executor == nullptr) {
+    NodeAddr node_addr;
+    node_addr.ip = context->GetIp();
+    node_addr.port = context->GetPort();
+    pool = snapshot->pool_manager->GetShared(node_addr);
+  }
+  if (!AcquireConcurrency(lane.get(), pool.get(), context)) {
+    ProxyStatistics(context);
+    RunFilters(FilterPoint::CLIENT_POST_RECV_MSG, context);
+    return context->GetStatus();
+  }
 
-    if (executor == nullptr) {
-      NodeAddr node_addr;
-      node_addr.ip = context->GetIp();
-      node_addr.port = context->GetPort();
-      pool = this->pool_manager_->Get(node_addr);
-      conn = pool->GetExecutor();
-    } else
-      conn = executor;
+  uint64_t begin_us = trpc::GetSteadyMicroSeconds();
+  uint64_t deadline_ms = GetCallDeadline(snapshot->conf, context);
+  bool read_your_writes = snapshot->conf.read_your_writes;
+  bool deadline_exceeded = false;
+  bool ran = false;
+  MysqlCallTimeline call_timeline;
+  MysqlCallTimeline* timeline = snapshot->conf.call_timeline ? &call_timeline : nullptr;
+  if (timeline != nullptr) timeline->posted_us = begin_us;
+  bool posted = RunBlockingTask([this, &context, &executor, &res, &fn, &pool, deadline_ms, read_your_writes,
+                                 &deadline_exceeded, &ran, timeline]() {
+    MarkTimeline(timeline, &MysqlCallTimeline::started_us);
+    ExecutorPtr conn = pool != nullptr ? pool->GetExecutor() : executor;
+    MarkTimeline(timeline, &MysqlCallTimeline::acquired_us);
 
     if (!conn->IsConnected()) {
       std::string error_message =
@@ -363,19 +1167,27 @@ Status MysqlServiceProxy::UnaryInvoke(const ClientContextPtr& context, const Exe
       status.SetErrorMessage(error_message);
       context->SetStatus(std::move(status));
     } else {
-      if constexpr (MysqlResults<OutputArgs...>::mode == MysqlResultsMode::OnlyExec)
-        conn->Execute(res, sql_str, args...);
-      else
-        conn->QueryAll(res, sql_str, args...);
+      if (timeline != nullptr) conn->SetCallPhases(&timeline->statements);
+      deadline_exceeded = RunWithDeadline(conn, deadline_ms, res, fn);
+      if (timeline != nullptr) conn->SetCallPhases(nullptr);
+      ran = true;
+      if (read_your_writes) SaveSessionGtid(context, conn);
 
       if (pool != nullptr) pool->Reclaim(0, std::move(conn));
+      MarkTimeline(timeline, &MysqlCallTimeline::finished_us);
     }
-    e.Set();
-  });
-
-  e.Wait();
+  }, lane.get());
+  if (timeline != nullptr) {
+    MarkTimeline(timeline, &MysqlCallTimeline::resumed_us);
+    MutableMysqlContextData(context)->timeline = call_timeline;
+  }
+  ReleaseConcurrency(lane.get(), pool.get(), ran ? begin_us : 0, deadline_exceeded);
 
-  if (!res.OK()) {
+  if (TRPC_UNLIKELY(!posted)) {
+    context->SetStatus(Status(TrpcRetCode::TRPC_CLIENT_OVERLOAD_ERR, "Failed to post the mysql task."));
+  } else if (deadline_exceeded) {
+    context->SetStatus(DeadlineExceededStatus());
+  } else if (!res.OK()) {
     Status s;
     s.SetErrorMessage(res.GetErrorMessage());
     s.SetFrameworkRetCode(res.GetErrorNumber());
@@ -388,18 +1200,15 @@ Status MysqlServiceProxy::UnaryInvoke(const ClientContextPtr& context, const Exe
   return context->GetStatus();
 }
 
-template <typename... OutputArgs, typename... InputArgs>
-Future<MysqlResults<OutputArgs...>> MysqlServiceProxy::AsyncUnaryInvoke(const ClientContextPtr& context,
-                                                                        const ExecutorPtr& executor,
-                                                                        const std::string& sql_str,
-                                                                        const InputArgs&... args) {
-  Promise<MysqlResults<OutputArgs...>> pr;
+template <typename Results, typename Fn>
+Future<Results> MysqlServiceProxy::AsyncInvokeWith(const ClientContextPtr& context, const ExecutorPtr& executor,
+                                                   Fn&& fn) {
+  Promise<Results> pr;
   auto fu = pr.GetFuture();
 
   if (CheckTimeout(context)) {
     const Status& result = context->GetStatus();
-    return MakeExceptionFuture<MysqlResults<OutputArgs...>>(
-        CommonException(result.ErrorMessage().c_str(), result.GetFrameworkRetCode()));
+    return MakeExceptionFuture<Results>(CommonException(result.ErrorMessage().c_str(), result.GetFrameworkRetCode()));
   }
 
   int filter_ret = RunFilters(FilterPoint::CLIENT_PRE_SEND_MSG, context);
@@ -407,61 +1216,410 @@ Future<MysqlResults<OutputArgs...>> MysqlServiceProxy::AsyncUnaryInvoke(const Cl
   if (filter_ret != 0) {
     RunFilters(FilterPoint::CLIENT_POST_RECV_MSG, context);
     RunFilters(FilterPoint::CLIENT_POST_RPC_INVOKE, context);
-    return MakeExceptionFuture<MysqlResults<OutputArgs...>>(
-        CommonException(context->GetStatus().ErrorMessage().c_str()));
+    return MakeExceptionFuture<Results>(CommonException(context->GetStatus().ErrorMessage().c_str()));
+  }
+
+  auto snapshot = LoadSnapshot();
+  std::shared_ptr<MysqlQueryLane> lane = GetQueryLane(*snapshot, context);
+  std::shared_ptr<MysqlExecutorPool> pool =
+      executor == nullptr ? snapshot->pool_manager->GetShared(context->GetNodeAddr()) : nullptr;
+  if (!AcquireConcurrency(lane.get(), pool.get(), context)) {
+    ProxyStatistics(context);
+    RunFilters(FilterPoint::CLIENT_POST_RECV_MSG, context);
+    const Status& result = context->GetStatus();
+    return MakeExceptionFuture<Results>(CommonException(result.ErrorMessage().c_str(), result.GetFrameworkRetCode()));
+  }
+
+  uint64_t begin_us = trpc::GetSteadyMicroSeconds();
+  uint64_t deadline_ms = GetCallDeadline(snapshot->conf, context);
+  bool read_your_writes = snapshot->conf.read_your_writes;
+  std::shared_ptr<MysqlCallTimeline> timeline;
+  if (snapshot->conf.call_timeline) {
+    timeline = std::make_shared<MysqlCallTimeline>();
+    timeline->posted_us = begin_us;
+  }
+  bool posted = PostBlockingTask(
+      [p = std::move(pr), this, executor, lane, pool, context, fn = std::forward<Fn>(fn), begin_us, deadline_ms,
+       read_your_writes, timeline]() mutable {
+        Results res;
+        MarkTimeline(timeline.get(), &MysqlCallTimeline::started_us);
+        ExecutorPtr conn = pool != nullptr ? pool->GetExecutor() : executor;
+        MarkTimeline(timeline.get(), &MysqlCallTimeline::acquired_us);
+
+        if (TRPC_UNLIKELY(!conn->IsConnected())) {
+          ReleaseConcurrency(lane.get(), pool.get(), 0, false);
+          std::string error_message = util::FormatString("service name:{}, connection failed. {}.", GetServiceName(),
+                                                         conn->GetErrorMessage());
+          TRPC_LOG_ERROR(error_message);
+          Status status;
+          status.SetFrameworkRetCode(conn->GetErrorNumber());
+          status.SetErrorMessage(error_message);
+
+          context->SetStatus(status);
+          p.SetException(CommonException(status.ErrorMessage().c_str()));
+          return;
+        }
+
+        if (timeline != nullptr) conn->SetCallPhases(&timeline->statements);
+        bool deadline_exceeded = RunWithDeadline(conn, deadline_ms, res, fn);
+        if (timeline != nullptr) conn->SetCallPhases(nullptr);
+        if (read_your_writes) SaveSessionGtid(context, conn);
+
+        if (pool != nullptr) pool->Reclaim(0, std::move(conn));
+        MarkTimeline(timeline.get(), &MysqlCallTimeline::finished_us);
+        ReleaseConcurrency(lane.get(), pool.get(), begin_us, deadline_exceeded);
+
+        ProxyStatistics(context);
+
+        if (deadline_exceeded) {
+          Status status = DeadlineExceededStatus();
+          context->SetStatus(status);
+          p.SetException(CommonException(status.ErrorMessage().c_str(), status.GetFrameworkRetCode()));
+        } else if (res.OK())
+          p.SetValue(std::move(res));
+        else
+          p.SetException(CommonException(res.GetErrorMessage().c_str()));
+      },
+      lane.get());
+
+  if (TRPC_UNLIKELY(!posted)) {
+    ReleaseConcurrency(lane.get(), pool.get(), 0, false);
+    Status status(TrpcRetCode::TRPC_CLIENT_OVERLOAD_ERR, "Failed to post the mysql task.");
+    context->SetStatus(status);
+    RunFilters(FilterPoint::CLIENT_POST_RECV_MSG, context);
+    return MakeExceptionFuture<Results>(CommonException(status.ErrorMessage().c_str()));
   }
 
-  thread_pool_->AddTask([p = std::move(pr), this, executor, context, sql_str, args...]() mutable {
-    MysqlResults<OutputArgs...> res;
+  return fu.Then([context, this, timeline](Future<Results>&& fu) {
+    if (timeline != nullptr) {
+      MarkTimeline(timeline.get(), &MysqlCallTimeline::resumed_us);
+      MutableMysqlContextData(context)->timeline = *timeline;
+    }
+    if (fu.IsFailed()) {
+      RunFilters(FilterPoint::CLIENT_POST_RECV_MSG, context);
+      return MakeExceptionFuture<Results>(fu.GetException());
+    }
+    auto mysql_res = fu.GetValue0();
+    RunFilters(FilterPoint::CLIENT_POST_RECV_MSG, context);
+    return MakeReadyFuture<Results>(std::move(mysql_res));
+  });
+}
+
+template <typename Results, typename Fn>
+bool MysqlServiceProxy::RunWithDeadline(const ExecutorPtr& conn, uint64_t deadline_ms, Results& res, Fn&& fn) {
+  if (deadline_ms == 0 || timer_ == nullptr) {
+    fn(conn, res);
+    return false;
+  }
+
+  // Waited in the queue until the deadline.
+  uint64_t now = trpc::GetSteadyMilliSeconds();
+  if (now >= deadline_ms) return true;
+
+  auto guard = std::make_shared<KillGuard>();
+  NodeAddr node_addr;
+  node_addr.ip = conn->GetIp();
+  node_addr.port = conn->GetPort();
+  unsigned long thread_id = conn->GetThreadId();
+  uint64_t timer_id = timer_->Add(deadline_ms - now, [this, guard, node_addr, thread_id]() {
+    PostKillQuery(guard, node_addr, thread_id);
+  });
+
+  conn->SetDeadline(deadline_ms);
+  fn(conn, res);
+  conn->SetDeadline(0);
+
+  if (!FinishKillable(*guard)) {
+    if (timer_id != 0) timer_->Cancel(timer_id);
+    return trpc::GetSteadyMilliSeconds() >= deadline_ms && !res.OK();
+  }
+
+  deadline_kills_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+template <typename Results>
+struct MysqlServiceProxy::HedgeCall {
+  struct Attempt {
     NodeAddr node_addr;
 
-    MysqlExecutorPool* pool{nullptr};
-    ExecutorPtr conn{nullptr};
+    /// Index of the replica, -1 if the node is not a replica.
+    int replica{-1};
 
-    if (executor == nullptr) {
-      node_addr = context->GetNodeAddr();
-      pool = this->pool_manager_->Get(node_addr);
-      conn = pool->GetExecutor();
-    } else
-      conn = executor;
+    /// The query has been posted and may still win.
+    bool started{false};
 
-    if (TRPC_UNLIKELY(!conn->IsConnected())) {
-      std::string error_message =
-          util::FormatString("service name:{}, connection failed. {}.", GetServiceName(), conn->GetErrorMessage());
-      TRPC_LOG_ERROR(error_message);
-      Status status;
-      status.SetFrameworkRetCode(conn->GetErrorNumber());
-      status.SetErrorMessage(error_message);
+    /// The statement is running on the connection `thread_id`.
+    bool running{false};
 
-      context->SetStatus(status);
-      p.SetException(CommonException(status.ErrorMessage().c_str()));
-      return;
-    }
+    /// The query has failed, its outcome is below.
+    bool failed{false};
+
+    unsigned long thread_id{0};
+
+    /// Whether the statement ran, i.e. `results` holds its outcome. Otherwise the call fails with `status`.
+    bool ran{false};
+
+    Status status;
+
+    Results results;
+  };
 
-    if constexpr (MysqlResults<OutputArgs...>::mode == MysqlResultsMode::OnlyExec)
-      conn->Execute(res, sql_str, args...);
-    else
-      conn->QueryAll(res, sql_str, args...);
+  Function<void(const ExecutorPtr&, Results&)> fn;
 
-    if (pool != nullptr) pool->Reclaim(0, std::move(conn));
+  ClientContextPtr context;
+
+  std::shared_ptr<MysqlReplicaRouter> router;
+
+  std::shared_ptr<HedgePolicy> hedge;
+
+  std::shared_ptr<MysqlExecutorPoolManager> pool_manager;
+
+  /// Query class of the read, nullptr for the default one.
+  std::shared_ptr<MysqlQueryLane> lane;
+
+  Promise<Results> promise;
+
+  std::mutex mutex;
+
+  /// Set once the call is completed, by the first successful query or the last failed one.
+  bool done{false};
+
+  /// The KILL QUERY of the losing query, which keeps its connection until it has been sent.
+  std::shared_ptr<KillGuard> kill{std::make_shared<KillGuard>()};
+
+  uint64_t timer_id{0};
+
+  uint64_t deadline_ms{0};
+
+  Attempt attempts[2];
+};
+
+template <typename Results, typename Fn>
+Future<Results> MysqlServiceProxy::HedgedInvoke(const ClientContextPtr& context, const SnapshotPtr& snapshot,
+                                                int replica, Fn&& fn) {
+  const auto& router = snapshot->router;
+  const auto& hedge = snapshot->hedge;
+  if (CheckTimeout(context)) {
+    if (replica >= 0) router->ReleaseReplica(replica);
+    const Status& result = context->GetStatus();
+    return MakeExceptionFuture<Results>(CommonException(result.ErrorMessage().c_str(), result.GetFrameworkRetCode()));
+  }
+
+  int filter_ret = RunFilters(FilterPoint::CLIENT_PRE_SEND_MSG, context);
+
+  if (filter_ret != 0) {
+    if (replica >= 0) router->ReleaseReplica(replica);
+    RunFilters(FilterPoint::CLIENT_POST_RECV_MSG, context);
+    return MakeExceptionFuture<Results>(CommonException(context->GetStatus().ErrorMessage().c_str()));
+  }
 
+  std::shared_ptr<MysqlQueryLane> lane = GetQueryLane(*snapshot, context);
+  std::shared_ptr<MysqlExecutorPool> pool = snapshot->pool_manager->GetShared(context->GetNodeAddr());
+  if (!AcquireConcurrency(lane.get(), pool.get(), context)) {
+    if (replica >= 0) router->ReleaseReplica(replica);
     ProxyStatistics(context);
+    RunFilters(FilterPoint::CLIENT_POST_RECV_MSG, context);
+    const Status& result = context->GetStatus();
+    return MakeExceptionFuture<Results>(CommonException(result.ErrorMessage().c_str(), result.GetFrameworkRetCode()));
+  }
 
-    if (res.OK())
-      p.SetValue(std::move(res));
-    else
-      p.SetException(CommonException(res.GetErrorMessage().c_str()));
-  });
+  auto call = std::make_shared<HedgeCall<Results>>();
+  call->fn = std::forward<Fn>(fn);
+  call->context = context;
+  call->router = router;
+  call->hedge = hedge;
+  call->pool_manager = snapshot->pool_manager;
+  call->lane = lane;
+  call->attempts[0].node_addr = context->GetNodeAddr();
+  call->attempts[0].replica = replica;
+  call->attempts[0].started = true;
+  call->deadline_ms = GetCallDeadline(snapshot->conf, context);
+  auto fu = call->promise.GetFuture();
+
+  if (TRPC_UNLIKELY(!PostBlockingTask([this, call]() { RunHedgeAttempt(call, 0); }, lane.get()))) {
+    if (replica >= 0) router->ReleaseReplica(replica);
+    ReleaseConcurrency(lane.get(), pool.get(), 0, false);
+    Status status(TrpcRetCode::TRPC_CLIENT_OVERLOAD_ERR, "Failed to post the mysql task.");
+    context->SetStatus(status);
+    RunFilters(FilterPoint::CLIENT_POST_RECV_MSG, context);
+    return MakeExceptionFuture<Results>(CommonException(status.ErrorMessage().c_str()));
+  }
+  // Counted once the read is started, a rejected read must not earn hedging budget.
+  hedge->OnRead();
+
+  uint64_t delay = hedge->GetDelay();
+  if (delay > 0) {
+    uint64_t timer_id = timer_->Add(delay, [this, call]() { StartHedge(call); });
+    std::scoped_lock _(call->mutex);
+    call->timer_id = timer_id;
+  }
 
-  return fu.Then([context, this](Future<MysqlResults<OutputArgs...>>&& fu) {
-    if (fu.IsFailed()) {
-      RunFilters(FilterPoint::CLIENT_POST_RECV_MSG, context);
-      return MakeExceptionFuture<MysqlResults<OutputArgs...>>(fu.GetException());
-    }
-    auto mysql_res = fu.GetValue0();
+  return fu.Then([context, this](Future<Results>&& fu) {
     RunFilters(FilterPoint::CLIENT_POST_RECV_MSG, context);
-    return MakeReadyFuture<MysqlResults<OutputArgs...>>(std::move(mysql_res));
+    return std::move(fu);
   });
 }
 
+template <typename Results, typename Fn>
+void MysqlServiceProxy::HedgedInvokeWait(const ClientContextPtr& context, const SnapshotPtr& snapshot, int replica,
+                                         Results& res, Fn&& fn) {
+  auto fu = HedgedInvoke<Results>(context, snapshot, replica, std::forward<Fn>(fn));
+  auto done = IsRunningInFiberWorker() ? fiber::BlockingGet(std::move(fu)) : future::BlockingGet(std::move(fu));
+  // The status of a failure is already in the context.
+  if (!done.IsFailed()) res = done.GetValue0();
+}
+
+template <typename Results>
+void MysqlServiceProxy::StartHedge(const std::shared_ptr<HedgeCall<Results>>& call) {
+  {
+    std::scoped_lock _(call->mutex);
+    if (call->done) return;
+  }
+
+  NodeAddr node_addr;
+  int replica = -1;
+  const auto& first = call->attempts[0];
+  if (first.replica >= 0 && call->router->GetReplicaCount() > 1) {
+    replica = static_cast<int>(call->router->AcquireReplica(node_addr, first.replica));
+  } else if (!SelectHedgeTarget(first.node_addr, node_addr)) {
+    return;
+  }
+
+  // No hedge to a node at its concurrency limit, it would only add to the overload.
+  std::shared_ptr<MysqlExecutorPool> pool = call->pool_manager->GetShared(node_addr);
+  if (!AcquireConcurrency(call->lane.get(), pool.get(), nullptr)) {
+    if (replica >= 0) call->router->ReleaseReplica(replica);
+    return;
+  }
+
+  bool started = false;
+  {
+    std::scoped_lock _(call->mutex);
+    // The first query may have failed meanwhile, which completes the call as no hedge was started.
+    if (!call->done && call->hedge->TryHedge()) {
+      call->attempts[1].node_addr = node_addr;
+      call->attempts[1].replica = replica;
+      call->attempts[1].started = started = true;
+    }
+  }
+  if (!started) {
+    if (replica >= 0) call->router->ReleaseReplica(replica);
+    ReleaseConcurrency(call->lane.get(), pool.get(), 0, false);
+    return;
+  }
+
+  TRPC_FMT_DEBUG("service name:{}, hedge the read on {}:{} to {}:{}.", GetServiceName(), first.node_addr.ip,
+                 first.node_addr.port, node_addr.ip, node_addr.port);
+  if (PostBlockingTask([this, call]() { RunHedgeAttempt(call, 1); }, call->lane.get())) return;
+
+  if (replica >= 0) call->router->ReleaseReplica(replica);
+  ReleaseConcurrency(call->lane.get(), pool.get(), 0, false);
+
+  // The first query may have failed while waiting for this one.
+  bool finish = false;
+  {
+    std::scoped_lock _(call->mutex);
+    call->attempts[1].started = false;
+    finish = !call->done && call->attempts[0].failed;
+    if (finish) call->done = true;
+  }
+  if (finish) FinishHedgedCall(call, 0);
+}
+
+template <typename Results>
+void MysqlServiceProxy::RunHedgeAttempt(const std::shared_ptr<HedgeCall<Results>>& call, int index) {
+  auto& attempt = call->attempts[index];
+  auto& other = call->attempts[1 - index];
+  uint64_t begin_us = trpc::GetSteadyMicroSeconds();
+
+  std::shared_ptr<MysqlExecutorPool> pool = call->pool_manager->GetShared(attempt.node_addr);
+  ExecutorPtr conn = pool->GetExecutor();
+  bool connected = conn->IsConnected();
+
+  Results res;
+  bool skipped = false;
+  bool deadline_exceeded = false;
+  if (connected) {
+    {
+      std::scoped_lock _(call->mutex);
+      skipped = call->done;
+      attempt.running = !skipped;
+      attempt.thread_id = conn->GetThreadId();
+    }
+    if (!skipped) deadline_exceeded = RunWithDeadline(conn, call->deadline_ms, res, call->fn);
+  }
+  bool ok = connected && !deadline_exceeded && res.OK();
+
+  bool win = false;
+  bool lost = false;
+  bool finish_failed = false;
+  bool kill = false;
+  unsigned long kill_thread_id = 0;
+  uint64_t timer_id = 0;
+  if (!skipped) {
+    std::scoped_lock _(call->mutex);
+    attempt.running = false;
+    lost = call->done;
+    if (!lost && ok) {
+      win = call->done = true;
+      kill = other.running;
+      kill_thread_id = other.thread_id;
+    } else if (!lost) {
+      // Failed, the call waits for the other query unless it has failed too or will not run.
+      attempt.failed = true;
+      attempt.ran = connected && !deadline_exceeded;
+      if (!connected) {
+        attempt.status.SetFrameworkRetCode(conn->GetErrorNumber());
+        attempt.status.SetErrorMessage(util::FormatString("service name:{}, connection failed. {}.",
+                                                          GetServiceName(), conn->GetErrorMessage()));
+      } else if (deadline_exceeded) {
+        attempt.status = DeadlineExceededStatus();
+      } else {
+        attempt.status.SetFrameworkRetCode(res.GetErrorNumber());
+        attempt.status.SetErrorMessage(res.GetErrorMessage());
+        attempt.results = std::move(res);
+      }
+      finish_failed = !other.started || other.failed;
+      if (finish_failed) call->done = true;
+    }
+    if (call->done) timer_id = call->timer_id;
+  }
+
+  if (index == 0 && connected && !skipped) call->hedge->RecordLatency(trpc::GetSteadyMicroSeconds() - begin_us);
+  if (timer_id != 0) timer_->Cancel(timer_id);
+
+  if (win) {
+    if (index == 1) call->hedge->CountHedgeWin();
+    ProxyStatistics(call->context);
+    call->promise.SetValue(std::move(res));
+    if (kill) PostKillQuery(call->kill, other.node_addr, kill_thread_id);
+  } else if (finish_failed) {
+    // Both failed, the failure of the first query is reported.
+    FinishHedgedCall(call, call->attempts[0].failed ? 0 : index);
+  } else if (lost && FinishKillable(*call->kill)) {
+    call->hedge->CountKill();
+  }
+
+  if (attempt.replica >= 0) call->router->ReleaseReplica(attempt.replica);
+  if (connected) pool->Reclaim(0, std::move(conn));
+  ReleaseConcurrency(call->lane.get(), pool.get(), connected && !skipped ? begin_us : 0, deadline_exceeded);
+}
+
+template <typename Results>
+void MysqlServiceProxy::FinishHedgedCall(const std::shared_ptr<HedgeCall<Results>>& call, int index) {
+  auto& attempt = call->attempts[index];
+  const ClientContextPtr& context = call->context;
+  ProxyStatistics(context);
+  if (!attempt.ran) TRPC_LOG_ERROR(attempt.status.ErrorMessage());
+
+  context->SetStatus(attempt.status);
+  if (attempt.ran) {
+    call->promise.SetValue(std::move(attempt.results));
+  } else {
+    call->promise.SetException(
+        CommonException(attempt.status.ErrorMessage().c_str(), attempt.status.GetFrameworkRetCode()));
+  }
+}
+
 }  // namespace trpc::mysql
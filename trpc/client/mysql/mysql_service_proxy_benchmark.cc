@@ -0,0 +1,159 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+// Compares the "thread_pool" and "fiber" execute modes of MysqlServiceProxy.
+// Needs the same MySQL server as mysql_service_proxy_test (127.0.0.1:3306, database "test").
+// The argument of each benchmark is the number of concurrent calls issued from fibers per iteration.
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "trpc/client/make_client_context.h"
+#include "trpc/client/service_proxy_option_setter.h"
+#include "trpc/common/trpc_plugin.h"
+#include "trpc/coroutine/fiber.h"
+#include "trpc/coroutine/fiber_latch.h"
+#include "trpc/coroutine/future.h"
+#include "trpc/coroutine/testing/fiber_runtime.h"
+#include "trpc/future/future_utility.h"
+
+#include "trpc/client/mysql/mysql_plugin.h"
+
+namespace trpc::testing {
+
+class BenchmarkMysqlServiceProxy : public mysql::MysqlServiceProxy {
+ public:
+  void Init(const std::shared_ptr<ServiceProxyOption>& option, const mysql::MysqlClientConf& mysql_conf) {
+    SetServiceProxyOptionInner(option);
+    SetMysqlConfig(mysql_conf);
+  }
+};
+
+using BenchmarkProxyPtr = std::shared_ptr<BenchmarkMysqlServiceProxy>;
+
+BenchmarkProxyPtr thread_pool_proxy;
+BenchmarkProxyPtr fiber_proxy;
+
+BenchmarkProxyPtr MakeProxy(const std::string& execute_mode) {
+  auto option = std::make_shared<ServiceProxyOption>();
+  trpc::detail::SetDefaultOption(option);
+  option->name = "mysql_benchmark_" + execute_mode;
+  option->codec_name = "mysql";
+  option->conn_type = "long";
+  option->network = "tcp";
+  option->timeout = 3000;
+  option->target = "localhost:3306";
+  option->selector_name = "direct";
+  option->max_conn_num = 64;
+
+  mysql::MysqlClientConf mysql_conf;
+  mysql_conf.dbname = "test";
+  mysql_conf.password = "abc123";
+  mysql_conf.user_name = "root";
+  mysql_conf.thread_num = 8;
+  mysql_conf.execute_mode = execute_mode;
+  // The only scheduling group of the runtime, the calls run directly in the calling fibers.
+  if (execute_mode == "fiber") mysql_conf.fiber_scheduling_group = 0;
+
+  auto proxy = std::make_shared<BenchmarkMysqlServiceProxy>();
+  proxy->Init(option, mysql_conf);
+  return proxy;
+}
+
+ClientContextPtr MakeContext(const BenchmarkProxyPtr& proxy) {
+  auto ctx = MakeClientContext(proxy);
+  ctx->SetTimeout(3000);
+  ctx->SetAddr("127.0.0.1", 3306);
+  return ctx;
+}
+
+void RunQuery(benchmark::State& state, const BenchmarkProxyPtr& proxy) {
+  const std::size_t concurrency = state.range(0);
+  std::atomic<std::size_t> failed{0};
+  for (auto _ : state) {
+    FiberLatch latch(concurrency);
+    for (std::size_t i = 0; i < concurrency; ++i) {
+      StartFiberDetached([&proxy, &latch, &failed]() {
+        mysql::MysqlResults<int> res;
+        if (!proxy->Query(MakeContext(proxy), res, "select ?", 1).OK() || !res.OK())
+          failed.fetch_add(1, std::memory_order_relaxed);
+        latch.CountDown();
+      });
+    }
+    latch.Wait();
+  }
+  if (failed.load() > 0) state.SkipWithError("query failed");
+  state.SetItemsProcessed(state.iterations() * concurrency);
+}
+
+void RunAsyncQuery(benchmark::State& state, const BenchmarkProxyPtr& proxy) {
+  const std::size_t concurrency = state.range(0);
+  for (auto _ : state) {
+    std::vector<Future<mysql::MysqlResults<int>>> futures;
+    futures.reserve(concurrency);
+    for (std::size_t i = 0; i < concurrency; ++i)
+      futures.emplace_back(proxy->AsyncQuery<int>(MakeContext(proxy), "select ?", 1));
+
+    auto results = fiber::BlockingGet(WhenAll(futures.begin(), futures.end()));
+    for (auto& result : results.GetValue0())
+      if (result.IsFailed()) state.SkipWithError("async query failed");
+  }
+  state.SetItemsProcessed(state.iterations() * concurrency);
+}
+
+void BM_QueryThreadPool(benchmark::State& state) { RunQuery(state, thread_pool_proxy); }
+
+void BM_QueryFiber(benchmark::State& state) { RunQuery(state, fiber_proxy); }
+
+void BM_AsyncQueryThreadPool(benchmark::State& state) { RunAsyncQuery(state, thread_pool_proxy); }
+
+void BM_AsyncQueryFiber(benchmark::State& state) { RunAsyncQuery(state, fiber_proxy); }
+
+BENCHMARK(BM_QueryThreadPool)->RangeMultiplier(4)->Range(1, 64)->UseRealTime();
+BENCHMARK(BM_QueryFiber)->RangeMultiplier(4)->Range(1, 64)->UseRealTime();
+BENCHMARK(BM_AsyncQueryThreadPool)->RangeMultiplier(4)->Range(1, 64)->UseRealTime();
+BENCHMARK(BM_AsyncQueryFiber)->RangeMultiplier(4)->Range(1, 64)->UseRealTime();
+
+}  // namespace trpc::testing
+
+int main(int argc, char** argv) {
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+
+  ::trpc::mysql::InitPlugin();
+  ::trpc::TrpcPlugin::GetInstance()->RegisterPlugins();
+
+  ::trpc::testing::RunAsFiber([] {
+    using ::trpc::testing::fiber_proxy;
+    using ::trpc::testing::thread_pool_proxy;
+
+    thread_pool_proxy = ::trpc::testing::MakeProxy("thread_pool");
+    fiber_proxy = ::trpc::testing::MakeProxy("fiber");
+
+    ::benchmark::RunSpecifiedBenchmarks();
+
+    for (auto& proxy : {thread_pool_proxy, fiber_proxy}) {
+      proxy->Stop();
+      proxy->Destroy();
+    }
+    thread_pool_proxy = nullptr;
+    fiber_proxy = nullptr;
+  });
+
+  ::trpc::TrpcPlugin::GetInstance()->UnregisterPlugins();
+  return 0;
+}
@@ -20,6 +20,7 @@
 #include "trpc/future/future_utility.h"
 
 #include "trpc/client/mysql/mysql_plugin.h"
+#include "trpc/client/mysql/savepoint_scope.h"
 
 namespace trpc::testing {
 
@@ -621,6 +622,179 @@ TEST_F(MysqlServiceProxyTest, TxConcurrency) {
   EXPECT_EQ(exec_res.OK(), true);
 }
 
+TEST_F(MysqlServiceProxyTest, RunInTransactionDeadlockRetry) {
+  // Two transactions update the same rows in opposite orders, so one of them is chosen as the deadlock victim.
+  auto update_in_order = [this](const std::string& first, const std::string& second) {
+    auto client_context = GetClientContext();
+    bool first_attempt = true;
+    return mock_mysql_service_proxy_->RunInTransaction(client_context, [&](const TxHandlePtr& handle) {
+      MysqlResults<OnlyExec> exec_res;
+      Status s = mock_mysql_service_proxy_->Execute(client_context, handle, exec_res,
+                                                    "update users set meta = NULL where username = ?", first);
+      if (!s.OK()) return s;
+      if (first_attempt) std::this_thread::sleep_for(std::chrono::milliseconds(200));
+      first_attempt = false;
+      return mock_mysql_service_proxy_->Execute(client_context, handle, exec_res,
+                                                "update users set meta = NULL where username = ?", second);
+    });
+  };
+
+  Status s1, s2;
+  std::thread t1([&]() { s1 = update_in_order("alice", "bob"); });
+  std::thread t2([&]() { s2 = update_in_order("bob", "alice"); });
+  t1.join();
+  t2.join();
+
+  EXPECT_EQ(s1.OK(), true);
+  EXPECT_EQ(s2.OK(), true);
+
+  auto stats = mock_mysql_service_proxy_->GetTransactionRetryStats();
+  EXPECT_EQ(stats.transactions, 2);
+  EXPECT_GE(stats.deadlock_retries, 1);
+  EXPECT_EQ(stats.exhausted, 0);
+}
+
+TEST_F(MysqlServiceProxyTest, Savepoint) {
+  auto client_context = GetClientContext();
+  TxHandlePtr handle{nullptr};
+  MysqlResults<OnlyExec> exec_res;
+  MysqlResults<NativeString> query_res;
+
+  ASSERT_EQ(mock_mysql_service_proxy_->Begin(client_context, handle).OK(), true);
+  mock_mysql_service_proxy_->Execute(client_context, handle, exec_res,
+                                     "update users set email = ? where username = ?", "rose@a.com", "rose");
+  EXPECT_EQ(mock_mysql_service_proxy_->Savepoint(client_context, handle, "sp1").OK(), true);
+  mock_mysql_service_proxy_->Execute(client_context, handle, exec_res,
+                                     "update users set email = ? where username = ?", "rose@b.com", "rose");
+  EXPECT_EQ(mock_mysql_service_proxy_->Savepoint(client_context, handle, "sp2").OK(), true);
+  EXPECT_EQ(handle->GetSavepoints().size(), 2);
+
+  EXPECT_EQ(mock_mysql_service_proxy_->RollbackTo(client_context, handle, "sp1").OK(), true);
+  EXPECT_EQ(handle->GetSavepoints(), std::vector<std::string>{"sp1"});
+  mock_mysql_service_proxy_->Query(client_context, handle, query_res, "select email from users where username = ?",
+                                   "rose");
+  EXPECT_EQ(query_res.ResultSet()[0][0], "rose@a.com");
+
+  EXPECT_EQ(mock_mysql_service_proxy_->Release(client_context, handle, "sp1").OK(), true);
+  EXPECT_EQ(handle->GetSavepoints().empty(), true);
+  EXPECT_EQ(mock_mysql_service_proxy_->RollbackTo(client_context, handle, "sp1").GetFrameworkRetCode(),
+            mysql::TrpcMysqlRetCode::TRPC_MYSQL_INVALID_SAVEPOINT);
+
+  client_context = GetClientContext();
+  {
+    // Not released, the scope is rolled back.
+    mysql::SavepointScope scope(mock_mysql_service_proxy_.get(), client_context, handle);
+    EXPECT_EQ(scope.GetStatus().OK(), true);
+    mock_mysql_service_proxy_->Execute(client_context, handle, exec_res,
+                                       "update users set email = ? where username = ?", "rose@c.com", "rose");
+    {
+      mysql::SavepointScope inner_scope(mock_mysql_service_proxy_.get(), client_context, handle);
+      EXPECT_EQ(handle->GetSavepoints().size(), 2);
+      EXPECT_EQ(inner_scope.Release().OK(), true);
+    }
+  }
+  EXPECT_EQ(handle->GetSavepoints().empty(), true);
+  mock_mysql_service_proxy_->Query(client_context, handle, query_res, "select email from users where username = ?",
+                                   "rose");
+  EXPECT_EQ(query_res.ResultSet()[0][0], "rose@a.com");
+
+  EXPECT_EQ(mock_mysql_service_proxy_->Rollback(client_context, handle).OK(), true);
+}
+
+TEST_F(MysqlServiceProxyTest, TransactionIdleTimeout) {
+  mysql::MysqlClientConf mysql_conf;
+  mysql_conf.dbname = "test";
+  mysql_conf.password = "abc123";
+  mysql_conf.user_name = "root";
+  mysql_conf.tx_idle_timeout = 100;
+  mock_mysql_service_proxy_->SetMysqlConfig(mysql_conf);
+
+  auto client_context = GetClientContext();
+  TxHandlePtr handle{nullptr};
+  MysqlResults<OnlyExec> exec_res;
+  ASSERT_EQ(mock_mysql_service_proxy_->Begin(client_context, handle).OK(), true);
+  mock_mysql_service_proxy_->Execute(client_context, handle, exec_res,
+                                     "update users set email = ? where username = ?", "rose@idle.com", "rose");
+
+  // Idle for longer than tx_idle_timeout, the watchdog rolls the transaction back.
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  EXPECT_EQ(handle->GetState(), TransactionHandle::TxState::kInValid);
+  EXPECT_EQ(handle->GetExecutor(), nullptr);
+  EXPECT_EQ(mock_mysql_service_proxy_->GetTransactionWatchdogStats().idle_rollbacks, 1);
+
+  client_context = GetClientContext();
+  EXPECT_EQ(mock_mysql_service_proxy_->Commit(client_context, handle).GetFrameworkRetCode(),
+            mysql::TrpcMysqlRetCode::TRPC_MYSQL_INVALID_HANDLE);
+
+  MysqlResults<NativeString> query_res;
+  client_context = GetClientContext();
+  mock_mysql_service_proxy_->Query(client_context, query_res, "select email from users where username = ?", "rose");
+  ASSERT_EQ(query_res.OK(), true);
+  EXPECT_NE(query_res.ResultSet()[0][0], "rose@idle.com");
+}
+
+TEST_F(MysqlServiceProxyTest, ReadYourWrites) {
+  // The server is its own replica here, so every GTID has been applied when the read waits for it.
+  mysql::MysqlClientConf mysql_conf;
+  mysql_conf.dbname = "test";
+  mysql_conf.password = "abc123";
+  mysql_conf.user_name = "root";
+  mysql_conf.primary = "127.0.0.1:3306";
+  mysql_conf.replicas = {"127.0.0.1:3306"};
+  mysql_conf.read_your_writes = true;
+  mock_mysql_service_proxy_->SetMysqlConfig(mysql_conf);
+
+  auto client_context = GetClientContext();
+  MysqlResults<OnlyExec> exec_res;
+  mock_mysql_service_proxy_->Execute(client_context, exec_res, "update users set email = ? where username = ?",
+                                     "rose@gtid.com", "rose");
+  ASSERT_EQ(exec_res.OK(), true);
+
+  // The GTID is only tracked with gtid_mode=ON.
+  std::string gtid = mysql::GetMysqlGtid(client_context);
+  MysqlResults<NativeString> query_res;
+  mock_mysql_service_proxy_->Query(client_context, query_res, "select email from users where username = ?", "rose");
+  ASSERT_EQ(query_res.OK(), true);
+  EXPECT_EQ(query_res.ResultSet()[0][0], "rose@gtid.com");
+
+  auto stats = mock_mysql_service_proxy_->GetReplicaReadStats();
+  EXPECT_EQ(stats.gtid_waits, gtid.empty() ? 0 : 1);
+  EXPECT_EQ(stats.gtid_fallbacks, 0);
+}
+
+TEST_F(MysqlServiceProxyTest, ReloadConfig) {
+  auto client_context = GetClientContext();
+  TxHandlePtr handle{nullptr};
+  ASSERT_EQ(mock_mysql_service_proxy_->Begin(client_context, handle).OK(), true);
+
+  // Same thread_bind_core as SetUp, so the thread pool is resized and the pools are kept.
+  mysql::MysqlClientConf mysql_conf;
+  mysql_conf.dbname = "test";
+  mysql_conf.password = "abc123";
+  mysql_conf.user_name = "root";
+  mysql_conf.thread_num = 2;
+  mysql_conf.thread_bind_core = "1, 2-4";
+  mysql_conf.char_set = "latin1";
+  mock_mysql_service_proxy_->SetMysqlConfig(mysql_conf);
+
+  // The transaction keeps its connection, with the old settings, until it ends.
+  MysqlResults<NativeString> res;
+  client_context = GetClientContext();
+  mock_mysql_service_proxy_->Query(client_context, handle, res, "select @@character_set_client");
+  ASSERT_EQ(res.OK(), true);
+  EXPECT_EQ(res.ResultSet()[0][0], "utf8mb4");
+  client_context = GetClientContext();
+  EXPECT_EQ(mock_mysql_service_proxy_->Commit(client_context, handle).OK(), true);
+
+  // Its connection is closed when returned rather than pooled, the next ones use the new settings.
+  for (int i = 0; i < 4; ++i) {
+    client_context = GetClientContext();
+    mock_mysql_service_proxy_->Query(client_context, res, "select @@character_set_client");
+    ASSERT_EQ(res.OK(), true);
+    EXPECT_EQ(res.ResultSet()[0][0], "latin1");
+  }
+}
+
 TEST_F(MysqlServiceProxyTest, ConnectionError) {
   auto client_context = GetClientContext();
   client_context->SetAddr("111.111.111.111", 3306);
@@ -633,6 +807,24 @@ TEST_F(MysqlServiceProxyTest, ConnectionError) {
   EXPECT_EQ(fu.IsFailed(), true);
 }
 
+TEST_F(MysqlServiceProxyTest, BeginConnectionError) {
+  auto client_context = GetClientContext();
+  client_context->SetAddr("111.111.111.111", 3306);
+  TxHandlePtr handle{nullptr};
+  Status s = mock_mysql_service_proxy_->Begin(client_context, handle);
+  EXPECT_EQ(s.OK(), false);
+  EXPECT_EQ(handle, nullptr);
+
+  // The connection is acquired in the async pipeline, so the future is not ready yet.
+  auto async_context = GetClientContext();
+  async_context->SetAddr("111.111.111.111", 3306);
+  auto begin_fu = mock_mysql_service_proxy_->AsyncBegin(async_context);
+  EXPECT_EQ(begin_fu.IsReady() || begin_fu.IsFailed(), false);
+
+  auto fu = future::BlockingGet(std::move(begin_fu));
+  EXPECT_EQ(fu.IsFailed(), true);
+}
+
 TEST_F(MysqlServiceProxyTest, SyntaxError) {
   auto client_context = GetClientContext();
   client_context->SetAddr("127.0.0.1", 3306);
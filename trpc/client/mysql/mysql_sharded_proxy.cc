@@ -0,0 +1,67 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#include "trpc/client/mysql/mysql_sharded_proxy.h"
+
+#include <algorithm>
+
+#include "trpc/client/make_client_context.h"
+
+#include "trpc/client/mysql/mysql_context.h"
+#include "trpc/client/mysql/mysql_replica_router.h"
+
+namespace trpc::mysql {
+
+MysqlShardedProxy::MysqlShardedProxy(std::shared_ptr<MysqlServiceProxy> proxy, const std::vector<std::string>& shards,
+                                     std::shared_ptr<const ShardingFunction> sharding)
+    : proxy_(std::move(proxy)), sharding_(std::move(sharding)) {
+  shards_.reserve(shards.size());
+  for (const auto& shard : shards) {
+    NodeAddr node_addr;
+    if (!MysqlReplicaRouter::ParseAddr(shard, node_addr)) TRPC_FMT_ERROR("Invalid mysql shard address: {}.", shard);
+    // An invalid shard is not skipped, it would shift the keys of the following shards.
+    TRPC_ASSERT(!node_addr.ip.empty());
+    shards_.emplace_back(std::move(node_addr));
+  }
+  TRPC_ASSERT(!shards_.empty() && shards_.size() == sharding_->ShardCount());
+  // Read/write splitting would send the calls to its primary and replicas instead of the shards.
+  auto router = proxy_->GetReplicaRouter();
+  if (router->HasPrimary() || router->GetReplicaCount() > 0)
+    TRPC_FMT_ERROR("The proxy of mysql shards must not be configured with a primary or replicas.");
+  TRPC_ASSERT(!router->HasPrimary() && router->GetReplicaCount() == 0);
+}
+
+ClientContextPtr MysqlShardedProxy::MakeShardContext(const ClientContextPtr& context, size_t shard,
+                                                     const ShardScatterOption& option) const {
+  ClientContextPtr shard_context = MakeClientContext(proxy_);
+  uint32_t timeout = context->GetTimeout();
+  if (option.shard_timeout > 0) timeout = std::min(timeout, option.shard_timeout);
+  shard_context->SetTimeout(timeout);
+  shard_context->SetAddr(shards_[shard].ip, shards_[shard].port);
+  shard_context->SetCallerName(context->GetCallerName());
+  const auto& trans_info = context->GetPbReqTransInfo();
+  shard_context->SetReqTransInfo(trans_info.begin(), trans_info.end());
+
+  const MysqlContextData* data = GetMysqlContextData(context);
+  if (data != nullptr) {
+    MysqlContextData copy = *data;
+    copy.timeline = MysqlCallTimeline{};
+    // The statement is the same on every shard, the shards must not share the results of each other.
+    copy.cache = MysqlCacheOption{};
+    copy.singleflight = false;
+    shard_context->SetFilterData(kMysqlContextDataId, std::move(copy));
+  }
+  return shard_context;
+}
+
+}  // namespace trpc::mysql
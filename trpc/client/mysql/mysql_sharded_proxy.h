@@ -0,0 +1,283 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "trpc/coroutine/fiber.h"
+#include "trpc/coroutine/future.h"
+#include "trpc/future/future_utility.h"
+#include "trpc/util/string_util.h"
+
+#include "trpc/client/mysql/mysql_results_merger.h"
+#include "trpc/client/mysql/mysql_service_proxy.h"
+#include "trpc/client/mysql/mysql_sharding.h"
+
+namespace trpc::mysql {
+
+/// @brief Options of a statement run on all shards.
+struct ShardScatterOption {
+  /// Timeout of the statement on each shard in milliseconds, 0 means the timeout of the context.
+  /// It never exceeds the timeout of the context.
+  uint32_t shard_timeout{0};
+
+  /// Keeps at most `limit` rows of the merged result, 0 means no limit.
+  size_t limit{0};
+
+  /// Appends " LIMIT <limit>" to the statement sent to each shard, so that no shard returns more rows than
+  /// the merged result keeps. Only for statements without a LIMIT clause of their own.
+  bool push_down_limit{false};
+
+  /// Returns the rows of the shards which succeeded when some shards fail, instead of failing the call.
+  bool allow_partial{false};
+};
+
+/// @brief Routes the calls of a MysqlServiceProxy to the shard selected by a sharding key, and runs statements on
+/// all shards concurrently (scatter-gather).
+///
+/// Each shard is an "ip:port" address with its own MysqlExecutorPool in the MysqlExecutorPoolManager of the proxy.
+/// The calls routed to a single shard only set the address of the context before the call of the proxy.
+/// @note The proxy must not be configured with read/write splitting (`primary` and `replicas`), which would
+/// override the shard address. The constructor asserts it.
+class MysqlShardedProxy {
+ public:
+  /// @param shards "ip:port" of each shard, in the order of the shard indexes of `sharding`.
+  MysqlShardedProxy(std::shared_ptr<MysqlServiceProxy> proxy, const std::vector<std::string>& shards,
+                    std::shared_ptr<const ShardingFunction> sharding);
+
+  const std::shared_ptr<MysqlServiceProxy>& GetServiceProxy() const { return proxy_; }
+
+  size_t GetShardCount() const { return shards_.size(); }
+
+  size_t GetShard(uint64_t key) const { return sharding_->Shard(key); }
+
+  const NodeAddr& GetShardAddr(size_t shard) const { return shards_[shard]; }
+
+  /// @brief Points `context` at the shard of `key`. Calls of the proxy with the context then run on that shard.
+  void RouteToShard(const ClientContextPtr& context, uint64_t key) const {
+    const NodeAddr& addr = shards_[sharding_->Shard(key)];
+    context->SetAddr(addr.ip, addr.port);
+  }
+
+  /// @brief Same as MysqlServiceProxy::Query, on the shard of `key`.
+  template <typename... OutputArgs, typename... InputArgs>
+  Status Query(const ClientContextPtr& context, uint64_t key, MysqlResults<OutputArgs...>& res,
+               const std::string& sql_str, const InputArgs&... args) {
+    RouteToShard(context, key);
+    return proxy_->Query(context, res, sql_str, args...);
+  }
+
+  template <typename... OutputArgs, typename... InputArgs>
+  Future<MysqlResults<OutputArgs...>> AsyncQuery(const ClientContextPtr& context, uint64_t key,
+                                                 const std::string& sql_str, const InputArgs&... args) {
+    RouteToShard(context, key);
+    return proxy_->AsyncQuery<OutputArgs...>(context, sql_str, args...);
+  }
+
+  template <typename... OutputArgs, typename... InputArgs>
+  Status Execute(const ClientContextPtr& context, uint64_t key, MysqlResults<OutputArgs...>& res,
+                 const std::string& sql_str, const InputArgs&... args) {
+    RouteToShard(context, key);
+    return proxy_->Execute(context, res, sql_str, args...);
+  }
+
+  template <typename... OutputArgs, typename... InputArgs>
+  Future<MysqlResults<OutputArgs...>> AsyncExecute(const ClientContextPtr& context, uint64_t key,
+                                                   const std::string& sql_str, const InputArgs&... args) {
+    RouteToShard(context, key);
+    return proxy_->AsyncExecute<OutputArgs...>(context, sql_str, args...);
+  }
+
+  /// @brief Begins a transaction on the shard of `key`. The handle is then used with the proxy directly.
+  Status Begin(const ClientContextPtr& context, uint64_t key, TxHandlePtr& handle) {
+    RouteToShard(context, key);
+    return proxy_->Begin(context, handle);
+  }
+
+  Future<TxHandlePtr> AsyncBegin(const ClientContextPtr& context, uint64_t key) {
+    RouteToShard(context, key);
+    return proxy_->AsyncBegin(context);
+  }
+
+  /// @brief Runs the statement on all shards concurrently and concatenates the results in shard order.
+  /// The affected rows of OnlyExec results are summed.
+  template <typename... OutputArgs, typename... InputArgs>
+  Status ScatterQuery(const ClientContextPtr& context, const ShardScatterOption& option,
+                      MysqlResults<OutputArgs...>& res, const std::string& sql_str, const InputArgs&... args);
+
+  template <typename... OutputArgs, typename... InputArgs>
+  Future<MysqlResults<OutputArgs...>> AsyncScatterQuery(const ClientContextPtr& context,
+                                                        const ShardScatterOption& option,
+                                                        const std::string& sql_str, const InputArgs&... args);
+
+  /// @brief Runs a statement which returns rows sorted by `less` on all shards concurrently, and merges the rows
+  /// of the shards in that order (k-way merge). With `limit`, the merge stops after `limit` rows.
+  /// @param less bool(const std::tuple<OutputArgs...>&, const std::tuple<OutputArgs...>&), must match the
+  /// ORDER BY clause of the statement.
+  template <typename... OutputArgs, typename Less, typename... InputArgs>
+  Status ScatterMergeQuery(const ClientContextPtr& context, const ShardScatterOption& option, Less&& less,
+                           MysqlResults<OutputArgs...>& res, const std::string& sql_str, const InputArgs&... args);
+
+  template <typename... OutputArgs, typename Less, typename... InputArgs>
+  Future<MysqlResults<OutputArgs...>> AsyncScatterMergeQuery(const ClientContextPtr& context,
+                                                             const ShardScatterOption& option, Less&& less,
+                                                             const std::string& sql_str, const InputArgs&... args);
+
+ private:
+  /// @brief Context of the call on `shard`, with the timeout of the shard and the caller, the transparent info and
+  /// the mysql options of `context`.
+  ClientContextPtr MakeShardContext(const ClientContextPtr& context, size_t shard,
+                                    const ShardScatterOption& option) const;
+
+  /// @brief Runs the statement on one shard, with Execute for OnlyExec results and with Query otherwise.
+  template <typename... OutputArgs, typename... InputArgs>
+  Future<MysqlResults<OutputArgs...>> RunOnShard(const ClientContextPtr& shard_context, const std::string& sql_str,
+                                                 const InputArgs&... args);
+
+  /// @brief Runs `run` on all shards and gathers the results with `merge`, which turns the results of the shards
+  /// which succeeded into one.
+  /// @param run Future<Results>(const ClientContextPtr& shard_context, const std::string& sql_str).
+  template <typename Results, typename Run, typename Merge>
+  Future<Results> Scatter(const ClientContextPtr& context, const ShardScatterOption& option,
+                          const std::string& sql_str, Run&& run, Merge&& merge);
+
+  /// @brief Blocks on the future, sets the results and the status of the context.
+  template <typename Results>
+  static Status Wait(const ClientContextPtr& context, Future<Results>&& fut, Results& res);
+
+ private:
+  std::shared_ptr<MysqlServiceProxy> proxy_;
+
+  std::vector<NodeAddr> shards_;
+
+  std::shared_ptr<const ShardingFunction> sharding_;
+};
+
+template <typename... OutputArgs, typename... InputArgs>
+Future<MysqlResults<OutputArgs...>> MysqlShardedProxy::RunOnShard(const ClientContextPtr& shard_context,
+                                                                  const std::string& sql_str,
+                                                                  const InputArgs&... args) {
+  if constexpr (MysqlResults<OutputArgs...>::mode == MysqlResultsMode::OnlyExec) {
+    return proxy_->AsyncExecute<OutputArgs...>(shard_context, sql_str, args...);
+  } else {
+    return proxy_->AsyncQuery<OutputArgs...>(shard_context, sql_str, args...);
+  }
+}
+
+template <typename Results, typename Run, typename Merge>
+Future<Results> MysqlShardedProxy::Scatter(const ClientContextPtr& context, const ShardScatterOption& option,
+                                           const std::string& sql_str, Run&& run, Merge&& merge) {
+  std::string shard_sql = sql_str;
+  if (option.push_down_limit && option.limit > 0) shard_sql += " LIMIT " + std::to_string(option.limit);
+
+  std::vector<Future<Results>> futures;
+  futures.reserve(shards_.size());
+  for (size_t shard = 0; shard < shards_.size(); ++shard) {
+    futures.emplace_back(run(MakeShardContext(context, shard, option), shard_sql));
+  }
+
+  return WhenAll(futures.begin(), futures.end())
+      .Then([this, allow_partial = option.allow_partial, merge = std::forward<Merge>(merge)](
+                Future<std::vector<Future<Results>>>&& all) mutable {
+        std::vector<Future<Results>> done = all.GetValue0();
+        std::vector<Results> parts;
+        parts.reserve(done.size());
+        std::string error_message;
+        for (size_t shard = 0; shard < done.size(); ++shard) {
+          if (done[shard].IsFailed()) {
+            const NodeAddr& addr = shards_[shard];
+            error_message = util::FormatString("shard {}({}:{}) failed: {}", shard, addr.ip, addr.port,
+                                               done[shard].GetException().what());
+            TRPC_LOG_WARN(error_message);
+            continue;
+          }
+          parts.emplace_back(done[shard].GetValue0());
+        }
+
+        if (!error_message.empty() && (!allow_partial || parts.empty()))
+          return MakeExceptionFuture<Results>(CommonException(error_message.c_str()));
+        return MakeReadyFuture<Results>(merge(parts));
+      });
+}
+
+template <typename Results>
+Status MysqlShardedProxy::Wait(const ClientContextPtr& context, Future<Results>&& fut, Results& res) {
+  auto done = IsRunningInFiberWorker() ? fiber::BlockingGet(std::move(fut)) : future::BlockingGet(std::move(fut));
+  if (done.IsFailed()) {
+    Status status;
+    status.SetFrameworkRetCode(TrpcRetCode::TRPC_INVOKE_UNKNOWN_ERR);
+    status.SetErrorMessage(done.GetException().what());
+    context->SetStatus(std::move(status));
+  } else {
+    res = done.GetValue0();
+    context->SetStatus(Status());
+  }
+  return context->GetStatus();
+}
+
+template <typename... OutputArgs, typename... InputArgs>
+Future<MysqlResults<OutputArgs...>> MysqlShardedProxy::AsyncScatterQuery(const ClientContextPtr& context,
+                                                                         const ShardScatterOption& option,
+                                                                         const std::string& sql_str,
+                                                                         const InputArgs&... args) {
+  using Results = MysqlResults<OutputArgs...>;
+  size_t limit = option.limit;
+  return Scatter<Results>(
+      context, option, sql_str,
+      [&](const ClientContextPtr& shard_context, const std::string& shard_sql) {
+        return RunOnShard<OutputArgs...>(shard_context, shard_sql, args...);
+      },
+      [limit](std::vector<Results>& parts) { return MysqlResultsMerger::Concat(parts, limit); });
+}
+
+template <typename... OutputArgs, typename... InputArgs>
+Status MysqlShardedProxy::ScatterQuery(const ClientContextPtr& context, const ShardScatterOption& option,
+                                       MysqlResults<OutputArgs...>& res, const std::string& sql_str,
+                                       const InputArgs&... args) {
+  return Wait(context, AsyncScatterQuery<OutputArgs...>(context, option, sql_str, args...), res);
+}
+
+template <typename... OutputArgs, typename Less, typename... InputArgs>
+Future<MysqlResults<OutputArgs...>> MysqlShardedProxy::AsyncScatterMergeQuery(const ClientContextPtr& context,
+                                                                              const ShardScatterOption& option,
+                                                                              Less&& less,
+                                                                              const std::string& sql_str,
+                                                                              const InputArgs&... args) {
+  using Results = MysqlResults<OutputArgs...>;
+  size_t limit = option.limit;
+  return Scatter<Results>(
+      context, option, sql_str,
+      [&](const ClientContextPtr& shard_context, const std::string& shard_sql) {
+        return RunOnShard<OutputArgs...>(shard_context, shard_sql, args...);
+      },
+      [limit, less = std::forward<Less>(less)](std::vector<Results>& parts) {
+        return MysqlResultsMerger::Merge(parts, less, limit);
+      });
+}
+
+template <typename... OutputArgs, typename Less, typename... InputArgs>
+Status MysqlShardedProxy::ScatterMergeQuery(const ClientContextPtr& context, const ShardScatterOption& option,
+                                            Less&& less, MysqlResults<OutputArgs...>& res,
+                                            const std::string& sql_str, const InputArgs&... args) {
+  return Wait(context,
+              AsyncScatterMergeQuery<OutputArgs...>(context, option, std::forward<Less>(less), sql_str, args...),
+              res);
+}
+
+}  // namespace trpc::mysql
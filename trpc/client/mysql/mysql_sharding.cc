@@ -0,0 +1,74 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#include "trpc/client/mysql/mysql_sharding.h"
+
+#include <algorithm>
+
+#include "trpc/util/log/logging.h"
+
+namespace trpc::mysql {
+
+namespace {
+
+/// splitmix64 finalizer. Spreads sequential keys and virtual node ids over the ring.
+uint64_t Mix(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+}  // namespace
+
+ModuloSharding::ModuloSharding(size_t shard_count) : shard_count_(shard_count) {
+  TRPC_ASSERT(shard_count_ > 0);
+}
+
+RangeSharding::RangeSharding(std::vector<uint64_t> lower_bounds) : lower_bounds_(std::move(lower_bounds)) {
+  TRPC_ASSERT(!lower_bounds_.empty());
+  TRPC_ASSERT(std::is_sorted(lower_bounds_.begin(), lower_bounds_.end()));
+}
+
+size_t RangeSharding::Shard(uint64_t key) const {
+  auto it = std::upper_bound(lower_bounds_.begin(), lower_bounds_.end(), key);
+  return it == lower_bounds_.begin() ? 0 : static_cast<size_t>(it - lower_bounds_.begin()) - 1;
+}
+
+ConsistentHashSharding::ConsistentHashSharding(size_t shard_count, size_t virtual_nodes) : shard_count_(shard_count) {
+  TRPC_ASSERT(shard_count_ > 0 && virtual_nodes > 0);
+  ring_.reserve(shard_count_ * virtual_nodes);
+  for (size_t shard = 0; shard < shard_count_; ++shard) {
+    for (size_t node = 0; node < virtual_nodes; ++node) {
+      ring_.emplace_back(Mix((static_cast<uint64_t>(shard) << 32) | node), shard);
+    }
+  }
+  std::sort(ring_.begin(), ring_.end());
+}
+
+size_t ConsistentHashSharding::Shard(uint64_t key) const {
+  uint64_t position = Mix(key);
+  auto it = std::lower_bound(ring_.begin(), ring_.end(), std::make_pair(position, size_t{0}));
+  return it == ring_.end() ? ring_.front().second : it->second;
+}
+
+uint64_t HashShardingKey(std::string_view key) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (unsigned char c : key) {
+    hash ^= c;
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+}  // namespace trpc::mysql
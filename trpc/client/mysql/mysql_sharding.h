@@ -0,0 +1,85 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace trpc::mysql {
+
+/// @brief Maps a sharding key to the index of a shard in MysqlShardedProxy.
+/// @note Implementations must be thread safe, `Shard` is called concurrently without locking.
+class ShardingFunction {
+ public:
+  virtual ~ShardingFunction() = default;
+
+  /// @return Index in [0, ShardCount()).
+  virtual size_t Shard(uint64_t key) const = 0;
+
+  virtual size_t ShardCount() const = 0;
+};
+
+/// @brief key % shard_count.
+class ModuloSharding : public ShardingFunction {
+ public:
+  explicit ModuloSharding(size_t shard_count);
+
+  size_t Shard(uint64_t key) const override { return key % shard_count_; }
+
+  size_t ShardCount() const override { return shard_count_; }
+
+ private:
+  size_t shard_count_;
+};
+
+/// @brief Shard `i` holds the keys in [lower_bounds[i], lower_bounds[i + 1]), the last shard holds the keys from
+/// its lower bound up. Keys below lower_bounds[0] go to the first shard.
+class RangeSharding : public ShardingFunction {
+ public:
+  /// @param lower_bounds Ascending lower bound of each shard.
+  explicit RangeSharding(std::vector<uint64_t> lower_bounds);
+
+  size_t Shard(uint64_t key) const override;
+
+  size_t ShardCount() const override { return lower_bounds_.size(); }
+
+ private:
+  std::vector<uint64_t> lower_bounds_;
+};
+
+/// @brief Consistent hashing on a ring with `virtual_nodes` points per shard. Adding a shard only moves about
+/// 1 / shard_count of the keys.
+class ConsistentHashSharding : public ShardingFunction {
+ public:
+  ConsistentHashSharding(size_t shard_count, size_t virtual_nodes = 160);
+
+  size_t Shard(uint64_t key) const override;
+
+  size_t ShardCount() const override { return shard_count_; }
+
+ private:
+  size_t shard_count_;
+
+  /// (position, shard) sorted by position.
+  std::vector<std::pair<uint64_t, size_t>> ring_;
+};
+
+/// @brief Stable 64-bit FNV-1a hash, for string sharding keys. It does not change between processes or builds,
+/// unlike std::hash.
+uint64_t HashShardingKey(std::string_view key);
+
+}  // namespace trpc::mysql
@@ -0,0 +1,132 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#include "trpc/client/mysql/mysql_sharding.h"
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "trpc/client/mysql/mysql_results_merger.h"
+
+namespace trpc::testing {
+
+using namespace trpc::mysql;
+
+TEST(MysqlShardingTest, Modulo) {
+  ModuloSharding sharding(16);
+  EXPECT_EQ(sharding.ShardCount(), 16);
+  EXPECT_EQ(sharding.Shard(0), 0);
+  EXPECT_EQ(sharding.Shard(17), 1);
+  EXPECT_EQ(sharding.Shard(31), 15);
+}
+
+TEST(MysqlShardingTest, Range) {
+  RangeSharding sharding({100, 1000, 5000});
+  EXPECT_EQ(sharding.ShardCount(), 3);
+  EXPECT_EQ(sharding.Shard(0), 0);
+  EXPECT_EQ(sharding.Shard(100), 0);
+  EXPECT_EQ(sharding.Shard(999), 0);
+  EXPECT_EQ(sharding.Shard(1000), 1);
+  EXPECT_EQ(sharding.Shard(4999), 1);
+  EXPECT_EQ(sharding.Shard(5000), 2);
+  EXPECT_EQ(sharding.Shard(UINT64_MAX), 2);
+}
+
+TEST(MysqlShardingTest, ConsistentHash) {
+  ConsistentHashSharding sharding(16);
+  std::vector<size_t> counts(16, 0);
+  for (uint64_t key = 0; key < 16000; ++key) {
+    size_t shard = sharding.Shard(key);
+    ASSERT_LT(shard, 16);
+    EXPECT_EQ(shard, sharding.Shard(key));
+    ++counts[shard];
+  }
+  for (size_t count : counts) {
+    EXPECT_GT(count, 500);
+    EXPECT_LT(count, 1500);
+  }
+
+  // A new shard only takes keys from the others.
+  ConsistentHashSharding grown(17);
+  size_t moved = 0;
+  for (uint64_t key = 0; key < 16000; ++key) {
+    size_t shard = grown.Shard(key);
+    if (shard != sharding.Shard(key)) {
+      EXPECT_EQ(shard, 16);
+      ++moved;
+    }
+  }
+  EXPECT_LT(moved, 16000 / 8);
+}
+
+TEST(MysqlShardingTest, HashShardingKey) {
+  EXPECT_EQ(HashShardingKey(""), 0xcbf29ce484222325ULL);
+  EXPECT_EQ(HashShardingKey("user_1"), HashShardingKey(std::string("user_1")));
+  EXPECT_NE(HashShardingKey("user_1"), HashShardingKey("user_2"));
+}
+
+TEST(MysqlResultsMergerTest, Concat) {
+  std::vector<MysqlResults<int>> parts(3);
+  parts[0].MutableResultSet() = {{1}, {2}};
+  parts[2].MutableResultSet() = {{3}};
+
+  auto all = MysqlResultsMerger::Concat(parts);
+  ASSERT_EQ(all.ResultSet().size(), 3);
+  EXPECT_EQ(std::get<0>(all.ResultSet()[2]), 3);
+  EXPECT_FALSE(all.IsValueNull(2, 0));
+
+  parts[0].MutableResultSet() = {{1}, {2}};
+  parts[2].MutableResultSet() = {{3}};
+  auto limited = MysqlResultsMerger::Concat(parts, 2);
+  ASSERT_EQ(limited.ResultSet().size(), 2);
+  EXPECT_EQ(std::get<0>(limited.ResultSet()[1]), 2);
+}
+
+TEST(MysqlResultsMergerTest, Merge) {
+  std::vector<MysqlResults<int, std::string>> parts(3);
+  parts[0].MutableResultSet() = {{1, "a"}, {4, "d"}, {7, "g"}};
+  parts[1].MutableResultSet() = {{2, "b"}, {5, "e"}};
+  parts[2].MutableResultSet() = {{3, "c"}, {6, "f"}, {8, "h"}};
+
+  auto less = [](const std::tuple<int, std::string>& a, const std::tuple<int, std::string>& b) {
+    return std::get<0>(a) < std::get<0>(b);
+  };
+  auto merged = MysqlResultsMerger::Merge(parts, less, 5);
+  ASSERT_EQ(merged.ResultSet().size(), 5);
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(std::get<0>(merged.ResultSet()[i]), i + 1);
+    EXPECT_EQ(std::get<1>(merged.ResultSet()[i]), std::string(1, 'a' + i));
+  }
+}
+
+TEST(MysqlResultsMergerTest, Split) {
+  MysqlResults<int, std::string> whole;
+  whole.MutableResultSet() = {{2, "b"}, {1, "a"}, {2, "c"}, {9, "z"}};
+
+  // Rows of key 9 belong to no part and are dropped.
+  auto parts = MysqlResultsMerger::Split(whole, 2, [](const std::tuple<int, std::string>& row) {
+    return static_cast<size_t>(std::get<0>(row) - 1);
+  });
+  ASSERT_EQ(parts.size(), 2);
+  ASSERT_EQ(parts[0].ResultSet().size(), 1);
+  EXPECT_EQ(std::get<1>(parts[0].ResultSet()[0]), "a");
+  ASSERT_EQ(parts[1].ResultSet().size(), 2);
+  EXPECT_EQ(std::get<1>(parts[1].ResultSet()[0]), "b");
+  EXPECT_EQ(std::get<1>(parts[1].ResultSet()[1]), "c");
+  EXPECT_FALSE(parts[1].IsValueNull(1, 1));
+}
+
+}  // namespace trpc::testing
@@ -0,0 +1,70 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#include "trpc/client/mysql/mysql_singleflight.h"
+
+namespace trpc::mysql {
+
+std::shared_ptr<MysqlSingleflight::Flight> MysqlSingleflight::Join(const std::string& key, bool& leader) {
+  std::scoped_lock _(mutex_);
+  auto [it, inserted] = flights_.try_emplace(key, nullptr);
+  leader = inserted;
+  if (inserted) {
+    it->second = std::make_shared<Flight>();
+    leaders_.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    ++it->second->followers;
+    followers_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return it->second;
+}
+
+Future<> MysqlSingleflight::Wait(const std::shared_ptr<Flight>& flight) {
+  std::scoped_lock _(flight->mutex);
+  if (flight->done) return MakeReadyFuture<>();
+
+  Promise<> promise;
+  auto future = promise.GetFuture();
+  flight->waiters.emplace_back(std::move(promise));
+  return future;
+}
+
+bool MysqlSingleflight::Land(const std::string& key, const std::shared_ptr<Flight>& flight) {
+  std::scoped_lock _(mutex_);
+  auto it = flights_.find(key);
+  if (it != flights_.end() && it->second == flight) flights_.erase(it);
+  return flight->followers > 0;
+}
+
+void MysqlSingleflight::Complete(const std::shared_ptr<Flight>& flight, std::shared_ptr<const void> results,
+                                 Status status) {
+  std::vector<Promise<>> waiters;
+  {
+    std::scoped_lock _(flight->mutex);
+    flight->results = std::move(results);
+    flight->status = std::move(status);
+    flight->done = true;
+    waiters.swap(flight->waiters);
+  }
+  // Woken out of the lock, a continuation may run inline.
+  for (auto& waiter : waiters) waiter.SetValue();
+}
+
+SingleflightStats MysqlSingleflight::GetStats() const {
+  SingleflightStats stats;
+  stats.leaders = leaders_.load(std::memory_order_relaxed);
+  stats.followers = followers_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace trpc::mysql
@@ -0,0 +1,102 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "trpc/common/status.h"
+#include "trpc/future/future.h"
+
+namespace trpc::mysql {
+
+/// @brief Counters of the coalesced reads (see SetMysqlSingleflight in mysql_context.h).
+struct SingleflightStats {
+  /// Calls which ran their query, possibly for followers.
+  uint64_t leaders{0};
+
+  /// Calls which shared the results of an identical call in flight instead of running their query.
+  uint64_t followers{0};
+};
+
+/// @brief Coalesces identical queries in flight: the first call (the leader) runs the query, the identical calls
+/// made meanwhile (the followers) wait for it and get a copy of its results.
+class MysqlSingleflight {
+ public:
+  struct Flight {
+    std::mutex mutex;
+
+    bool done{false};
+
+    /// Followers which joined the flight, final once it left the map.
+    uint32_t followers{0};
+
+    /// Copy of the MysqlResults of the leader, nullptr if the call failed or there is no follower.
+    std::shared_ptr<const void> results;
+
+    /// Status of the call of the leader.
+    Status status;
+
+    std::vector<Promise<>> waiters;
+  };
+
+  /// @brief Joins the flight of `key`, or starts it if there is none.
+  /// @param leader Set to whether the caller leads the flight, and so must `Finish` it.
+  std::shared_ptr<Flight> Join(const std::string& key, bool& leader);
+
+  /// @brief Resolved once the leader finished the flight.
+  Future<> Wait(const std::shared_ptr<Flight>& flight);
+
+  /// @brief Ends the flight of `key` and hands a copy of `res` to the followers.
+  /// @param res nullptr if the call failed, `status` tells why.
+  template <typename Results>
+  void Finish(const std::string& key, const std::shared_ptr<Flight>& flight, const Results* res, Status status);
+
+  SingleflightStats GetStats() const;
+
+ private:
+  /// @brief Removes the flight from the map, no follower joins it afterwards.
+  /// @return Whether it has followers.
+  bool Land(const std::string& key, const std::shared_ptr<Flight>& flight);
+
+  void Complete(const std::shared_ptr<Flight>& flight, std::shared_ptr<const void> results, Status status);
+
+ private:
+  std::mutex mutex_;
+
+  std::unordered_map<std::string, std::shared_ptr<Flight>> flights_;
+
+  std::atomic<uint64_t> leaders_{0};
+
+  std::atomic<uint64_t> followers_{0};
+};
+
+template <typename Results>
+void MysqlSingleflight::Finish(const std::string& key, const std::shared_ptr<Flight>& flight, const Results* res,
+                               Status status) {
+  std::shared_ptr<Results> results;
+  if (Land(key, flight) && res != nullptr) {
+    results = std::make_shared<Results>();
+    results->CopyFrom(*res);
+  }
+  Complete(flight, std::move(results), std::move(status));
+}
+
+}  // namespace trpc::mysql
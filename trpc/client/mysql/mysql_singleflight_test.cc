@@ -0,0 +1,85 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#include "trpc/client/mysql/mysql_singleflight.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "trpc/client/mysql/executor/mysql_results.h"
+
+namespace trpc::testing {
+
+using trpc::mysql::MysqlResults;
+using trpc::mysql::MysqlSingleflight;
+
+TEST(MysqlSingleflightTest, Followers) {
+  MysqlSingleflight singleflight;
+  bool leader = false;
+  auto flight = singleflight.Join("key", leader);
+  EXPECT_TRUE(leader);
+
+  bool follower_leads = true;
+  auto joined = singleflight.Join("key", follower_leads);
+  EXPECT_FALSE(follower_leads);
+  EXPECT_EQ(joined, flight);
+
+  auto waited = singleflight.Wait(joined);
+  EXPECT_FALSE(waited.IsReady());
+
+  MysqlResults<int, std::string> res;
+  res.MutableResultSet().emplace_back(1, "alice");
+  singleflight.Finish("key", flight, &res, Status());
+  EXPECT_TRUE(waited.IsReady());
+  EXPECT_TRUE(singleflight.Wait(joined).IsReady());
+
+  ASSERT_NE(joined->results, nullptr);
+  MysqlResults<int, std::string> shared;
+  shared.CopyFrom(*static_cast<const MysqlResults<int, std::string>*>(joined->results.get()));
+  ASSERT_EQ(shared.ResultSet().size(), 1);
+  EXPECT_EQ(std::get<1>(shared.ResultSet()[0]), "alice");
+
+  // The flight has landed, the next call leads a new one.
+  singleflight.Join("key", leader);
+  EXPECT_TRUE(leader);
+
+  auto stats = singleflight.GetStats();
+  EXPECT_EQ(stats.leaders, 2);
+  EXPECT_EQ(stats.followers, 1);
+}
+
+TEST(MysqlSingleflightTest, NoFollower) {
+  MysqlSingleflight singleflight;
+  bool leader = false;
+  auto flight = singleflight.Join("key", leader);
+
+  // The results are only copied for followers.
+  MysqlResults<int> res;
+  singleflight.Finish("key", flight, &res, Status());
+  EXPECT_EQ(flight->results, nullptr);
+  EXPECT_TRUE(flight->done);
+}
+
+TEST(MysqlSingleflightTest, Failure) {
+  MysqlSingleflight singleflight;
+  bool leader = false;
+  auto flight = singleflight.Join("key", leader);
+  singleflight.Join("key", leader);
+
+  singleflight.Finish<MysqlResults<int>>("key", flight, nullptr, Status(TrpcRetCode::TRPC_CLIENT_LIMITED_ERR, "x"));
+  EXPECT_EQ(flight->results, nullptr);
+  EXPECT_EQ(flight->status.GetFrameworkRetCode(), TrpcRetCode::TRPC_CLIENT_LIMITED_ERR);
+}
+
+}  // namespace trpc::testing
@@ -0,0 +1,189 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+
+#include "trpc/client/mysql/mysql_sql_fingerprint.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace trpc::mysql {
+
+namespace {
+
+bool IsWordChar(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '$' ||
+         static_cast<unsigned char>(c) >= 0x80;
+}
+
+bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+bool IsHexDigit(char c) { return IsDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F'); }
+
+bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v'; }
+
+char ToLower(char c) { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c; }
+
+/// Skips a quoted literal or identifier starting at `i`, with backslash escapes and doubled quotes.
+size_t SkipQuoted(std::string_view sql, size_t i) {
+  char quote = sql[i++];
+  while (i < sql.size()) {
+    char c = sql[i++];
+    if (c == '\\' && quote != '`') {
+      ++i;
+    } else if (c == quote) {
+      if (i < sql.size() && sql[i] == quote) {
+        ++i;
+      } else {
+        break;
+      }
+    }
+  }
+  return std::min(i, sql.size());
+}
+
+/// Skips a number starting at `i`: decimal with fraction and exponent, or hexadecimal / binary.
+size_t SkipNumber(std::string_view sql, size_t i) {
+  if (sql[i] == '0' && i + 1 < sql.size() && (sql[i + 1] == 'x' || sql[i + 1] == 'X' || sql[i + 1] == 'b')) {
+    i += 2;
+    while (i < sql.size() && IsHexDigit(sql[i])) ++i;
+    return i;
+  }
+
+  while (i < sql.size() && (IsDigit(sql[i]) || sql[i] == '.')) ++i;
+  if (i < sql.size() && (sql[i] == 'e' || sql[i] == 'E')) {
+    size_t j = i + 1;
+    if (j < sql.size() && (sql[j] == '+' || sql[j] == '-')) ++j;
+    if (j < sql.size() && IsDigit(sql[j])) {
+      i = j;
+      while (i < sql.size() && IsDigit(sql[i])) ++i;
+    }
+  }
+  return i;
+}
+
+bool EndsWithWord(const std::string& out, size_t end, std::string_view word) {
+  while (end > 0 && out[end - 1] == ' ') --end;
+  if (end < word.size() || out.compare(end - word.size(), word.size(), word) != 0) return false;
+  return end == word.size() || !IsWordChar(out[end - word.size() - 1]);
+}
+
+bool EndsWith(const std::string& out, size_t end, std::string_view suffix) {
+  return end >= suffix.size() && out.compare(end - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/// The group of `out` from `open` (a '(') to the end only holds placeholders.
+bool OnlyPlaceholders(const std::string& out, size_t open) {
+  bool any = false;
+  for (size_t i = open + 1; i < out.size(); ++i) {
+    char c = out[i];
+    if (c == '?') {
+      any = true;
+    } else if (c != ',' && c != ' ') {
+      return false;
+    }
+  }
+  return any;
+}
+
+}  // namespace
+
+std::string FingerprintSql(std::string_view sql) {
+  std::string out;
+  out.reserve(sql.size());
+
+  // Positions of the open parentheses in `out`.
+  std::vector<size_t> groups;
+  bool pending_space = false;
+
+  auto emit = [&](char c) {
+    if (pending_space && !out.empty() && out.back() != '(' && c != ',' && c != ')') out.push_back(' ');
+    pending_space = false;
+    out.push_back(c);
+  };
+
+  size_t i = 0;
+  while (i < sql.size()) {
+    char c = sql[i];
+
+    if (IsSpace(c)) {
+      pending_space = true;
+      ++i;
+    } else if (c == '/' && i + 1 < sql.size() && sql[i + 1] == '*') {
+      size_t end = sql.find("*/", i + 2);
+      i = end == std::string_view::npos ? sql.size() : end + 2;
+      pending_space = true;
+    } else if ((c == '-' && i + 2 < sql.size() && sql[i + 1] == '-' && IsSpace(sql[i + 2])) || c == '#') {
+      size_t end = sql.find('\n', i);
+      i = end == std::string_view::npos ? sql.size() : end + 1;
+      pending_space = true;
+    } else if (c == '\'' || c == '"') {
+      i = SkipQuoted(sql, i);
+      emit('?');
+    } else if (c == '`') {
+      size_t end = SkipQuoted(sql, i);
+      emit('`');
+      out.append(sql.data() + i + 1, end - i - 1);
+      i = end;
+    } else if (IsDigit(c) || (c == '.' && i + 1 < sql.size() && IsDigit(sql[i + 1]))) {
+      i = SkipNumber(sql, i);
+      emit('?');
+    } else if (IsWordChar(c)) {
+      emit(ToLower(c));
+      for (++i; i < sql.size() && IsWordChar(sql[i]); ++i) out.push_back(ToLower(sql[i]));
+    } else if (c == '(') {
+      emit('(');
+      groups.push_back(out.size() - 1);
+      ++i;
+    } else if (c == ')') {
+      pending_space = false;
+      if (groups.empty()) {
+        emit(')');
+      } else {
+        size_t open = groups.back();
+        groups.pop_back();
+        bool list = EndsWithWord(out, open, "in") || EndsWithWord(out, open, "values") ||
+                    EndsWithWord(out, open, "value") || EndsWith(out, open, "(...), ");
+        if (list && OnlyPlaceholders(out, open)) {
+          out.resize(open);
+          if (EndsWith(out, out.size(), "(...), ")) {
+            // One more row of a multi row VALUES.
+            out.resize(out.size() - 2);
+          } else {
+            out.append("(...)");
+          }
+        } else {
+          out.push_back(')');
+        }
+      }
+      ++i;
+    } else if (c == ',') {
+      emit(',');
+      pending_space = true;
+      ++i;
+    } else if (c == ';') {
+      // Trailing semicolons are dropped.
+      ++i;
+      if (sql.find_first_not_of(" \t\r\n;", i) == std::string_view::npos) break;
+      pending_space = false;
+      emit(';');
+      pending_space = true;
+    } else {
+      emit(c);
+      ++i;
+    }
+  }
+  return out;
+}
+
+}  // namespace trpc::mysql
@@ -0,0 +1,32 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace trpc::mysql {
+
+/// @brief Normalizes a SQL statement into its fingerprint, so that the statements which differ only by literals
+/// share their statistics: literals become `?`, lists of values such as `IN (1, 2, 3)` or the rows of
+/// `VALUES (?, ?), (?, ?)` collapse into `(...)`, comments are removed, and the case and the white spaces outside
+/// quoted identifiers are normalized.
+/// e.g. "SELECT * FROM t WHERE id IN (1,2, 3) AND name = 'x' -- c" gives "select * from t where id in (...) and
+/// name = ?".
+/// @note Single pass without allocation besides the result. The fingerprint never contains literals, so it can be
+/// logged.
+std::string FingerprintSql(std::string_view sql);
+
+}  // namespace trpc::mysql
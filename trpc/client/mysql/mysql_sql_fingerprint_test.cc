@@ -0,0 +1,53 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+
+#include "trpc/client/mysql/mysql_sql_fingerprint.h"
+
+#include "gtest/gtest.h"
+
+namespace trpc::testing {
+
+using trpc::mysql::FingerprintSql;
+
+TEST(MysqlSqlFingerprintTest, Literals) {
+  EXPECT_EQ(FingerprintSql("SELECT name FROM users WHERE id = 42"), "select name from users where id = ?");
+  EXPECT_EQ(FingerprintSql("select name from users where id=?"), "select name from users where id=?");
+  EXPECT_EQ(FingerprintSql("update t set a = 'it''s', b = \"x\\\"y\", c = 1.5e-3, d = 0xFF where k = -7"),
+            "update t set a = ?, b = ?, c = ?, d = ? where k = -?");
+
+  // Digits inside identifiers are kept, quoted identifiers keep their case.
+  EXPECT_EQ(FingerprintSql("select col1 from `Tbl2` where t2.x = 3"), "select col1 from `Tbl2` where t2.x = ?");
+}
+
+TEST(MysqlSqlFingerprintTest, SpacesAndComments) {
+  EXPECT_EQ(FingerprintSql("  SELECT\n\t a ,b  FROM t /* comment */ WHERE ( a = 1 ) -- tail\n ;"),
+            "select a, b from t where (a = ?)");
+  EXPECT_EQ(FingerprintSql("select /*+ MAX_EXECUTION_TIME(100) */ a from t # note"), "select a from t");
+  EXPECT_EQ(FingerprintSql("select 1; select 2;"), "select ?; select ?");
+}
+
+TEST(MysqlSqlFingerprintTest, Lists) {
+  EXPECT_EQ(FingerprintSql("SELECT * FROM t WHERE id IN (1,2, 3) AND name = 'x'"),
+            "select * from t where id in (...) and name = ?");
+  EXPECT_EQ(FingerprintSql("select * from t where id in (?)"), "select * from t where id in (...)");
+  EXPECT_EQ(FingerprintSql("insert into t (a, b) values (1, 'x'), (2, 'y'), (?, ?)"),
+            "insert into t (a, b) values (...)");
+
+  // Only lists of values collapse.
+  EXPECT_EQ(FingerprintSql("select count(1), max(a) from t where b in (select c from u)"),
+            "select count(?), max(a) from t where b in (select c from u)");
+  EXPECT_EQ(FingerprintSql("select * from t where a in (b, 1)"), "select * from t where a in (b, ?)");
+}
+
+}  // namespace trpc::testing
@@ -0,0 +1,104 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+
+#include "trpc/client/mysql/mysql_sql_stats.h"
+
+#include "trpc/util/log/logging.h"
+#include "trpc/util/time.h"
+
+#include "trpc/client/mysql/mysql_sql_fingerprint.h"
+
+namespace trpc::mysql {
+
+namespace {
+
+/// Bounds the statement texts cached for the fingerprints, e.g. texts with inline literals are all different.
+constexpr size_t kMaxQueriesPerFingerprint = 4;
+
+}  // namespace
+
+MysqlSqlStats::MysqlSqlStats(size_t max_fingerprints, uint64_t slow_query_threshold_ms,
+                             uint32_t slow_query_log_per_second)
+    : max_fingerprints_(max_fingerprints),
+      slow_query_threshold_us_(slow_query_threshold_ms * 1000),
+      slow_query_log_per_second_(slow_query_log_per_second) {}
+
+void MysqlSqlStats::OnStatement(const std::string& query, size_t arg_count, const MysqlStatementPhases& phases,
+                                int error_number) {
+  uint64_t total_us = phases.TotalUs();
+  if (max_fingerprints_ != 0) {
+    SqlFingerprintStats* stats = GetStats(query);
+    stats->latency.Record(total_us);
+    stats->prepare.Record(phases.prepare_us);
+    stats->execute.Record(phases.execute_us);
+    stats->fetch.Record(phases.fetch_us);
+    stats->decode.Record(phases.decode_us);
+    stats->rows.Record(phases.rows);
+    if (error_number != 0) stats->errors.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  if (slow_query_threshold_us_ != 0 && total_us >= slow_query_threshold_us_) {
+    slow_queries_.fetch_add(1, std::memory_order_relaxed);
+    if (SampleSlowQuery()) LogSlowQuery(query, arg_count, phases, error_number);
+  }
+}
+
+SqlFingerprintStats* MysqlSqlStats::GetStats(const std::string& query) {
+  {
+    std::shared_lock _(mutex_);
+    auto it = by_query_.find(query);
+    if (it != by_query_.end()) return it->second;
+  }
+
+  std::string fingerprint = FingerprintSql(query);
+  std::unique_lock _(mutex_);
+  auto it = by_fingerprint_.find(fingerprint);
+  if (it == by_fingerprint_.end()) {
+    if (by_fingerprint_.size() >= max_fingerprints_) fingerprint = kOtherFingerprint;
+    it = by_fingerprint_.find(fingerprint);
+    if (it == by_fingerprint_.end())
+      it = by_fingerprint_.emplace(fingerprint, std::make_unique<SqlFingerprintStats>(fingerprint)).first;
+  }
+
+  SqlFingerprintStats* stats = it->second.get();
+  if (by_query_.size() < max_fingerprints_ * kMaxQueriesPerFingerprint) by_query_.emplace(query, stats);
+  return stats;
+}
+
+const SqlFingerprintStats* MysqlSqlStats::Find(const std::string& fingerprint) const {
+  std::shared_lock _(mutex_);
+  auto it = by_fingerprint_.find(fingerprint);
+  return it != by_fingerprint_.end() ? it->second.get() : nullptr;
+}
+
+bool MysqlSqlStats::SampleSlowQuery() {
+  uint64_t second = trpc::GetSteadyMilliSeconds() / 1000;
+  uint64_t current = log_second_.load(std::memory_order_relaxed);
+  if (current != second && log_second_.compare_exchange_strong(current, second, std::memory_order_relaxed)) {
+    logged_in_second_.store(0, std::memory_order_relaxed);
+  }
+  return logged_in_second_.fetch_add(1, std::memory_order_relaxed) < slow_query_log_per_second_;
+}
+
+void MysqlSqlStats::LogSlowQuery(const std::string& query, size_t arg_count, const MysqlStatementPhases& phases,
+                                 int error_number) {
+  // The fingerprint has no literal, and the bound arguments are never logged.
+  TRPC_FMT_WARN(
+      "mysql slow query: {}us (prepare {}us, execute {}us, fetch {}us, decode {}us), rows: {}, error: {}, "
+      "args: {} redacted, sql: {}",
+      phases.TotalUs(), phases.prepare_us, phases.execute_us, phases.fetch_us, phases.decode_us, phases.rows,
+      error_number, arg_count, FingerprintSql(query));
+}
+
+}  // namespace trpc::mysql
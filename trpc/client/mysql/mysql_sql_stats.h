@@ -0,0 +1,114 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+#include "trpc/client/mysql/executor/mysql_statement_observer.h"
+#include "trpc/client/mysql/mysql_histogram.h"
+
+namespace trpc::mysql {
+
+/// @brief Statistics of the statements of one SQL fingerprint (see FingerprintSql). Durations are in microseconds.
+struct SqlFingerprintStats {
+  explicit SqlFingerprintStats(std::string fingerprint) : fingerprint(std::move(fingerprint)) {}
+
+  const std::string fingerprint;
+
+  /// Sum of the phases.
+  MysqlHistogram latency;
+
+  MysqlHistogram prepare;
+
+  MysqlHistogram execute;
+
+  MysqlHistogram fetch;
+
+  MysqlHistogram decode;
+
+  MysqlHistogram rows;
+
+  std::atomic<uint64_t> errors{0};
+};
+
+/// @brief Per fingerprint histograms of the statements of a MysqlServiceProxy (`sql_stats` in MysqlClientConf) and
+/// its slow query log (`slow_query_threshold`).
+/// @note The histograms are lock free. The fingerprints are looked up under a shared lock, by the text of the
+/// statement first so that a statement is only normalized the first time it is seen.
+class MysqlSqlStats : public MysqlStatementObserver {
+ public:
+  /// Statements beyond `max_fingerprints` distinct fingerprints are counted under this fingerprint.
+  static constexpr char kOtherFingerprint[] = "(other)";
+
+  /// @param max_fingerprints 0 disables the histograms, e.g. for the slow query log only.
+  /// @param slow_query_threshold_ms Statements taking at least this time are slow queries, 0 disables the log.
+  /// @param slow_query_log_per_second At most this number of slow queries are logged per second, the others are
+  /// only counted.
+  MysqlSqlStats(size_t max_fingerprints, uint64_t slow_query_threshold_ms, uint32_t slow_query_log_per_second);
+
+  void OnStatement(const std::string& query, size_t arg_count, const MysqlStatementPhases& phases,
+                   int error_number) override;
+
+  /// @return nullptr if no statement of `fingerprint` has run.
+  const SqlFingerprintStats* Find(const std::string& fingerprint) const;
+
+  /// @brief Calls `fn(const SqlFingerprintStats&)` for each fingerprint. Statements of new fingerprints wait meanwhile.
+  template <typename Fn>
+  void ForEach(Fn&& fn) const {
+    std::shared_lock _(mutex_);
+    for (const auto& [fingerprint, stats] : by_fingerprint_) fn(*stats);
+  }
+
+  /// @brief Statements which took at least `slow_query_threshold`, logged or not.
+  uint64_t GetSlowQueries() const { return slow_queries_.load(std::memory_order_relaxed); }
+
+ private:
+  SqlFingerprintStats* GetStats(const std::string& query);
+
+  /// @brief Takes one slot of the slow query log in the current second.
+  bool SampleSlowQuery();
+
+  void LogSlowQuery(const std::string& query, size_t arg_count, const MysqlStatementPhases& phases,
+                    int error_number);
+
+ private:
+  size_t max_fingerprints_;
+
+  uint64_t slow_query_threshold_us_;
+
+  uint32_t slow_query_log_per_second_;
+
+  mutable std::shared_mutex mutex_;
+
+  /// Statement text to its fingerprint stats, at most `kMaxQueriesPerFingerprint` times the fingerprints.
+  std::unordered_map<std::string, SqlFingerprintStats*> by_query_;
+
+  std::unordered_map<std::string, std::unique_ptr<SqlFingerprintStats>> by_fingerprint_;
+
+  std::atomic<uint64_t> slow_queries_{0};
+
+  std::atomic<uint64_t> log_second_{0};
+
+  std::atomic<uint32_t> logged_in_second_{0};
+};
+
+}  // namespace trpc::mysql
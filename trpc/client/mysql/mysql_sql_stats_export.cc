@@ -0,0 +1,100 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#include "trpc/client/mysql/mysql_sql_stats_export.h"
+
+#include <utility>
+
+#include "trpc/client/mysql/mysql_service_proxy.h"
+#include "trpc/metrics/trpc_metrics_report.h"
+
+namespace trpc::mysql {
+
+namespace {
+
+void AddHistogram(const char* name, const MysqlHistogram& histogram, rapidjson::Value& result,
+                  rapidjson::Document::AllocatorType& alloc) {
+  rapidjson::Value value(rapidjson::kObjectType);
+  value.AddMember("p50", histogram.Percentile(50), alloc);
+  value.AddMember("p99", histogram.Percentile(99), alloc);
+  value.AddMember("max", histogram.Max(), alloc);
+  result.AddMember(rapidjson::StringRef(name), value, alloc);
+}
+
+void ReportValue(const std::string& metrics_name, const std::string& service, const std::string& fingerprint,
+                 const char* name, double value) {
+  TrpcMultiAttrMetricsInfo info;
+  info.plugin_name = metrics_name;
+  info.multi_attr_info.name = "mysql_sql_stats";
+  info.multi_attr_info.tags = {{"service", service}, {"fingerprint", fingerprint}, {"name", name}};
+  info.multi_attr_info.values = {{MetricsPolicy::SET, value}};
+  metrics::MultiAttrReport(info);
+}
+
+}  // namespace
+
+void MysqlSqlStatsToJson(const MysqlSqlStats& stats, rapidjson::Value& result,
+                         rapidjson::Document::AllocatorType& alloc) {
+  result.AddMember("slow_queries", stats.GetSlowQueries(), alloc);
+
+  rapidjson::Value fingerprints(rapidjson::kArrayType);
+  stats.ForEach([&](const SqlFingerprintStats& fingerprint_stats) {
+    rapidjson::Value value(rapidjson::kObjectType);
+    value.AddMember("fingerprint", rapidjson::Value(fingerprint_stats.fingerprint.c_str(), alloc), alloc);
+    value.AddMember("count", fingerprint_stats.latency.Count(), alloc);
+    value.AddMember("errors", fingerprint_stats.errors.load(std::memory_order_relaxed), alloc);
+    AddHistogram("latency_us", fingerprint_stats.latency, value, alloc);
+    AddHistogram("prepare_us", fingerprint_stats.prepare, value, alloc);
+    AddHistogram("execute_us", fingerprint_stats.execute, value, alloc);
+    AddHistogram("fetch_us", fingerprint_stats.fetch, value, alloc);
+    AddHistogram("decode_us", fingerprint_stats.decode, value, alloc);
+    AddHistogram("rows", fingerprint_stats.rows, value, alloc);
+    fingerprints.PushBack(value, alloc);
+  });
+  result.AddMember("fingerprints", fingerprints, alloc);
+}
+
+void ReportMysqlSqlStats(const MysqlServiceProxy& proxy, const std::string& metrics_name) {
+  std::shared_ptr<MysqlSqlStats> stats = proxy.GetSqlStats();
+  if (stats == nullptr) return;
+
+  const std::string& service = proxy.GetServiceName();
+  stats->ForEach([&](const SqlFingerprintStats& fingerprint_stats) {
+    const std::string& fingerprint = fingerprint_stats.fingerprint;
+    ReportValue(metrics_name, service, fingerprint, "count", fingerprint_stats.latency.Count());
+    ReportValue(metrics_name, service, fingerprint, "errors", fingerprint_stats.errors.load(std::memory_order_relaxed));
+    ReportValue(metrics_name, service, fingerprint, "p50_us", fingerprint_stats.latency.Percentile(50));
+    ReportValue(metrics_name, service, fingerprint, "p99_us", fingerprint_stats.latency.Percentile(99));
+  });
+}
+
+MysqlSqlStatsAdminHandler::MysqlSqlStatsAdminHandler(std::shared_ptr<MysqlServiceProxy> proxy)
+    : proxy_(std::move(proxy)) {
+  description_ = "[GET /cmds/mysql/sql_stats] Per SQL fingerprint statistics of a mysql service proxy";
+}
+
+void MysqlSqlStatsAdminHandler::CommandHandle(http::HttpRequestPtr req, rapidjson::Value& result,
+                                              rapidjson::Document::AllocatorType& alloc) {
+  std::shared_ptr<MysqlSqlStats> stats = proxy_->GetSqlStats();
+  result.AddMember("service", rapidjson::Value(proxy_->GetServiceName().c_str(), alloc), alloc);
+  if (stats == nullptr) {
+    result.AddMember("errorcode", -1, alloc);
+    result.AddMember("message", "sql_stats and slow_query_threshold are disabled", alloc);
+    return;
+  }
+
+  result.AddMember("errorcode", 0, alloc);
+  MysqlSqlStatsToJson(*stats, result, alloc);
+}
+
+}  // namespace trpc::mysql
@@ -0,0 +1,50 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "rapidjson/document.h"
+
+#include "trpc/admin/admin_handler.h"
+#include "trpc/client/mysql/mysql_sql_stats.h"
+
+namespace trpc::mysql {
+
+class MysqlServiceProxy;
+
+/// @brief Writes the statistics of each fingerprint into `result`: count, errors, p50, p99 and max of the latency
+/// and of each phase in microseconds, and of the rows.
+void MysqlSqlStatsToJson(const MysqlSqlStats& stats, rapidjson::Value& result,
+                         rapidjson::Document::AllocatorType& alloc);
+
+/// @brief Reports the count, errors, p50 and p99 latency of each fingerprint to the metrics plugin `metrics_name`,
+/// tagged with the service name and the fingerprint. Call it periodically, e.g. from a timer of the application.
+void ReportMysqlSqlStats(const MysqlServiceProxy& proxy, const std::string& metrics_name);
+
+/// @brief Admin command listing the SQL statistics of a MysqlServiceProxy, e.g.
+/// `TrpcApp::RegisterCmd(http::OperationType::GET, "/cmds/mysql/sql_stats", handler)`.
+class MysqlSqlStatsAdminHandler : public AdminHandlerBase {
+ public:
+  explicit MysqlSqlStatsAdminHandler(std::shared_ptr<MysqlServiceProxy> proxy);
+
+  void CommandHandle(http::HttpRequestPtr req, rapidjson::Value& result,
+                     rapidjson::Document::AllocatorType& alloc) override;
+
+ private:
+  std::shared_ptr<MysqlServiceProxy> proxy_;
+};
+
+}  // namespace trpc::mysql
@@ -0,0 +1,84 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#include "trpc/client/mysql/mysql_sql_stats.h"
+
+#include "gtest/gtest.h"
+
+namespace trpc::testing {
+
+using trpc::mysql::MysqlSqlStats;
+using trpc::mysql::MysqlStatementPhases;
+using trpc::mysql::SqlFingerprintStats;
+
+namespace {
+
+MysqlStatementPhases MakePhases(uint64_t execute_us, uint64_t rows) {
+  MysqlStatementPhases phases;
+  phases.prepare_us = 1;
+  phases.execute_us = execute_us;
+  phases.fetch_us = 2;
+  phases.decode_us = 3;
+  phases.rows = rows;
+  return phases;
+}
+
+}  // namespace
+
+TEST(MysqlSqlStatsTest, Fingerprints) {
+  MysqlSqlStats stats(10, 0, 0);
+  stats.OnStatement("SELECT * FROM users WHERE id = 1", 0, MakePhases(100, 1), 0);
+  stats.OnStatement("SELECT * FROM users WHERE id = 2", 0, MakePhases(200, 1), 0);
+  stats.OnStatement("select * from users where id = ?", 1, MakePhases(300, 0), 1146);
+
+  const SqlFingerprintStats* found = stats.Find("select * from users where id = ?");
+  ASSERT_NE(found, nullptr);
+  EXPECT_EQ(found->latency.Count(), 3);
+  EXPECT_EQ(found->errors.load(), 1);
+  EXPECT_EQ(found->prepare.Max(), 1);
+  EXPECT_EQ(found->execute.Max(), 300);
+  EXPECT_EQ(found->rows.Sum(), 2);
+  EXPECT_EQ(found->latency.Sum(), 100 + 200 + 300 + 3 * 6);
+  EXPECT_EQ(stats.GetSlowQueries(), 0);
+}
+
+TEST(MysqlSqlStatsTest, Overflow) {
+  MysqlSqlStats stats(2, 0, 0);
+  stats.OnStatement("SELECT a FROM t", 0, MakePhases(10, 1), 0);
+  stats.OnStatement("SELECT b FROM t", 0, MakePhases(10, 1), 0);
+  stats.OnStatement("SELECT c FROM t", 0, MakePhases(10, 1), 0);
+  stats.OnStatement("SELECT d FROM t", 0, MakePhases(10, 1), 0);
+  stats.OnStatement("SELECT a FROM t", 0, MakePhases(10, 1), 0);
+
+  size_t fingerprints = 0;
+  stats.ForEach([&](const SqlFingerprintStats&) { ++fingerprints; });
+  EXPECT_EQ(fingerprints, 3);
+  EXPECT_EQ(stats.Find("select a from t")->latency.Count(), 2);
+  EXPECT_EQ(stats.Find("select c from t"), nullptr);
+  EXPECT_EQ(stats.Find(MysqlSqlStats::kOtherFingerprint)->latency.Count(), 2);
+}
+
+TEST(MysqlSqlStatsTest, SlowQueries) {
+  // Slow query log only.
+  MysqlSqlStats stats(0, 1, 1);
+  stats.OnStatement("SELECT SLEEP(1)", 0, MakePhases(990, 1), 0);
+  stats.OnStatement("SELECT SLEEP(1)", 0, MakePhases(994, 1), 0);
+  stats.OnStatement("SELECT SLEEP(1)", 0, MakePhases(5000, 1), 0);
+  EXPECT_EQ(stats.GetSlowQueries(), 2);
+
+  size_t fingerprints = 0;
+  stats.ForEach([&](const SqlFingerprintStats&) { ++fingerprints; });
+  EXPECT_EQ(fingerprints, 0);
+}
+
+}  // namespace trpc::testing
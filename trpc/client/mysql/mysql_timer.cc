@@ -0,0 +1,91 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#include "trpc/client/mysql/mysql_timer.h"
+
+#include <chrono>
+
+#include "trpc/util/time.h"
+
+namespace trpc::mysql {
+
+MysqlTimer::~MysqlTimer() { Stop(); }
+
+void MysqlTimer::Start() {
+  std::scoped_lock _(mutex_);
+  if (!stopped_) return;
+  stopped_ = false;
+  thread_ = std::thread([this]() { Run(); });
+}
+
+void MysqlTimer::Stop() {
+  {
+    std::scoped_lock _(mutex_);
+    stopped_ = true;
+    tasks_.clear();
+    deadlines_.clear();
+  }
+  cond_.notify_all();
+  if (thread_.joinable()) thread_.join();
+}
+
+uint64_t MysqlTimer::Add(uint64_t delay_ms, Function<void()>&& fn) {
+  uint64_t deadline = trpc::GetSteadyMilliSeconds() + delay_ms;
+  bool earliest = false;
+  uint64_t id = 0;
+  {
+    std::scoped_lock _(mutex_);
+    if (stopped_) return 0;
+    id = next_id_++;
+    earliest = tasks_.empty() || deadline < tasks_.begin()->first.first;
+    tasks_.emplace(std::make_pair(deadline, id), std::move(fn));
+    deadlines_.emplace(id, deadline);
+  }
+  if (earliest) cond_.notify_one();
+  return id;
+}
+
+bool MysqlTimer::Cancel(uint64_t id) {
+  std::scoped_lock _(mutex_);
+  auto it = deadlines_.find(id);
+  if (it == deadlines_.end()) return false;
+  tasks_.erase(std::make_pair(it->second, id));
+  deadlines_.erase(it);
+  return true;
+}
+
+void MysqlTimer::Run() {
+  std::unique_lock lock(mutex_);
+  while (!stopped_) {
+    if (tasks_.empty()) {
+      cond_.wait(lock);
+      continue;
+    }
+
+    auto it = tasks_.begin();
+    uint64_t now = trpc::GetSteadyMilliSeconds();
+    if (it->first.first > now) {
+      cond_.wait_for(lock, std::chrono::milliseconds(it->first.first - now));
+      continue;
+    }
+
+    Function<void()> fn = std::move(it->second);
+    deadlines_.erase(it->first.second);
+    tasks_.erase(it);
+    lock.unlock();
+    fn();
+    lock.lock();
+  }
+}
+
+}  // namespace trpc::mysql
@@ -0,0 +1,67 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#include "trpc/util/function.h"
+
+namespace trpc::mysql {
+
+/// @brief One thread running delayed callbacks for a MysqlServiceProxy (e.g. the hedge of a slow read).
+/// @note Callbacks run on the timer thread and must not block, post blocking work to the executing workers.
+class MysqlTimer {
+ public:
+  ~MysqlTimer();
+
+  void Start();
+
+  /// @brief Stops the thread. Pending callbacks are dropped without running.
+  void Stop();
+
+  /// @brief Runs `fn` after `delay_ms` milliseconds.
+  /// @return Id for `Cancel`, 0 if the timer is not running (`fn` is dropped).
+  uint64_t Add(uint64_t delay_ms, Function<void()>&& fn);
+
+  /// @return false if the callback has already run (or is running) or has been cancelled.
+  bool Cancel(uint64_t id);
+
+ private:
+  void Run();
+
+ private:
+  std::mutex mutex_;
+
+  std::condition_variable cond_;
+
+  bool stopped_{true};
+
+  uint64_t next_id_{1};
+
+  /// Keyed by (deadline in steady milliseconds, id).
+  std::map<std::pair<uint64_t, uint64_t>, Function<void()>> tasks_;
+
+  /// id -> deadline, for Cancel.
+  std::unordered_map<uint64_t, uint64_t> deadlines_;
+
+  std::thread thread_;
+};
+
+}  // namespace trpc::mysql
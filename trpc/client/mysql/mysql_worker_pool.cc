@@ -0,0 +1,64 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#include "trpc/client/mysql/mysql_worker_pool.h"
+
+#include <utility>
+
+#include "trpc/util/thread/latch.h"
+
+namespace trpc::mysql {
+
+namespace {
+
+ThreadPoolOption MakeThreadPoolOption(uint32_t thread_num, bool bind_core) {
+  ThreadPoolOption option;
+  option.thread_num = thread_num;
+  option.bind_core = bind_core;
+  return option;
+}
+
+}  // namespace
+
+MysqlWorkerPool::MysqlWorkerPool(uint32_t thread_num, bool bind_core)
+    : thread_pool_(MakeThreadPoolOption(thread_num, bind_core)) {}
+
+MysqlWorkerPool::AddResult MysqlWorkerPool::AddTask(Function<void()>& task) {
+  // Pairs with Retire: either the task sees `retired_`, or Retire sees it in `adding_` and waits for it.
+  adding_.fetch_add(1, std::memory_order_seq_cst);
+  AddResult result = AddResult::kRetired;
+  if (!retired_.load(std::memory_order_seq_cst))
+    result = thread_pool_.AddTask(std::move(task)) ? AddResult::kAdded : AddResult::kRejected;
+
+  if (adding_.fetch_sub(1, std::memory_order_seq_cst) == 1 && retired_.load(std::memory_order_seq_cst)) {
+    std::scoped_lock _(mutex_);
+    cond_.notify_all();
+  }
+  return result;
+}
+
+void MysqlWorkerPool::Retire() {
+  retired_.store(true, std::memory_order_seq_cst);
+  {
+    std::unique_lock lock(mutex_);
+    cond_.wait(lock, [this]() { return adding_.load(std::memory_order_seq_cst) == 0; });
+  }
+
+  // The tasks queued before this one have been taken by the workers once it runs. Stop joins the running ones.
+  Latch drained(1);
+  if (thread_pool_.AddTask([&drained]() { drained.count_down(); })) drained.wait();
+  thread_pool_.Stop();
+  thread_pool_.Join();
+}
+
+}  // namespace trpc::mysql
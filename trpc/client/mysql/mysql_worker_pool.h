@@ -0,0 +1,70 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+#include "trpc/util/function.h"
+#include "trpc/util/thread/thread_pool.h"
+
+namespace trpc::mysql {
+
+/// @brief The worker threads which run the blocking MySQL tasks in "thread_pool" execute mode. Unlike a bare
+/// ThreadPool it can be retired while callers still post to it (see Retire), e.g. when a reload replaces it.
+class MysqlWorkerPool {
+ public:
+  enum class AddResult {
+    kAdded,
+
+    /// Refused by the thread pool, e.g. its queue is full or it is stopped.
+    kRejected,
+
+    /// The pool is retired, the task should go to the pool which replaced it.
+    kRetired,
+  };
+
+  MysqlWorkerPool(uint32_t thread_num, bool bind_core);
+
+  bool Start() { return thread_pool_.Start(); }
+
+  /// @brief Queues `task`. It is left untouched if the result is kRetired.
+  AddResult AddTask(Function<void()>& task);
+
+  /// @brief Refuses the tasks added from now on, waits for the AddTask calls in progress, runs the queued tasks and
+  /// joins the workers. No task added successfully is dropped.
+  void Retire();
+
+  /// @brief Stops the workers at once, the queued tasks are dropped.
+  void Stop() { thread_pool_.Stop(); }
+
+  void Join() { thread_pool_.Join(); }
+
+ private:
+  ThreadPool thread_pool_;
+
+  /// AddTask calls in progress.
+  std::atomic<uint32_t> adding_{0};
+
+  std::atomic<bool> retired_{false};
+
+  /// Wakes Retire once `adding_` drops to 0.
+  std::mutex mutex_;
+
+  std::condition_variable cond_;
+};
+
+}  // namespace trpc::mysql
@@ -0,0 +1,74 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#include "trpc/client/mysql/mysql_worker_pool.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace trpc::testing {
+
+using trpc::mysql::MysqlWorkerPool;
+
+TEST(MysqlWorkerPoolTest, RetireRunsQueuedTasks) {
+  MysqlWorkerPool pool(1, false);
+  ASSERT_TRUE(pool.Start());
+
+  std::atomic<int> ran{0};
+  for (int i = 0; i < 100; ++i) {
+    Function<void()> task = [&ran]() { ran.fetch_add(1); };
+    EXPECT_EQ(pool.AddTask(task), MysqlWorkerPool::AddResult::kAdded);
+  }
+  pool.Retire();
+  EXPECT_EQ(ran.load(), 100);
+}
+
+TEST(MysqlWorkerPoolTest, RetiredPoolKeepsTheTask) {
+  MysqlWorkerPool pool(1, false);
+  ASSERT_TRUE(pool.Start());
+  pool.Retire();
+
+  bool ran = false;
+  Function<void()> task = [&ran]() { ran = true; };
+  EXPECT_EQ(pool.AddTask(task), MysqlWorkerPool::AddResult::kRetired);
+  // Left to the caller, e.g. for the pool which replaced this one.
+  ASSERT_TRUE(task);
+  task();
+  EXPECT_TRUE(ran);
+}
+
+TEST(MysqlWorkerPoolTest, RetireWhilePosting) {
+  MysqlWorkerPool pool(2, false);
+  ASSERT_TRUE(pool.Start());
+
+  std::atomic<int> added{0};
+  std::atomic<int> ran{0};
+  std::vector<std::thread> posters;
+  for (int i = 0; i < 4; ++i) {
+    posters.emplace_back([&]() {
+      for (int j = 0; j < 1000; ++j) {
+        Function<void()> task = [&ran]() { ran.fetch_add(1); };
+        if (pool.AddTask(task) == MysqlWorkerPool::AddResult::kAdded) added.fetch_add(1);
+      }
+    });
+  }
+  pool.Retire();
+  for (auto& poster : posters) poster.join();
+  // Every task accepted has run, none was dropped by the stop.
+  EXPECT_EQ(ran.load(), added.load());
+}
+
+}  // namespace trpc::testing
@@ -0,0 +1,89 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#pragma once
+
+#include <string>
+
+#include "trpc/util/string_util.h"
+
+#include "trpc/client/mysql/mysql_service_proxy.h"
+
+namespace trpc::mysql {
+
+/// @brief RAII nested scope in a transaction, which maps to a savepoint.
+///
+///  The savepoint is set when the scope is created. `Release` keeps the work done in the scope, `Rollback` undoes
+///  only that work, and the transaction goes on in both cases. A scope which is destructed without either is rolled
+///  back, so a failed step can be redone without redoing the whole transaction. Scopes can be nested.
+///
+/// @code
+///  SavepointScope scope(proxy.get(), ctx, handle);
+///  if (!scope.GetStatus().OK()) return;
+///  Status s = proxy->Execute(ctx, handle, res, "insert into ...");
+///  if (s.OK()) scope.Release();  // Otherwise only the insert is rolled back.
+/// @endcode
+class SavepointScope {
+ public:
+  SavepointScope(MysqlServiceProxy* proxy, const ClientContextPtr& context, const TxHandlePtr& handle)
+      : proxy_(proxy), context_(context), handle_(handle) {
+    name_ = util::FormatString("trpc_scope_{}", handle_->GetSavepoints().size());
+    status_ = proxy_->Savepoint(context_, handle_, name_);
+    active_ = status_.OK();
+  }
+
+  ~SavepointScope() {
+    if (active_) Rollback();
+  }
+
+  SavepointScope(const SavepointScope&) = delete;
+
+  SavepointScope& operator=(const SavepointScope&) = delete;
+
+  /// @brief The status of setting the savepoint. The scope does nothing if it is not OK.
+  const Status& GetStatus() const { return status_; }
+
+  const std::string& GetName() const { return name_; }
+
+  /// @brief Keeps the work of the scope in the transaction.
+  Status Release() {
+    if (!active_) return status_;
+    active_ = false;
+    return proxy_->Release(context_, handle_, name_);
+  }
+
+  /// @brief Undoes the work of the scope. The rest of the transaction is kept.
+  Status Rollback() {
+    if (!active_) return status_;
+    active_ = false;
+
+    // Nothing to undo if the transaction itself has ended.
+    if (handle_->GetState() != TransactionHandle::TxState::kStarted || !handle_->HasSavepoint(name_)) return status_;
+
+    // The context may still carry the error which made the scope fail.
+    context_->SetStatus(Status());
+    Status s = proxy_->RollbackTo(context_, handle_, name_);
+    if (!s.OK()) return s;
+    return proxy_->Release(context_, handle_, name_);
+  }
+
+ private:
+  MysqlServiceProxy* proxy_;
+  ClientContextPtr context_;
+  TxHandlePtr handle_;
+  std::string name_;
+  Status status_;
+  bool active_{false};
+};
+
+}  // namespace trpc::mysql
@@ -13,7 +13,19 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mysqlclient/mysqld_error.h"
+
+#include "trpc/util/function.h"
+
 #include "trpc/client/mysql/executor/mysql_executor.h"
+#include "trpc/client/mysql/mysql_executor_pool.h"
+#include "trpc/client/mysql/transaction_watchdog.h"
 
 namespace trpc::mysql {
 
@@ -27,36 +39,43 @@ class TransactionHandle : public RefCounted<TransactionHandle> {
   TransactionHandle() : executor_(nullptr) {}
 
   TransactionHandle& operator=(TransactionHandle&& other) noexcept {
-    state_ = other.state_;
-    executor_ = std::move(other.executor_);
-    other.state_ = TxState::kInValid;
-    other.executor_ = nullptr;
+    MoveFrom(other);
     return *this;
   }
 
-  TransactionHandle(TransactionHandle&& other) noexcept {
-    state_ = other.state_;
-    executor_ = std::move(other.executor_);
-    other.state_ = TxState::kInValid;
-    other.executor_ = nullptr;
-  }
+  TransactionHandle(TransactionHandle&& other) noexcept { MoveFrom(other); }
 
   TransactionHandle& operator=(const TransactionHandle& other) = delete;
 
   TransactionHandle(const TransactionHandle& other) = delete;
 
   ~TransactionHandle() {
+    // Unregister first, so the watchdog no longer touches the handle.
+    if (watchdog_) watchdog_->Remove(this);
+
     // usually executor_ would be nullptr(be reclaimed)
     if (executor_) {
-      TRPC_FMT_ERROR("TransactionHandle destructed but executor is not reclaimed.");
-      executor_->Close();
+      if (pool_ != nullptr) {
+        // The transaction is abandoned. Reclaim resets the session (which rolls back the transaction on the server)
+        // and keeps the connection in the pool. The reset is a round trip, so it runs on the MySQL workers rather
+        // than on the thread dropping the handle, which may be a reactor or fiber worker.
+        TRPC_FMT_WARN("TransactionHandle destructed but executor is not reclaimed, recycle it.");
+        RefPtr<MysqlExecutor> executor = std::move(executor_);
+        executor->MarkSessionDirty();
+        bool posted = reclaim_poster_ &&
+                      reclaim_poster_([pool = pool_, executor]() mutable { pool->Reclaim(0, std::move(executor)); });
+        if (!posted) executor->Close();
+      } else {
+        TRPC_FMT_ERROR("TransactionHandle destructed but executor is not reclaimed.");
+        executor_->Close();
+      }
     }
     state_ = TxState::kInValid;
   }
 
-  void SetState(TxState state) { state_ = state; }
+  void SetState(TxState state) { state_.store(state, std::memory_order_release); }
 
-  TxState GetState() { return state_; }
+  TxState GetState() { return state_.load(std::memory_order_acquire); }
 
   bool SetExecutor(RefPtr<MysqlExecutor>&& executor) {
     if (executor_) return false;
@@ -68,10 +87,139 @@ class TransactionHandle : public RefCounted<TransactionHandle> {
 
   RefPtr<MysqlExecutor>&& TransferExecutor() { return std::move(executor_); }
 
+  /// @brief The pool which the executor comes from, kept alive by the handle. The executor is returned to it when
+  /// the transaction ends, even if the pool manager has been rebuilt meanwhile.
+  void SetPool(std::shared_ptr<MysqlExecutorPool> pool) { pool_ = std::move(pool); }
+
+  const std::shared_ptr<MysqlExecutorPool>& GetPool() const { return pool_; }
+
+  /// @brief Posts a blocking task to the MySQL workers, used to reclaim the executor if the handle is destructed
+  /// without commit or rollback. It returns false if the task could not be posted, the connection is closed then.
+  void SetReclaimPoster(Function<bool(Function<void()>&&)>&& poster) { reclaim_poster_ = std::move(poster); }
+
+  /// @brief Savepoints of the transaction, from the oldest to the latest.
+  const std::vector<std::string>& GetSavepoints() const { return savepoints_; }
+
+  bool HasSavepoint(const std::string& name) const {
+    return std::find(savepoints_.begin(), savepoints_.end(), name) != savepoints_.end();
+  }
+
+  /// @brief Same as the server, setting an existing savepoint moves it to the latest.
+  void AddSavepoint(const std::string& name) {
+    savepoints_.erase(std::remove(savepoints_.begin(), savepoints_.end(), name), savepoints_.end());
+    savepoints_.push_back(name);
+  }
+
+  /// @brief Removes the savepoints set after `name`, and `name` itself if `inclusive`.
+  /// "ROLLBACK TO SAVEPOINT" keeps `name` while "RELEASE SAVEPOINT" removes it.
+  void RemoveSavepointsAfter(const std::string& name, bool inclusive) {
+    auto it = std::find(savepoints_.begin(), savepoints_.end(), name);
+    if (it == savepoints_.end()) return;
+    savepoints_.erase(inclusive ? it : it + 1, savepoints_.end());
+  }
+
+  void ClearSavepoints() { savepoints_.clear(); }
+
+  /// @brief Tables written in the transaction, whose cached results are invalidated when it commits (see
+  /// MysqlResultCache).
+  void AddWrittenTables(const std::vector<std::string>& tables) {
+    written_tables_.insert(written_tables_.end(), tables.begin(), tables.end());
+  }
+
+  std::vector<std::string> TakeWrittenTables() { return std::move(written_tables_); }
+
+  /// @brief Marks the transaction begun now and lets `watchdog` roll it back once it expires.
+  void SetWatchdog(std::shared_ptr<TransactionWatchdog> watchdog) {
+    uint64_t now = trpc::GetSteadyMilliSeconds();
+    begin_ms_.store(now, std::memory_order_relaxed);
+    last_active_ms_.store(now, std::memory_order_relaxed);
+    if (watchdog_) watchdog_->Remove(this);
+    watchdog_ = std::move(watchdog);
+    if (watchdog_) watchdog_->Add(this);
+  }
+
+  /// @brief Claims the handle for a statement, so the watchdog leaves it alone until `ReleaseUse`.
+  /// @return false if the handle is claimed by someone else (another statement or the watchdog).
+  bool TryAcquire() {
+    bool expected = false;
+    return in_use_.compare_exchange_strong(expected, true, std::memory_order_acq_rel);
+  }
+
+  /// @brief Ends the claim of `TryAcquire` and restarts the idle time.
+  void ReleaseUse() {
+    last_active_ms_.store(trpc::GetSteadyMilliSeconds(), std::memory_order_relaxed);
+    in_use_.store(false, std::memory_order_release);
+  }
+
+  uint64_t GetBeginTime() const { return begin_ms_.load(std::memory_order_relaxed); }
+
+  uint64_t GetLastActiveTime() const { return last_active_ms_.load(std::memory_order_relaxed); }
+
+ private:
+  void MoveFrom(TransactionHandle& other) {
+    state_.store(other.state_.load());
+    executor_ = std::move(other.executor_);
+    pool_ = std::move(other.pool_);
+    reclaim_poster_ = std::move(other.reclaim_poster_);
+    savepoints_ = std::move(other.savepoints_);
+    written_tables_ = std::move(other.written_tables_);
+    begin_ms_.store(other.begin_ms_.load());
+    last_active_ms_.store(other.last_active_ms_.load());
+    auto watchdog = std::move(other.watchdog_);
+    if (watchdog) watchdog->Remove(&other);
+    if (watchdog_) watchdog_->Remove(this);
+    watchdog_ = std::move(watchdog);
+    if (watchdog_) watchdog_->Add(this);
+    other.state_.store(TxState::kInValid);
+    other.executor_ = nullptr;
+    other.pool_ = nullptr;
+  }
+
  private:
   RefPtr<MysqlExecutor> executor_{nullptr};
-  TxState state_{TxState::kNotInited};
+  std::shared_ptr<MysqlExecutorPool> pool_{nullptr};
+  Function<bool(Function<void()>&&)> reclaim_poster_{nullptr};
+  std::atomic<TxState> state_{TxState::kNotInited};
+  std::vector<std::string> savepoints_;
+  std::vector<std::string> written_tables_;
+  std::shared_ptr<TransactionWatchdog> watchdog_;
+  std::atomic<bool> in_use_{false};
+  std::atomic<uint64_t> begin_ms_{0};
+  std::atomic<uint64_t> last_active_ms_{0};
 };
 
 using TxHandlePtr = RefPtr<TransactionHandle>;
+
+/// @brief Retry policy of MysqlServiceProxy::RunInTransaction.
+struct TransactionRetryPolicy {
+  /// Max number of reruns after the first attempt. 0 disables retrying.
+  uint32_t max_retries{3};
+
+  /// The backoff before the n-th retry (from 0) is a random value in [d / 2, d],
+  /// where d = min(max_backoff_ms, base_backoff_ms * 2^n).
+  uint32_t base_backoff_ms{10};
+
+  uint32_t max_backoff_ms{500};
+
+  /// MySQL error numbers on which the transaction is rolled back and rerun.
+  std::vector<int> retryable_errors{ER_LOCK_DEADLOCK, ER_LOCK_WAIT_TIMEOUT};
+};
+
+/// @brief Counters of MysqlServiceProxy::RunInTransaction.
+struct TransactionRetryStats {
+  /// Transactions started by RunInTransaction.
+  uint64_t transactions{0};
+
+  /// Reruns of all transactions.
+  uint64_t retries{0};
+
+  /// Reruns caused by ER_LOCK_DEADLOCK.
+  uint64_t deadlock_retries{0};
+
+  /// Reruns caused by ER_LOCK_WAIT_TIMEOUT.
+  uint64_t lock_wait_retries{0};
+
+  /// Transactions which failed with a retryable error, but ran out of retries or of the context timeout.
+  uint64_t exhausted{0};
+};
 }  // namespace trpc::mysql
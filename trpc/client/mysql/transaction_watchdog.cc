@@ -0,0 +1,134 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#include "trpc/client/mysql/transaction_watchdog.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "trpc/util/log/logging.h"
+#include "trpc/util/time.h"
+
+#include "trpc/client/mysql/transaction.h"
+
+namespace trpc::mysql {
+
+constexpr uint64_t kMinSweepIntervalMs = 10;
+constexpr uint64_t kMaxSweepIntervalMs = 1000;
+
+TransactionWatchdog::TransactionWatchdog(uint64_t idle_timeout_ms, uint64_t max_duration_ms)
+    : idle_timeout_ms_(idle_timeout_ms), max_duration_ms_(max_duration_ms) {}
+
+TransactionWatchdog::~TransactionWatchdog() { Stop(); }
+
+void TransactionWatchdog::Start() {
+  if (idle_timeout_ms_ == 0 && max_duration_ms_ == 0) return;
+
+  std::scoped_lock _(run_mutex_);
+  if (!stopped_) return;
+  stopped_ = false;
+  sweep_thread_ = std::thread([this]() { Run(); });
+}
+
+void TransactionWatchdog::Stop() {
+  {
+    std::scoped_lock _(run_mutex_);
+    stopped_ = true;
+  }
+  run_cond_.notify_all();
+  if (sweep_thread_.joinable()) sweep_thread_.join();
+}
+
+void TransactionWatchdog::Add(TransactionHandle* handle) {
+  std::scoped_lock _(handles_mutex_);
+  handles_.insert(handle);
+}
+
+void TransactionWatchdog::Remove(TransactionHandle* handle) {
+  std::scoped_lock _(handles_mutex_);
+  handles_.erase(handle);
+}
+
+size_t TransactionWatchdog::Sweep() {
+  std::vector<std::pair<RefPtr<MysqlExecutor>, std::shared_ptr<MysqlExecutorPool>>> expired;
+  uint64_t now = trpc::GetSteadyMilliSeconds();
+
+  {
+    // A handle unregisters itself under this lock in its destructor, so it stays valid while the lock is held.
+    std::scoped_lock _(handles_mutex_);
+    for (auto it = handles_.begin(); it != handles_.end();) {
+      TransactionHandle* handle = *it;
+
+      // The transaction has been committed or rolled back by the user.
+      if (handle->GetState() != TransactionHandle::TxState::kStarted) {
+        it = handles_.erase(it);
+        continue;
+      }
+
+      bool too_long = max_duration_ms_ > 0 && now - handle->GetBeginTime() >= max_duration_ms_;
+      bool idle = idle_timeout_ms_ > 0 && now - handle->GetLastActiveTime() >= idle_timeout_ms_;
+
+      // Skip the handles which are executing a statement.
+      if ((!too_long && !idle) || !handle->TryAcquire()) {
+        ++it;
+        continue;
+      }
+
+      // Check again, the transaction may have ended before the handle was claimed.
+      if (handle->GetState() == TransactionHandle::TxState::kStarted) {
+        if (handle->GetExecutor() != nullptr) expired.emplace_back(handle->TransferExecutor(), handle->GetPool());
+        handle->SetState(TransactionHandle::TxState::kInValid);
+        (too_long ? duration_rollbacks_ : idle_rollbacks_).fetch_add(1, std::memory_order_relaxed);
+      }
+      handle->ReleaseUse();
+      it = handles_.erase(it);
+    }
+  }
+
+  // Network I/O is done out of the lock, on the sweep thread. Resetting the session rolls back the transaction.
+  for (auto& [executor, pool] : expired) {
+    TRPC_FMT_WARN("Transaction on {}:{} expired, roll it back.", executor->GetIp(), executor->GetPort());
+    executor->MarkSessionDirty();
+    if (pool != nullptr) {
+      pool->Reclaim(0, std::move(executor));
+    } else {
+      executor->Close();
+    }
+  }
+
+  return expired.size();
+}
+
+TransactionWatchdogStats TransactionWatchdog::GetStats() const {
+  TransactionWatchdogStats stats;
+  stats.idle_rollbacks = idle_rollbacks_.load(std::memory_order_relaxed);
+  stats.duration_rollbacks = duration_rollbacks_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void TransactionWatchdog::Run() {
+  uint64_t shortest = std::min(idle_timeout_ms_ == 0 ? max_duration_ms_ : idle_timeout_ms_,
+                               max_duration_ms_ == 0 ? idle_timeout_ms_ : max_duration_ms_);
+  auto interval = std::chrono::milliseconds(std::clamp(shortest / 4, kMinSweepIntervalMs, kMaxSweepIntervalMs));
+
+  std::unique_lock lock(run_mutex_);
+  while (!run_cond_.wait_for(lock, interval, [this]() { return stopped_; })) {
+    lock.unlock();
+    Sweep();
+    lock.lock();
+  }
+}
+
+}  // namespace trpc::mysql
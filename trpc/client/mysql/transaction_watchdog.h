@@ -0,0 +1,88 @@
+//
+//
+// Tencent is pleased to support the open source community by making tRPC available.
+//
+// Copyright (C) 2024 THL A29 Limited, a Tencent company.
+// All rights reserved.
+//
+// If you have downloaded a copy of the tRPC source code from Tencent,
+// please note that tRPC source code is licensed under the GNU General Public License Version 2.0 (GPLv2),
+// A copy of the GPLv2 is included in this file.
+//
+//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+namespace trpc::mysql {
+
+class TransactionHandle;
+
+/// @brief Counters of the transactions rolled back by TransactionWatchdog.
+struct TransactionWatchdogStats {
+  /// Rolled back because no statement was executed within the idle timeout.
+  uint64_t idle_rollbacks{0};
+
+  /// Rolled back because the transaction lasted longer than the max duration.
+  uint64_t duration_rollbacks{0};
+};
+
+/// @brief Tracks the started transactions of a MysqlServiceProxy. A background sweep rolls back the transactions
+/// which are idle or last too long, reclaims their executors to the pool and marks the handles invalid.
+/// @note Handles register themselves (see TransactionHandle::SetWatchdog) and unregister when destructed. They hold
+/// the watchdog, so one replaced by a reload keeps sweeping the transactions begun with it until they are released.
+class TransactionWatchdog {
+ public:
+  /// @param idle_timeout_ms 0 means no idle timeout.
+  /// @param max_duration_ms 0 means no max duration.
+  TransactionWatchdog(uint64_t idle_timeout_ms, uint64_t max_duration_ms);
+
+  ~TransactionWatchdog();
+
+  /// @brief Starts the background sweep. Does nothing if both timeouts are 0.
+  void Start();
+
+  void Stop();
+
+  void Add(TransactionHandle* handle);
+
+  void Remove(TransactionHandle* handle);
+
+  /// @brief Rolls back and reclaims the expired transactions. Handles in use by a statement are skipped.
+  /// @return Number of connections reclaimed.
+  size_t Sweep();
+
+  TransactionWatchdogStats GetStats() const;
+
+ private:
+  void Run();
+
+ private:
+  uint64_t idle_timeout_ms_;
+
+  uint64_t max_duration_ms_;
+
+  std::mutex handles_mutex_;
+
+  std::unordered_set<TransactionHandle*> handles_;
+
+  std::mutex run_mutex_;
+
+  std::condition_variable run_cond_;
+
+  bool stopped_{true};
+
+  std::thread sweep_thread_;
+
+  std::atomic<uint64_t> idle_rollbacks_{0};
+
+  std::atomic<uint64_t> duration_rollbacks_{0};
+};
+
+}  // namespace trpc::mysql